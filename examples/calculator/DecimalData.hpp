@@ -2,6 +2,9 @@
 
 #include <QtNodes/NodeData>
 
+#include <functional>
+#include <string>
+
 using QtNodes::NodeData;
 using QtNodes::NodeDataType;
 
@@ -18,10 +21,27 @@ public:
         : _number(number)
     {}
 
-    NodeDataType type() const override { return NodeDataType{"decimal", "Decimal"}; }
+    NodeDataType type() const override
+    {
+        static NodeDataType const dataType = NodeDataType::interned("decimal", "Decimal");
+        return dataType;
+    }
 
     double number() const { return _number; }
 
+    /// Equal numbers are interchangeable, the graph model may skip them.
+    std::size_t contentHash() const override
+    {
+        static std::size_t const typeHash = std::hash<std::string>()("decimal");
+        return std::hash<double>()(_number) ^ typeHash;
+    }
+
+    bool sameContent(NodeData const &other) const override
+    {
+        auto decimal = dynamic_cast<DecimalData const *>(&other);
+        return decimal && decimal->_number == _number;
+    }
+
     QString numberAsText() const { return QString::number(_number, 'f'); }
 
 private:
@@ -111,6 +111,7 @@ int main(int argc, char *argv[])
     QVBoxLayout *l = new QVBoxLayout(&mainWidget);
 
     DataFlowGraphModel dataFlowGraphModel(registry);
+    dataFlowGraphModel.setMemoizationEnabled(true);
 
     l->addWidget(menuBar);
     auto scene = new DataFlowGraphicsScene(dataFlowGraphModel, &mainWidget);
@@ -18,13 +18,21 @@ using QtNodes::PortType;
 class MyNodeData : public NodeData
 {
 public:
-    NodeDataType type() const override { return NodeDataType{"MyNodeData", "My Node Data"}; }
+    NodeDataType type() const override
+    {
+        static NodeDataType const dataType = NodeDataType::interned("MyNodeData", "My Node Data");
+        return dataType;
+    }
 };
 
 class SimpleNodeData : public NodeData
 {
 public:
-    NodeDataType type() const override { return NodeDataType{"SimpleData", "Simple Data"}; }
+    NodeDataType type() const override
+    {
+        static NodeDataType const dataType = NodeDataType::interned("SimpleData", "Simple Data");
+        return dataType;
+    }
 };
 
 //------------------------------------------------------------------------------
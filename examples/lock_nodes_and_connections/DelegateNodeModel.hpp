@@ -16,7 +16,11 @@ using QtNodes::PortType;
 class SimpleNodeData : public NodeData
 {
 public:
-    NodeDataType type() const override { return NodeDataType{"SimpleData", "Simple Data"}; }
+    NodeDataType type() const override
+    {
+        static NodeDataType const dataType = NodeDataType::interned("SimpleData", "Simple Data");
+        return dataType;
+    }
 };
 
 /// The model dictates the number of inputs and outputs for the Node.
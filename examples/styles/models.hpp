@@ -18,7 +18,11 @@ using QtNodes::PortType;
 class MyNodeData : public NodeData
 {
 public:
-    NodeDataType type() const override { return NodeDataType{"MyNodeData", "My Node Data"}; }
+    NodeDataType type() const override
+    {
+        static NodeDataType const dataType = NodeDataType::interned("MyNodeData", "My Node Data");
+        return dataType;
+    }
 };
 
 //------------------------------------------------------------------------------
@@ -16,7 +16,11 @@ public:
         : _text(text)
     {}
 
-    NodeDataType type() const override { return NodeDataType{"text", "Text"}; }
+    NodeDataType type() const override
+    {
+        static NodeDataType const dataType = NodeDataType::interned("text", "Text");
+        return dataType;
+    }
 
     QString text() const { return _text; }
 
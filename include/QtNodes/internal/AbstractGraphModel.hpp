@@ -2,18 +2,26 @@
 
 #include "Export.hpp"
 
+#include <functional>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <QtCore/QJsonObject>
 #include <QtCore/QObject>
+#include <QtCore/QPointF>
 #include <QtCore/QVariant>
 
 #include "ConnectionIdHash.hpp"
 #include "Definitions.hpp"
+#include "GraphChangeSet.hpp"
+#include "NodeRenderInfo.hpp"
 
 namespace QtNodes {
 
+class NodeStyle;
+
 /**
  * The central class in the Model-View approach. It delivers all kinds
  * of information from the backing user data structures that represent
@@ -55,6 +63,50 @@ public:
                                                          PortIndex index) const
         = 0;
 
+    /// Callable invoked by the `forEach...` traversal functions.
+    using NodeVisitor = std::function<void(NodeId const)>;
+
+    using ConnectionVisitor = std::function<void(ConnectionId const &)>;
+
+    /// @brief Visits all the Node Ids without building a temporary set.
+    /**
+   * The default implementation iterates over the result of `allNodeIds()`.
+   * Reimplement the function if the model can walk its own storage.
+   *
+   * The visitor must not add or remove nodes.
+   */
+    virtual void forEachNode(NodeVisitor const &visitor) const;
+
+    /// @brief Visits all input and output connections of the given `nodeId`.
+    /**
+   * The default implementation iterates over the result of
+   * `allConnectionIds(nodeId)`.
+   *
+   * The visitor must not add or remove connections.
+   */
+    virtual void forEachNodeConnection(NodeId const nodeId, ConnectionVisitor const &visitor) const;
+
+    /// @brief Visits the connections attached to the given port.
+    /**
+   * The default implementation iterates over the result of
+   * `connections(nodeId, portType, index)`.
+   *
+   * The visitor must not add or remove connections.
+   */
+    virtual void forEachConnection(NodeId const nodeId,
+                                   PortType const portType,
+                                   PortIndex const index,
+                                   ConnectionVisitor const &visitor) const;
+
+    /// Number of connections attached to the given port.
+    /**
+   * The default implementation returns the size of
+   * `connections(nodeId, portType, index)`.
+   */
+    virtual std::size_t connectionCount(NodeId const nodeId,
+                                        PortType const portType,
+                                        PortIndex const index) const;
+
     /// Checks if two nodes with the given `connectionId` are connected.
     virtual bool connectionExists(ConnectionId const connectionId) const = 0;
 
@@ -111,6 +163,24 @@ public:
         return nodeData(nodeId, role).value<T>();
     }
 
+    /// @returns the style of `nodeId` as used by the painters.
+    /**
+   * The returned instance is immutable and may be shared by many nodes. The
+   * default implementation parses the Json of `NodeRole::Style` on every
+   * call. Reimplement it to hand out a cached instance instead, e.g. the one
+   * from `StyleCollection::sharedNodeStyle()`. `NodeRole::Style` is still
+   * used for persistence.
+   */
+    virtual std::shared_ptr<NodeStyle const> nodeStyle(NodeId nodeId) const;
+
+    /// @returns in a single call the node data needed for painting and layout.
+    /**
+   * The default implementation collects the individual NodeRole and
+   * PortRole values. Reimplement it to fill the structure straight from the
+   * model data, without going through QVariant.
+   */
+    virtual NodeRenderInfo nodeRenderInfo(NodeId nodeId) const;
+
     virtual NodeFlags nodeFlags(NodeId nodeId) const
     {
         Q_UNUSED(nodeId);
@@ -125,6 +195,14 @@ public:
    */
     virtual bool setNodeData(NodeId nodeId, NodeRole role, QVariant value) = 0;
 
+    /// @brief Moves all the `nodeIds` by `offset`.
+    /**
+   * The default implementation reads and writes `NodeRole::Position` of
+   * every node, one `nodePositionUpdated` signal per node. Reimplement it to
+   * update the positions in place and emit a single `nodePositionsUpdated`.
+   */
+    virtual void moveNodes(std::vector<NodeId> const &nodeIds, QPointF const &offset);
+
     /// @brief Returns port-related data for requested NodeRole.
     /**
    * @returns Port Data Type, Port Data, Connection Policy, Port
@@ -184,7 +262,47 @@ public:
    */
     virtual void loadNode(QJsonObject const &) {}
 
-    virtual void setNodeExecType(NodeId,NodeExecType)const {}
+    virtual void setNodeExecType(NodeId, NodeExecType) {}
+
+    /// Whether a step execution started by `setNodeExecType()` is running.
+    virtual bool hasNodeExec() const { return false; }
+
+public:
+    /// @brief Starts grouping the changes of the model into one change set.
+    /**
+   * Until the matching `endBatch()`, the change signals are still emitted
+   * but BasicGraphicsScene ignores them. The outermost `endBatch()` emits
+   * `batchCommitted()` with the coalesced changes of the whole batch, so
+   * that the scene is updated and notified once. Batches may be nested.
+   *
+   * @see BatchGuard
+   */
+    void beginBatch();
+
+    void endBatch();
+
+    /// @returns `true` between `beginBatch()` and the matching `endBatch()`.
+    bool inBatch() const { return _batchDepth > 0; }
+
+    /// Runs a batch for the lifetime of the guard.
+    class BatchGuard
+    {
+    public:
+        explicit BatchGuard(AbstractGraphModel &model)
+            : _model(model)
+        {
+            _model.beginBatch();
+        }
+
+        ~BatchGuard() { _model.endBatch(); }
+
+        BatchGuard(BatchGuard const &) = delete;
+
+        BatchGuard &operator=(BatchGuard const &) = delete;
+
+    private:
+        AbstractGraphModel &_model;
+    };
 
 public:
     /**
@@ -242,10 +360,30 @@ Q_SIGNALS:
 
     void nodePositionUpdated(NodeId const nodeId);
 
+    /// Emitted once for all the nodes moved together by `moveNodes()`.
+    void nodePositionsUpdated(std::vector<NodeId> const &nodeIds);
+
     void modelReset();
 
+    /// Emitted by the outermost `endBatch()`, unless nothing has changed.
+    void batchCommitted(GraphChangeSet const &changes);
+
+protected:
+    /**
+   * Called by the outermost `endBatch()` after `batchCommitted()`. Derived
+   * models may apply here the work they deferred during the batch.
+   */
+    virtual void batchEnded() {}
+
 private:
     std::vector<ConnectionId> _shiftedByDynamicPortsConnections;
+
+    int _batchDepth = 0;
+
+    GraphChangeSet _batchChanges;
+
+    /// Connections recording the change signals into `_batchChanges`.
+    std::vector<QMetaObject::Connection> _batchRecorders;
 };
 
 } // namespace QtNodes
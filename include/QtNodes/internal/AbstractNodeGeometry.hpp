@@ -72,6 +72,15 @@ public:
 
     virtual QRect resizeHandleRect(NodeId const nodeId) const = 0;
 
+    /**
+   * Drops whatever the geometry computed and kept for the node. The scene
+   * calls it when the node is updated or deleted. Does nothing by default.
+   */
+    virtual void invalidate(NodeId const nodeId) const { Q_UNUSED(nodeId); }
+
+    /// Drops the data kept for all the nodes, see `invalidate()`.
+    virtual void invalidateAll() const {}
+
 protected:
     AbstractGraphModel &_graphModel;
 };
@@ -8,6 +8,7 @@
 #include <memory>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include "AbstractGraphModel.hpp"
 #include "AbstractNodeGeometry.hpp"
@@ -23,9 +24,14 @@ namespace QtNodes {
 
 class AbstractGraphModel;
 class AbstractNodePainter;
+class DefaultFlowControlNodePainter;
 class ConnectionGraphicsObject;
 class NodeGraphicsObject;
 class NodeStyle;
+class UndoPayloadStore;
+
+template<typename Key>
+class SpatialGridIndex;
 
 /// An instance of QGraphicsScene, holds connections and nodes.
 class NODE_EDITOR_PUBLIC BasicGraphicsScene : public QGraphicsScene
@@ -51,10 +57,48 @@ public:
 
     void setNodePainter(std::unique_ptr<AbstractNodePainter> newPainter);
 
+    /// Painter of the nodes whose NodeRole::PaintType is `PaintType_FLOWCONTROL`.
+    DefaultFlowControlNodePainter &flowControlNodePainter();
+
+    void setFlowControlNodePainter(std::unique_ptr<DefaultFlowControlNodePainter> newPainter);
+
     QUndoStack &undoStack();
+
+    /// Node payloads shared by the commands of `undoStack()`.
+    std::shared_ptr<UndoPayloadStore> const &undoPayloadStore() const;
+
+    /**
+   * Limits the memory kept by the commands of `undoStack()`. The default
+   * value `0` means no limit.
+   *
+   * When a change exceeds the budget, the oldest node payloads are first
+   * moved to a temporary file, if `setUndoSpillEnabled(true)` was called.
+   * The oldest commands are then removed from the bottom of the stack until
+   * the budget is met. The most recent done command is always kept. Only a
+   * stack holding SceneUndoCommand instances alone can be trimmed.
+   */
+    void setUndoMemoryBudget(std::size_t bytes);
+
+    std::size_t undoMemoryBudget() const { return _undoMemoryBudget; }
+
+    void setUndoSpillEnabled(bool enabled);
+
+    bool undoSpillEnabled() const;
+
+    /// Estimated bytes kept in memory by the undo history.
+    /**
+   * The sum of `SceneUndoCommand::memoryUsage()` over the stack and of the
+   * resident payloads of `undoPayloadStore()`. Spilled payloads and the heap
+   * bookkeeping of Qt and of the allocator are not included, so the actual
+   * footprint is somewhat higher. Other commands count as
+   * `sizeof(QUndoCommand)`. The value is maintained incrementally.
+   */
+    std::size_t undoMemoryUsage() const;
     //set exec Type
     void setNodeExecType(const NodeId nodeId,NodeExecType nType);
 
+    bool hasNodeExec() const;
+
 public:
     /// Creates a "draft" instance of ConnectionGraphicsObject.
     /**
@@ -91,6 +135,60 @@ public:
    */
     ConnectionGraphicsObject *connectionGraphicsObject(ConnectionId connectionId);
 
+    /// @returns the topmost node whose shape contains `scenePoint`.
+    /**
+   * The lookup goes through the scene spatial index and does not depend on
+   * the total number of items. @returns `nullptr` when there is no node.
+   */
+    NodeGraphicsObject *nodeAt(QPointF const &scenePoint);
+
+    /// @returns the nodes whose bounding rectangles intersect `sceneRect`.
+    std::vector<NodeGraphicsObject *> nodesIn(QRectF const &sceneRect);
+
+    /// @returns the topmost connection whose shape contains `scenePoint`.
+    /**
+   * Uses the same spatial index as `nodeAt()`. The draft connection is not
+   * indexed. @returns `nullptr` when there is no connection.
+   */
+    ConnectionGraphicsObject *connectionAt(QPointF const &scenePoint);
+
+    /// @returns the connections whose bounding rectangles intersect `sceneRect`.
+    std::vector<ConnectionGraphicsObject *> connectionsIn(QRectF const &sceneRect);
+
+    /// Selects the nodes and connections whose shapes intersect `sceneArea`.
+    /**
+   * Replaces the current selection or, with `Qt::AddToSelection`, extends
+   * it. Candidates come from the spatial index, so the cost depends on the
+   * number of items close to `sceneArea` rather than on the scene size.
+   * `selectionChanged()` is emitted once, and only when something changed.
+   */
+    void selectItemsIn(QPainterPath const &sceneArea,
+                       Qt::ItemSelectionOperation operation = Qt::ReplaceSelection);
+
+    /// Refreshes the spatial index entry of `nodeId`.
+    /**
+   * Positions and sizes coming from the AbstractGraphModel are tracked
+   * automatically. The function is needed when a NodeGraphicsObject changes
+   * its geometry by itself, e.g. while being resized.
+   */
+    void updateNodeIndex(NodeId const nodeId);
+
+    /// Refreshes the spatial index entry of `connectionId`.
+    /**
+   * Called by ConnectionGraphicsObject whenever its end points move.
+   */
+    void updateConnectionIndex(ConnectionId const connectionId);
+
+    /// Moves the selected nodes by `offset` during an interactive drag.
+    /**
+   * Only the graphics items follow the pointer while the gesture lasts. The
+   * model and the spatial index are updated once, by `finishNodeDrag()`.
+   */
+    void dragSelectedNodes(QPointF const &offset);
+
+    /// Commits the current drag, if any, as a single MoveNodeCommand.
+    void finishNodeDrag();
+
     Qt::Orientation orientation() const { return _orientation; }
 
     void setOrientation(Qt::Orientation const orientation);
@@ -136,6 +234,24 @@ private:
     /// Redraws adjacent nodes for given `connectionId`
     void updateAttachedNodes(ConnectionId const connectionId, PortType const portType);
 
+    /// Updates the running total of the command bytes, then the budget.
+    void onUndoIndexChanged(int const index);
+
+    /// Spills payloads and trims the oldest commands above the undo budget.
+    void enforceUndoMemoryBudget();
+
+    // Graphics object bookkeeping shared by the per-item slots and
+    // `onBatchCommitted()`, without the `modified` signal.
+
+    void removeConnectionObject(ConnectionId const connectionId);
+
+    void createConnectionObject(ConnectionId const connectionId);
+
+    /// @returns `false` when the scene had no object for `nodeId`.
+    bool removeNodeObject(NodeId const nodeId);
+
+    void createNodeObject(NodeId const nodeId);
+
 public Q_SLOTS:
     /// Slot called when the `connectionId` is erased form the AbstractGraphModel.
     void onConnectionDeleted(ConnectionId const connectionId);
@@ -149,10 +265,15 @@ public Q_SLOTS:
 
     void onNodePositionUpdated(NodeId const nodeId);
 
+    void onNodePositionsUpdated(std::vector<NodeId> const &nodeIds);
+
     void onNodeUpdated(NodeId const nodeId);
 
     void onNodeClicked(NodeId const nodeId);
 
+    /// Applies the changes of an AbstractGraphModel batch, then emits `modified` once.
+    void onBatchCommitted(GraphChangeSet const &changes);
+
     void onModelReset();
 
 private:
@@ -168,14 +289,41 @@ private:
 
     std::unique_ptr<ConnectionGraphicsObject> _draftConnection;
 
+    std::unique_ptr<SpatialGridIndex<NodeId>> _nodeIndex;
+
+    std::unique_ptr<SpatialGridIndex<ConnectionId>> _connectionIndex;
+
     std::unique_ptr<AbstractNodeGeometry> _nodeGeometry;
 
     std::unique_ptr<AbstractNodePainter> _nodePainter;
 
+    std::unique_ptr<DefaultFlowControlNodePainter> _flowControlPainter;
+
     bool _nodeDrag;
 
+    /// Nodes of the drag in progress, empty between gestures.
+    std::vector<NodeId> _draggedNodes;
+
+    /// Offset accumulated by the drag in progress.
+    QPointF _dragOffset;
+
     QUndoStack *_undoStack;
 
+    std::shared_ptr<UndoPayloadStore> _undoPayloadStore;
+
+    std::size_t _undoMemoryBudget = 0;
+
+    bool _trimmingUndoHistory = false;
+
+    /// `memoryUsage()` of every command on the undo stack, in stack order.
+    std::vector<std::size_t> _undoCommandSizes;
+
+    /// Sum of `_undoCommandSizes`.
+    std::size_t _undoCommandBytes = 0;
+
+    /// Index of the undo stack when `_undoCommandSizes` was last updated.
+    int _accountedUndoIndex = 0;
+
     Qt::Orientation _orientation;
 };
 
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace QtNodes {
+
+/// Cooperative cancellation flag shared by a graph model and a computation.
+/**
+ * Copies of a token share the same state. The graph model cancels the token
+ * of an asynchronous computation when the node receives new input or is
+ * deleted; the computation is expected to poll `isCancelled()` and return
+ * early. All the functions are thread-safe.
+ */
+class CancellationToken
+{
+public:
+    CancellationToken()
+        : _state(std::make_shared<State>())
+    {}
+
+    bool isCancelled() const { return _state->cancelled.load(std::memory_order_acquire); }
+
+    /// Sets the flag and runs the registered callbacks, once.
+    void cancel() const
+    {
+        std::vector<std::function<void()>> callbacks;
+
+        {
+            std::lock_guard<std::mutex> lock(_state->mutex);
+
+            if (_state->cancelled.exchange(true, std::memory_order_acq_rel))
+                return;
+
+            callbacks.swap(_state->callbacks);
+        }
+
+        for (auto const &callback : callbacks) {
+            callback();
+        }
+    }
+
+    /**
+   * Registers `callback` to be invoked on the thread calling `cancel()`.
+   * When the token is already cancelled the callback runs immediately.
+   * Useful to wake up a computation waiting on something else than the
+   * flag, e.g. to resume a suspended coroutine.
+   */
+    void onCancelled(std::function<void()> callback) const
+    {
+        {
+            std::lock_guard<std::mutex> lock(_state->mutex);
+
+            if (!_state->cancelled.load(std::memory_order_acquire)) {
+                _state->callbacks.push_back(std::move(callback));
+                return;
+            }
+        }
+
+        callback();
+    }
+
+private:
+    struct State
+    {
+        std::atomic<bool> cancelled{false};
+        std::mutex mutex;
+        std::vector<std::function<void()>> callbacks;
+    };
+
+    std::shared_ptr<State> _state;
+};
+
+} // namespace QtNodes
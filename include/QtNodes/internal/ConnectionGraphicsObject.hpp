@@ -3,6 +3,7 @@
 #include <utility>
 
 #include <QtCore/QUuid>
+#include <QtGui/QPainterPath>
 #include <QtWidgets/QGraphicsObject>
 
 #include "ConnectionState.hpp"
@@ -49,6 +50,13 @@ public:
 
     std::pair<QPointF, QPointF> pointsC1C2() const;
 
+    /// Cubic spline from the out end point to the in end point.
+    /**
+   * The path, the shape and the bounding rect are computed on demand and
+   * kept until one of the end points changes.
+   */
+    QPainterPath const &path() const;
+
     void setEndPoint(PortType portType, QPointF const &point);
 
     /// Updates the position of both ends
@@ -82,6 +90,9 @@ private:
 
     std::pair<QPointF, QPointF> pointsC1C2Vertical() const;
 
+    /// Marks the cached path, shape and bounding rect as outdated.
+    void invalidateGeometry();
+
 private:
     ConnectionId _connectionId;
 
@@ -91,6 +102,13 @@ private:
 
     mutable QPointF _out;
     mutable QPointF _in;
+
+    mutable QPainterPath _path;
+    mutable QPainterPath _shape;
+    mutable QRectF _boundingRect;
+
+    mutable bool _pathValid;
+    mutable bool _shapeValid;
 };
 
 } // namespace QtNodes
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <QtCore/QHash>
 #include <QtGui/QColor>
 
+#include <vector>
+
 #include "Export.hpp"
+#include "NodeData.hpp"
 #include "Style.hpp"
 
 namespace QtNodes {
@@ -27,7 +31,33 @@ public:
 public:
     QColor constructionColor() const;
     QColor normalColor() const;
-    QColor normalColor(QString typeId) const;
+
+    /// Color of the connections and ports carrying `typeId`.
+    /**
+   * Colors pinned with "DataTypeColors" or `setDataTypeColor()` take
+   * precedence. Other types get a color derived from the id. Either way the
+   * color is resolved once per type and then read from a table.
+   */
+    QColor normalColor(QString const &typeId) const;
+
+    /// Same as above, looked up by `NodeDataType::handle()` when the type has one.
+    QColor normalColor(NodeDataType const &dataType) const;
+
+    /// Index of `typeId` in the color table, valid for this style instance.
+    int dataTypeColorIndex(QString const &typeId) const;
+
+    /// Table lookup for an index returned by `dataTypeColorIndex()`.
+    QColor const &dataTypeColor(int index) const;
+
+    /// Pins the color used for `typeId`, for themes.
+    /**
+   * An invalid color unpins it, the type falls back to its derived color.
+   */
+    void setDataTypeColor(QString const &typeId, QColor const &color);
+
+    /// Colors pinned by the style, keyed by type id.
+    QHash<QString, QColor> const &dataTypeColors() const;
+
     QColor selectedColor() const;
     QColor selectedHaloColor() const;
     QColor hoveredColor() const;
@@ -36,6 +66,9 @@ public:
     float constructionLineWidth() const;
     float pointDiameter() const;
 
+    /// Below this level of detail connections are drawn as straight lines.
+    float simplifiedLevelOfDetail() const;
+
     bool useDataDefinedColors() const;
 
 private:
@@ -49,6 +82,17 @@ private:
     float ConstructionLineWidth;
     float PointDiameter;
 
+    float SimplifiedLevelOfDetail = 0.3f;
+
     bool UseDataDefinedColors;
+
+    QHash<QString, QColor> DataTypeColors;
+
+    /// Resolved colors, filled on demand by `dataTypeColorIndex()`.
+    mutable QHash<QString, int> _dataTypeColorIndices;
+    mutable std::vector<QColor> _dataTypeColorTable;
+
+    /// Color table index per NodeDataTypeHandle, -1 until resolved.
+    mutable std::vector<int> _dataTypeHandleColorIndices;
 };
 } // namespace QtNodes
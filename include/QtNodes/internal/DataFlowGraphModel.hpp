@@ -1,19 +1,29 @@
 #pragma once
 
 #include "AbstractGraphModel.hpp"
+#include "CancellationToken.hpp"
 #include "ConnectionIdUtils.hpp"
 #include "NodeDelegateModelRegistry.hpp"
+#include "NodeSlotArray.hpp"
 #include "Serializable.hpp"
 #include "StyleCollection.hpp"
 
 #include "Export.hpp"
 
+#include <QByteArray>
 #include <QJsonObject>
 
+#include <cstdint>
 #include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace QtNodes {
 
+class WorkStealingThreadPool;
+
 class NODE_EDITOR_PUBLIC DataFlowGraphModel : public AbstractGraphModel, public Serializable
 {
     Q_OBJECT
@@ -25,11 +35,56 @@ public:
         QPointF pos;
     };
 
+    /// Strategy used to propagate `NodeDelegateModel::dataUpdated` downstream.
+    enum class ExecutionMode {
+        /// Every update is pushed recursively to the connected inputs. A node
+        /// fed by several updated inputs is evaluated once per input.
+        Push,
+        /// Updates requesting continued execution are collected and the affected
+        /// subgraph is evaluated in topological order, each node exactly once
+        /// after all of its inputs have settled.
+        Topological,
+        /// Same ordering as `Topological`, but nodes whose
+        /// `NodeDelegateModel::computeIsThreadSafe()` returns `true` are
+        /// evaluated on a pool of worker threads as soon as they are ready.
+        Parallel,
+    };
+
 public:
     DataFlowGraphModel(std::shared_ptr<NodeDelegateModelRegistry> registry);
 
+    ~DataFlowGraphModel() override;
+
     std::shared_ptr<NodeDelegateModelRegistry> dataModelRegistry() { return _registry; }
 
+    /// Selects the propagation strategy. `ExecutionMode::Push` is the default.
+    void setExecutionMode(ExecutionMode mode) { _executionMode = mode; }
+
+    ExecutionMode executionMode() const { return _executionMode; }
+
+    /**
+   * Number of worker threads used by `ExecutionMode::Parallel`. The default
+   * value `0` selects `std::thread::hardware_concurrency()`. The workers are
+   * created lazily and replaced only while none of them is busy.
+   */
+    void setWorkerCount(std::size_t count);
+
+    std::size_t workerCount() const { return _workerCount; }
+
+    /**
+   * When enabled, data identical to the previous delivery on an input port
+   * (same `NodeData::version()`, or equal non-zero `NodeData::contentHash()`
+   * confirmed by `NodeData::sameContent()`) is not passed to `setInData()`
+   * again. The node keeps its current outputs
+   * and nothing is propagated further downstream.
+   *
+   * Disabled by default: models that modify their output data in place have
+   * to call `NodeData::bumpVersion()` before enabling it.
+   */
+    void setMemoizationEnabled(bool enabled);
+
+    bool memoizationEnabled() const { return _memoizationEnabled; }
+
 public:
     std::unordered_set<NodeId> allNodeIds() const override;
 
@@ -39,6 +94,20 @@ public:
                                                  PortType portType,
                                                  PortIndex portIndex) const override;
 
+    void forEachNode(NodeVisitor const &visitor) const override;
+
+    void forEachNodeConnection(NodeId const nodeId,
+                               ConnectionVisitor const &visitor) const override;
+
+    void forEachConnection(NodeId const nodeId,
+                           PortType const portType,
+                           PortIndex const portIndex,
+                           ConnectionVisitor const &visitor) const override;
+
+    std::size_t connectionCount(NodeId const nodeId,
+                                PortType const portType,
+                                PortIndex const portIndex) const override;
+
     bool connectionExists(ConnectionId const connectionId) const override;
 
     NodeId addNode(QString const nodeType) override;
@@ -51,10 +120,18 @@ public:
 
     QVariant nodeData(NodeId nodeId, NodeRole role) const override;
 
+    /// Hands out `StyleCollection::sharedNodeStyle()`, without a Json round-trip.
+    std::shared_ptr<NodeStyle const> nodeStyle(NodeId nodeId) const override;
+
+    NodeRenderInfo nodeRenderInfo(NodeId nodeId) const override;
+
     NodeFlags nodeFlags(NodeId nodeId) const override;
 
     bool setNodeData(NodeId nodeId, NodeRole role, QVariant value) override;
 
+    /// Updates the positions in place and emits one `nodePositionsUpdated`.
+    void moveNodes(std::vector<NodeId> const &nodeIds, QPointF const &offset) override;
+
     QVariant portData(NodeId nodeId,
                       PortType portType,
                       PortIndex portIndex,
@@ -76,8 +153,40 @@ public:
 
     void loadNode(QJsonObject const &nodeJson) override;
 
+    /**
+   * Restores the graph in bulk: no per-item `nodeCreated`,
+   * `connectionCreated` or `nodePositionUpdated` signals are emitted and no
+   * data is propagated while the nodes and connections are inserted. A single
+   * `modelReset` follows, then the outputs are propagated once in topological
+   * order.
+   */
     void load(QJsonObject const &json) override;
-    void setNodeExecType(NodeId nodeId,NodeExecType nType)const override;
+
+    /**
+   * Compact, versioned alternative to `save()`.
+   *
+   * The stream starts with a magic number and a format version. It then holds
+   * a table of interned model names, a node table (id, name index, position
+   * and an opaque payload blob with the rest of `NodeDelegateModel::save()`),
+   * and a connection table.
+   */
+    QByteArray saveBinary() const;
+
+    /**
+   * Restores a graph written by `saveBinary()`.
+   *
+   * @returns `false` without modifying the graph when `data` is not in the
+   * binary format, has an unsupported version or encoding, is corrupted, or
+   * holds node ids already used by the graph. Throws `std::logic_error` for
+   * unknown model names, like `load()`, also before modifying the graph.
+   */
+    bool loadBinary(QByteArray const &data);
+
+    /// Checks whether `data` starts like the output of `saveBinary()`.
+    static bool isBinaryFormat(QByteArray const &data);
+    void setNodeExecType(NodeId nodeId, NodeExecType nType) override;
+
+    bool hasNodeExec() const override;
 
     /**
    * Fetches the NodeDelegateModel for the given `nodeId` and tries to cast the
@@ -86,11 +195,11 @@ public:
     template<typename NodeDelegateModelType>
     NodeDelegateModelType *delegateModel(NodeId const nodeId)
     {
-        auto it = _models.find(nodeId);
-        if (it == _models.end())
+        NodeSlot const *slot = _nodes.find(nodeId);
+        if (!slot)
             return nullptr;
 
-        auto model = dynamic_cast<NodeDelegateModelType *>(it->second.get());
+        auto model = dynamic_cast<NodeDelegateModelType *>(slot->model.get());
 
         return model;
     }
@@ -100,14 +209,132 @@ Q_SIGNALS:
     //compute export
     void computingStarted(NodeId const);
     void computingFinished(NodeId const nodeId,int nErr, const QString &strResult);
+    //step execution
+    void sgnDataFlowBegin(NodeId const nodeId);
+    void sgnDataFlowFinished(NodeId const nodeId);
 
 private:
     NodeId newNodeId() override { return _nextNodeId++; }
 
+    void beginBulkLoad();
+
+    /// Leaves the bulk mode, emits `modelReset` and propagates the loaded data.
+    void endBulkLoad();
+
+    /// Delivers the data carried by `connections`, upstream nodes first.
+    void propagateConnections(std::vector<ConnectionId> const &connections);
+
+    /// Propagates the data of the connections added during the batch.
+    void batchEnded() override;
+
+    /// Creates the delegate model of a node read from JSON or binary data.
+    void restoreNode(NodeId const restoredNodeId,
+                     QPointF const &pos,
+                     QJsonObject const &internalDataJson);
+
+    /// Stores `model` as the node `nodeId`, placed at `pos`.
+    void insertNode(NodeId const nodeId,
+                    std::unique_ptr<NodeDelegateModel> model,
+                    QPointF const &pos = QPointF());
+
+    int nodeTypeHandle(QString const &typeName);
+
+    NodeDelegateModel *findModel(NodeId const nodeId) const;
+
     void sendConnectionCreation(ConnectionId const connectionId);
 
     void sendConnectionDeletion(ConnectionId const connectionId);
 
+    /// Registers `connectionId` in the per-node and per-port adjacency indices.
+    void indexConnection(ConnectionId const connectionId);
+
+    /// Removes `connectionId` from the per-node and per-port adjacency indices.
+    void unindexConnection(ConnectionId const connectionId);
+
+    /// Routes `NodeDelegateModel::dataUpdated` according to the execution mode.
+    void onNodeDataUpdated(NodeId const nodeId, PortIndex const portIndex, bool bContinue);
+
+    void schedulePass();
+
+    /**
+   * Starts evaluating the nodes downstream of `_dirtyOutPorts` in topological
+   * order.
+   *
+   * The inputs gathered for a node are delivered with `bContinueExec` set only
+   * for the last one, so a model computes once per pass. Updates emitted by a
+   * node during its own turn are propagated in the same pass, later ones are
+   * left for the next pass.
+   */
+    void runPass();
+
+    /// Starts every ready node and finishes the pass once nothing is left.
+    void advancePass();
+
+    /// Delivers the gathered inputs to `nodeId`, possibly on a worker thread.
+    void startNode(NodeId const nodeId);
+
+    /// Forwards the updated outputs of `nodeId` and releases its downstream.
+    void settleNode(NodeId const nodeId);
+
+    /// Counts `connectionId` as delivered for its receiving node in the pass.
+    void releaseDownstream(ConnectionId const &connectionId);
+
+    /// Called on the model thread when a worker has finished with `nodeId`.
+    void onWorkerFinished(NodeId const nodeId,
+                          std::vector<PortIndex> const &inPorts,
+                          std::vector<PortIndex> const &emittedPorts);
+
+    void finishPass();
+
+    WorkStealingThreadPool &threadPool();
+
+    /**
+   * Runs `NodeDelegateModel::computeAsync()` for `nodeId` on the thread pool
+   * and supersedes the previous run of the node.
+   *
+   * @returns the generation of the new run, or `0` when the model has nothing
+   * to compute.
+   */
+    std::uint64_t launchAsyncCompute(NodeId const nodeId, NodeDelegateModel *model);
+
+    /**
+   * Remembers `data` as the latest input of the given port.
+   *
+   * @returns `false` when memoization is enabled and the same data has
+   * already been delivered to the port.
+   */
+    bool recordInput(NodeId const nodeId,
+                     PortIndex const portIndex,
+                     std::shared_ptr<NodeData> const &data);
+
+    /**
+   * Converts `data` to the type of the input port of `connectionId` through
+   * `NodeDelegateModelRegistry::getTypeConverter()`. The data is returned as
+   * is when both ports have the same type or no conversion is registered.
+   *
+   * A converted value stays referenced by the model until the next
+   * conversion on the same connection.
+   */
+    std::shared_ptr<NodeData> const &convertedData(ConnectionId const &connectionId,
+                                                   std::shared_ptr<NodeData> const &data);
+
+    /**
+   * Hands `data` to an input port, the common path of propagation and of
+   * `setPortData(..., PortRole::Data)`. The pointer is passed through as is,
+   * without a QVariant round-trip.
+   */
+    void deliverInput(NodeId const nodeId,
+                      PortIndex const portIndex,
+                      std::shared_ptr<NodeData> const &data);
+
+    /// Cancels the token of the pending asynchronous run of `nodeId`, if any.
+    void cancelAsyncCompute(NodeId const nodeId);
+
+    /// Called on the model thread when the job of the given run has returned.
+    void onAsyncComputeFinished(NodeId const nodeId,
+                                std::uint64_t const generation,
+                                NodeDelegateModel::ComputeResult const &result);
+
 private Q_SLOTS:
     /**
    * Fuction is called in three cases:
@@ -129,12 +356,103 @@ private:
 
     NodeId _nextNodeId;
 
-    std::unordered_map<NodeId, std::unique_ptr<NodeDelegateModel>> _models;
+    /// Node data read on every paint, layout and propagation step.
+    struct NodeSlot
+    {
+        std::unique_ptr<NodeDelegateModel> model;
+        QPointF pos;
+        QSize size;
+        /// Index of the model name in `_nodeTypeNames`.
+        int type;
+    };
+
+    NodeSlotArray<NodeSlot> _nodes;
+
+    /// Model names of the nodes, interned by `nodeTypeHandle()`.
+    std::vector<QString> _nodeTypeNames;
+
+    std::unordered_map<QString, int> _nodeTypeHandles;
 
     std::unordered_set<ConnectionId> _connectivity;
 
-    mutable std::unordered_map<NodeId, NodeGeometryData> _nodeGeometryData;
+    using PortKey = std::tuple<NodeId, PortType, PortIndex>;
+
+    /// Connections attached to a given (node, port type, port index) triple.
+    /**
+   * The index mirrors `_connectivity` and makes the port queries O(degree)
+   * instead of a linear scan over all the connections in the graph.
+   */
+    std::unordered_map<PortKey, std::unordered_set<ConnectionId>> _portConnections;
+
+    /// All the input and output connections attached to a given node.
+    std::unordered_map<NodeId, std::unordered_set<ConnectionId>> _nodeConnections;
+
     bool   _nodeContinueExec = false;
+
+    ExecutionMode _executionMode = ExecutionMode::Push;
+
+    /// Output ports updated since the last topological pass.
+    std::unordered_map<NodeId, std::unordered_set<PortIndex>> _dirtyOutPorts;
+
+    bool _passScheduled = false;
+
+    struct ExecutionPass;
+
+    /// Non-null while a topological or parallel pass is in progress.
+    std::unique_ptr<ExecutionPass> _pass;
+
+    std::size_t _workerCount = 0;
+
+    std::unique_ptr<WorkStealingThreadPool> _threadPool;
+
+    struct AsyncRun
+    {
+        CancellationToken token;
+        std::uint64_t generation;
+    };
+
+    /// The latest asynchronous run of every node still computing.
+    std::unordered_map<NodeId, AsyncRun> _asyncRuns;
+
+    std::uint64_t _lastAsyncGeneration = 0;
+
+    /// Asynchronous jobs submitted to the pool which have not returned yet,
+    /// cancelled and superseded ones included.
+    std::size_t _asyncJobsInFlight = 0;
+
+    struct InputStamp
+    {
+        std::uint64_t version;
+        std::size_t hash;
+        /// Kept for `NodeData::sameContent()` when `hash` is not zero.
+        std::shared_ptr<NodeData> data;
+    };
+
+    bool _memoizationEnabled = false;
+
+    bool _bulkLoading = false;
+
+    /// Nodes restored since `beginBulkLoad()`.
+    std::vector<NodeId> _bulkLoadedNodes;
+
+    /// Connections added during the current batch, data not delivered yet.
+    std::vector<ConnectionId> _batchConnections;
+
+    /// Nodes given input data while the scenes ignored the batched signals.
+    std::unordered_set<NodeId> _batchInputNodes;
+
+    /// What was delivered last to each input port, per node.
+    std::unordered_map<NodeId, std::unordered_map<PortIndex, InputStamp>> _inputStamps;
+
+    struct Conversion
+    {
+        std::uint64_t sourceVersion = 0;
+        std::shared_ptr<NodeData> data;
+    };
+
+    /// The last conversion done on each connection, reused under memoization
+    /// while the source data keeps its version.
+    std::unordered_map<ConnectionId, Conversion> _conversions;
 };
 
 } // namespace QtNodes
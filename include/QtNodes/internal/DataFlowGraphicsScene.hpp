@@ -21,8 +21,8 @@ public:
     //create node as a export
     void createNewNodeObject(const QString &strText, QPointF const scenePos);
     
-    QString getSaveMsg() const;
-    bool loadMsgFromString(const QString &strCfg);
+    QJsonObject getSaveMsg() const;
+    bool loadMsgFromObj(const QJsonObject &strCfg);
 
 public:
     std::vector<NodeId> selectedNodes() const;
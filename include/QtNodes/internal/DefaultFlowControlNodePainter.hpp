@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QtGui/QPainter>
+
+#include "AbstractNodePainter.hpp"
+#include "Definitions.hpp"
+#include "NodeRenderInfo.hpp"
+
+namespace QtNodes {
+
+class BasicGraphicsScene;
+class GraphModel;
+class NodeGeometry;
+class NodeGraphicsObject;
+class NodeState;
+class NodeStyle;
+
+/// @ Lightweight class incapsulating paint code.
+class NODE_EDITOR_PUBLIC DefaultFlowControlNodePainter : public AbstractNodePainter
+{
+public:
+    void paint(QPainter *painter, NodeGraphicsObject &ngo) const override;
+
+    void drawNodeRect(QPainter *painter,
+                      NodeGraphicsObject &ngo,
+                      NodeRenderInfo const &info,
+                      NodeStyle const &nodeStyle) const;
+
+    void drawConnectionPoints(QPainter *painter,
+                              NodeGraphicsObject &ngo,
+                              NodeRenderInfo const &info,
+                              NodeStyle const &nodeStyle) const;
+
+    void drawFilledConnectionPoints(QPainter *painter,
+                                    NodeGraphicsObject &ngo,
+                                    NodeRenderInfo const &info,
+                                    NodeStyle const &nodeStyle) const;
+
+    void drawNodeCaption(QPainter *painter,
+                         NodeGraphicsObject &ngo,
+                         NodeRenderInfo const &info,
+                         NodeStyle const &nodeStyle) const;
+
+    void drawEntryLabels(QPainter *painter,
+                         NodeGraphicsObject &ngo,
+                         NodeRenderInfo const &info,
+                         NodeStyle const &nodeStyle) const;
+
+    void drawResizeRect(QPainter *painter, NodeGraphicsObject &ngo) const;
+};
+} // namespace QtNodes
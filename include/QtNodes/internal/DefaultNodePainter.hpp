@@ -4,6 +4,7 @@
 
 #include "AbstractNodePainter.hpp"
 #include "Definitions.hpp"
+#include "NodeRenderInfo.hpp"
 
 namespace QtNodes {
 
@@ -12,6 +13,7 @@ class GraphModel;
 class NodeGeometry;
 class NodeGraphicsObject;
 class NodeState;
+class NodeStyle;
 
 /// @ Lightweight class incapsulating paint code.
 class NODE_EDITOR_PUBLIC DefaultNodePainter : public AbstractNodePainter
@@ -19,26 +21,56 @@ class NODE_EDITOR_PUBLIC DefaultNodePainter : public AbstractNodePainter
 public:
     void paint(QPainter *painter, NodeGraphicsObject &ngo) const override;
 
-    void drawCaptionRect(QPainter *painter, NodeGraphicsObject &ngo) const;
-    
-    void drawNodeRect(QPainter *painter, NodeGraphicsObject &ngo) const;
+    /// Low level of detail replacement for all the other draw functions.
+    void drawSimplifiedNode(QPainter *painter,
+                            NodeGraphicsObject &ngo,
+                            NodeRenderInfo const &info,
+                            NodeStyle const &nodeStyle) const;
 
-    void drawConnectionPoints(QPainter *painter, NodeGraphicsObject &ngo) const;
+    void drawCaptionRect(QPainter *painter,
+                         NodeGraphicsObject &ngo,
+                         NodeRenderInfo const &info,
+                         NodeStyle const &nodeStyle) const;
 
-    void drawFilledConnectionPoints(QPainter *painter, NodeGraphicsObject &ngo) const;
+    void drawNodeDescription(QPainter *painter,
+                             NodeGraphicsObject &ngo,
+                             NodeRenderInfo const &info) const;
 
-    void drawNodeCaption(QPainter *painter, NodeGraphicsObject &ngo) const;
+    void drawNodeRect(QPainter *painter,
+                      NodeGraphicsObject &ngo,
+                      NodeRenderInfo const &info,
+                      NodeStyle const &nodeStyle) const;
 
-    void drawEntryLabels(QPainter *painter, NodeGraphicsObject &ngo) const;
+    void drawConnectionPoints(QPainter *painter,
+                              NodeGraphicsObject &ngo,
+                              NodeRenderInfo const &info,
+                              NodeStyle const &nodeStyle) const;
+
+    void drawFilledConnectionPoints(QPainter *painter,
+                                    NodeGraphicsObject &ngo,
+                                    NodeRenderInfo const &info,
+                                    NodeStyle const &nodeStyle) const;
+
+    void drawNodeCaption(QPainter *painter,
+                         NodeGraphicsObject &ngo,
+                         NodeRenderInfo const &info,
+                         NodeStyle const &nodeStyle) const;
+
+    void drawEntryLabels(QPainter *painter,
+                         NodeGraphicsObject &ngo,
+                         NodeRenderInfo const &info,
+                         NodeStyle const &nodeStyle) const;
 
     void drawResizeRect(QPainter *painter, NodeGraphicsObject &ngo) const;
 
-    void drawShowTime(QPainter *painter, NodeGraphicsObject &ngo) const;
+    void drawShowTime(QPainter *painter, NodeGraphicsObject &ngo, NodeRenderInfo const &info) const;
 
-    void drawNodeIcon(QPainter *painter, NodeGraphicsObject &ngo) const;
+    void drawNodeIcon(QPainter *painter, NodeGraphicsObject &ngo, NodeRenderInfo const &info) const;
 
     void drawOperationIcon(QPainter *painter, NodeGraphicsObject &ngo) const;
-    
-    void drawOperationResult(QPainter *painter, NodeGraphicsObject &ngo) const;
+
+    void drawOperationResult(QPainter *painter,
+                             NodeGraphicsObject &ngo,
+                             NodeRenderInfo const &info) const;
 };
 } // namespace QtNodes
@@ -36,6 +36,8 @@ Q_NAMESPACE_EXPORT(NODE_EDITOR_PUBLIC)
         ResultValue = 12,   //Type of Result
         Description = 13,   //‘QString’ for description
         Icon = 14,          //‘QString’ for node icon path
+        Running = 15,       ///< `bool`, true while the node is computing.
+        PaintType = 16,     ///< `int`, a NodePaintType value.
     };
 Q_ENUM_NS(NodeRole)
 
@@ -60,6 +62,12 @@ enum NodeResultType {
     ResultType_UNREACHABLE, //unreachable result ,show image unreachable
 };
 
+//node paint type
+enum NodePaintType {
+    PaintType_NORMAL,      //painted by the scene's node painter
+    PaintType_FLOWCONTROL, //painted by the flow control node painter
+};
+
 enum class NodeExecType{
     EXECTYPE_NONE,
     EXECTYPE_STEP_OVER,
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <unordered_set>
+
+#include "ConnectionIdHash.hpp"
+#include "Definitions.hpp"
+
+namespace QtNodes {
+
+/// Changes made to an AbstractGraphModel during a batch.
+/**
+ * Delivered by `AbstractGraphModel::batchCommitted()`. The changes are
+ * coalesced: an item created and deleted within the same batch does not
+ * appear at all, and the updates and moves of created or deleted nodes are
+ * folded into their creation or deletion. An item deleted and re-created
+ * appears in both sets, deletions are meant to be applied first.
+ */
+struct GraphChangeSet
+{
+    /// The model was reset, the other sets are not filled then.
+    bool reset = false;
+
+    std::unordered_set<NodeId> createdNodes;
+    std::unordered_set<NodeId> deletedNodes;
+
+    /// `nodeUpdated` and `nodeFlagsUpdated` signals.
+    std::unordered_set<NodeId> updatedNodes;
+
+    /// `nodePositionUpdated` and `nodePositionsUpdated` signals.
+    std::unordered_set<NodeId> movedNodes;
+
+    std::unordered_set<ConnectionId> createdConnections;
+    std::unordered_set<ConnectionId> deletedConnections;
+
+    bool empty() const
+    {
+        return !reset && createdNodes.empty() && deletedNodes.empty() && updatedNodes.empty()
+               && movedNodes.empty() && createdConnections.empty()
+               && deletedConnections.empty();
+    }
+};
+
+} // namespace QtNodes
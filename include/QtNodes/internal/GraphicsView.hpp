@@ -4,6 +4,8 @@
 
 #include "Export.hpp"
 
+class QRubberBand;
+
 namespace QtNodes {
 
 class BasicGraphicsScene;
@@ -74,16 +76,23 @@ protected:
 
     void mouseMoveEvent(QMouseEvent *event) override;
 
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
     void drawBackground(QPainter *painter, const QRectF &r) override;
 
     void showEvent(QShowEvent *event) override;
 
+    void paintEvent(QPaintEvent *event) override;
+
 protected:
     BasicGraphicsScene *nodeScene();
 
     /// Computes scene position for pasting the copied/duplicated node groups.
     QPointF scenePastePosition();
 
+    /// Hook for drawing on top of the viewport, e.g. the current scale.
+    virtual void paintScaleMsg(QPainter const &painter);
+
 private:
     QAction *_clearSelectionAction = nullptr;
     QAction *_deleteSelectionAction = nullptr;
@@ -93,5 +102,11 @@ private:
 
     QPointF _clickPos;
     ScaleRange _scaleRange;
+
+    /// Rubber band driven through BasicGraphicsScene::selectItemsIn().
+    QRubberBand *_rubberBand = nullptr;
+    QPoint _rubberBandOrigin;
+    Qt::ItemSelectionOperation _rubberBandOperation = Qt::ReplaceSelection;
+    bool _rubberBanding = false;
 };
 } // namespace QtNodes
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QtCore/QString>
+#include <QtGui/QPixmap>
+
+#include "Export.hpp"
+
+namespace QtNodes {
+
+/// Rasterized SVG icons shared by the node painters.
+/**
+ * Pixmaps are stored in QPixmapCache under the icon path and the device
+ * pixel ratio, so repainting a node never touches the SVG parser once its
+ * icons were drawn. File existence checks for the state variants of an icon
+ * (`icon_hover.svg`, `icon_running.svg`, ...) are cached as well.
+ *
+ * Must only be used from the GUI thread, like QPixmapCache.
+ */
+class NODE_EDITOR_PUBLIC IconCache
+{
+public:
+    /// @returns `path` rendered at twice its default size times `devicePixelRatio`.
+    /**
+   * A null pixmap is returned (and remembered) for files that cannot be
+   * parsed.
+   */
+    static QPixmap pixmap(QString const &path, qreal devicePixelRatio = 1.0);
+
+    /// @returns `path` with `_<state>` inserted before the `.svg` extension.
+    /**
+   * Falls back to `path` when `state` is empty or the variant does not exist.
+   */
+    static QString statePath(QString const &path, QString const &state);
+
+    /// Drops the pixmaps and the existence check of `path` and its variants.
+    static void invalidate(QString const &path);
+
+    /// Drops everything, e.g. after icon files were replaced on disk.
+    static void clear();
+};
+
+} // namespace QtNodes
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <utility>
 
 #include <QtCore/QObject>
 #include <QtCore/QString>
@@ -9,14 +12,86 @@
 
 namespace QtNodes {
 
+/// Compact integer standing for an interned `NodeDataType::id`.
+using NodeDataTypeHandle = int;
+
+static constexpr NodeDataTypeHandle InvalidNodeDataTypeHandle = -1;
+
+/// Process-wide table of the data type ids seen so far.
+/**
+ * Every distinct id gets a handle, counted from zero and never reused, so
+ * two ids are equal exactly when their handles are. The table is thread-safe.
+ */
+class NODE_EDITOR_PUBLIC NodeDataTypeRegistry
+{
+public:
+    /// Returns the handle of `typeId`, registering the id on first use.
+    static NodeDataTypeHandle intern(QString const &typeId);
+
+    /// The id interned as `handle`, an empty string for unknown handles.
+    static QString typeId(NodeDataTypeHandle handle);
+
+    /// Number of interned ids, every handle is below it.
+    static std::size_t size();
+};
+
 /**
  * `id` represents an internal unique data type for the given port.
  * `name` is a normal text description.
+ *
+ * Building a type does not touch `NodeDataTypeRegistry`, types returned by
+ * value from `NodeData::type()` or `NodeDelegateModel::dataType()` stay
+ * cheap. Types meant to be compared often are created once with
+ * `interned()`, typically as a `static NodeDataType const`.
  */
 struct NODE_EDITOR_PUBLIC NodeDataType
 {
+    NodeDataType() = default;
+
+    NodeDataType(QString typeId, QString typeName)
+        : id(std::move(typeId))
+        , name(std::move(typeName))
+    {}
+
+    /// A type whose `id` is interned up front.
+    static NodeDataType interned(QString typeId, QString typeName)
+    {
+        NodeDataType type(std::move(typeId), std::move(typeName));
+        type._handle = NodeDataTypeRegistry::intern(type.id);
+        type._internedId = type.id;
+        return type;
+    }
+
     QString id;
     QString name;
+
+    /// The interned `id`, invalid when the type was not built by `interned()`
+    /// or when `id` has been assigned since.
+    NodeDataTypeHandle handle() const
+    {
+        return (id.constData() == _internedId.constData()) ? _handle
+                                                            : InvalidNodeDataTypeHandle;
+    }
+
+    /// Compares the type ids, with an integer compare when both are interned.
+    bool sameType(NodeDataType const &other) const
+    {
+        NodeDataTypeHandle const lhs = handle();
+        NodeDataTypeHandle const rhs = other.handle();
+
+        if (lhs != InvalidNodeDataTypeHandle && rhs != InvalidNodeDataTypeHandle)
+            return lhs == rhs;
+
+        return id == other.id;
+    }
+
+private:
+    /// Shares the buffer `id` had when it was interned. While it is held, the
+    /// buffer is neither modified in place nor reused, so `id` still points
+    /// at it exactly when it has not been assigned another string.
+    QString _internedId;
+
+    NodeDataTypeHandle _handle = InvalidNodeDataTypeHandle;
 };
 
 /**
@@ -27,15 +102,60 @@ struct NODE_EDITOR_PUBLIC NodeDataType
 class NODE_EDITOR_PUBLIC NodeData
 {
 public:
+    NodeData()
+        : _version(nextVersion())
+    {}
+
+    /// A copy is a distinct piece of content and gets its own version.
+    NodeData(NodeData const &)
+        : _version(nextVersion())
+    {}
+
+    NodeData &operator=(NodeData const &)
+    {
+        _version = nextVersion();
+        return *this;
+    }
+
     virtual ~NodeData() = default;
 
+    /// Process-wide unique stamp of the current content of this instance.
+    /**
+   * Two deliveries carrying the same version are known to carry the same
+   * content, which lets DataFlowGraphModel skip redundant recomputations.
+   */
+    std::uint64_t version() const { return _version; }
+
+    /// Must be called by data types that modify their content in place.
+    void bumpVersion() { _version = nextVersion(); }
+
+    /**
+   * Optional hash of the content, a cheap way to tell two instances apart.
+   * Distinct instances with equal non-zero hashes are then compared with
+   * `sameContent()`. The default `0` means "compare by `version()` only".
+   */
+    virtual std::size_t contentHash() const { return 0; }
+
+    /**
+   * Checks whether `other` carries the same content. Only asked for
+   * instances with equal non-zero `contentHash()`. The default `false` treats
+   * them as different.
+   */
+    virtual bool sameContent(NodeData const &) const { return false; }
+
     virtual bool sameType(NodeData const &nodeData) const
     {
-        return (this->type().id == nodeData.type().id);
+        return this->type().sameType(nodeData.type());
     }
 
     /// Type for inner use
     virtual NodeDataType type() const = 0;
+
+private:
+    static std::uint64_t nextVersion();
+
+private:
+    std::uint64_t _version;
 };
 
 } // namespace QtNodes
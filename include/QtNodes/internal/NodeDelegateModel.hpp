@@ -1,9 +1,11 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 
 #include <QtWidgets/QWidget>
 
+#include "CancellationToken.hpp"
 #include "Definitions.hpp"
 #include "Export.hpp"
 #include "NodeData.hpp"
@@ -51,9 +53,52 @@ public:
     virtual NodeResultType getResult() const { return ResultType_NONE; }
 
     virtual int nodeComputeTime() const {return 0;};
+    virtual bool operationStatus() const { return false; }
+    virtual NodePaintType getPaintType() const { return PaintType_NORMAL; }
     virtual void execStepOver(){};
     virtual void execStepNext(){};
 
+    /**
+   * Opt-in for `DataFlowGraphModel::ExecutionMode::Parallel`.
+   *
+   * Returning `true` declares that `setInData()` and the computation it
+   * triggers may run on a worker thread, concurrently with other nodes. Such a
+   * model must not touch its embedded widget from there. `outData()` is still
+   * called on the thread owning the graph model, after `setInData()` returns.
+   */
+    virtual bool computeIsThreadSafe() const { return false; }
+
+public:
+    /// Publishes the outcome of an asynchronous computation.
+    using ComputeResult = std::function<void()>;
+
+    /// Off-thread part of an asynchronous computation.
+    using ComputeJob = std::function<ComputeResult(CancellationToken const &)>;
+
+    /**
+   * Returning `true` makes DataFlowGraphModel deliver the inputs with
+   * `bContinueExec == false` and call `computeAsync()` instead of letting
+   * `setInData()` compute synchronously.
+   */
+    virtual bool supportsAsyncCompute() const { return false; }
+
+    /**
+   * Asynchronous compute entry point, called on the model thread once the
+   * inputs are set.
+   *
+   * The returned job is executed on a worker thread. It must only use what it
+   * captured (e.g. copies of the input data), never the model itself, and
+   * should poll the token to stop early. The token is cancelled as soon as an
+   * input of the node changes or the node is deleted.
+   *
+   * The `ComputeResult` returned by the job is invoked on the model thread and
+   * typically stores the result and emits `dataUpdated(port, true)`. It is
+   * dropped when the run was cancelled or superseded by a newer one.
+   *
+   * An empty job means there is nothing to compute.
+   */
+    virtual ComputeJob computeAsync() { return ComputeJob(); }
+
 public:
     QJsonObject save() const override;
 
@@ -117,6 +162,9 @@ Q_SIGNALS:
 
     void embeddedWidgetSizeUpdated();
 
+    /// Asks the scene to repaint the node.
+    void nodeUpdated();
+
     /// Call this function before deleting the data associated with ports.
     /**
    * The function notifies the Graph Model and makes it remove and recompute the
@@ -4,6 +4,7 @@
 #include "NodeData.hpp"
 #include "NodeDelegateModel.hpp"
 #include "QStringStdHash.hpp"
+#include "TypeConverter.hpp"
 
 #include <QtCore/QString>
 
@@ -27,17 +28,15 @@ public:
     using RegisteredModelsCategoryMap = std::unordered_map<QString, QString>;
     using CategoriesSet = std::set<QString>;
 
-    //using RegisteredTypeConvertersMap = std::map<TypeConverterId, TypeConverter>;
-
-    NodeDelegateModelRegistry() = default;
-    ~NodeDelegateModelRegistry() = default;
+    NodeDelegateModelRegistry();
+    ~NodeDelegateModelRegistry();
 
     NodeDelegateModelRegistry(NodeDelegateModelRegistry const &) = delete;
-    NodeDelegateModelRegistry(NodeDelegateModelRegistry &&) = default;
+    NodeDelegateModelRegistry(NodeDelegateModelRegistry &&);
 
     NodeDelegateModelRegistry &operator=(NodeDelegateModelRegistry const &) = delete;
 
-    NodeDelegateModelRegistry &operator=(NodeDelegateModelRegistry &&) = default;
+    NodeDelegateModelRegistry &operator=(NodeDelegateModelRegistry &&);
 
 public:
     template<typename ModelType>
@@ -83,16 +82,20 @@ public:
   {
     registerModel(std::forward<ModelCreator>(creator), category);
   }
+#endif
 
+    /**
+   * Registers a conversion from `from` to `to`, replacing the previous one.
+   *
+   * `DataFlowGraphModel` accepts connections between the two types and
+   * applies the converter to every value delivered over them. Converters are
+   * chained when no direct one exists, e.g. `int -> double -> string`.
+   */
+    void registerTypeConverter(NodeDataType const &from,
+                               NodeDataType const &to,
+                               TypeConverter typeConverter);
 
-  void
-  registerTypeConverter(TypeConverterId const& id,
-                        TypeConverter          typeConverter)
-  {
-    _registeredTypeConverters[id] = std::move(typeConverter);
-  }
-
-#endif
+    void registerTypeConverter(TypeConverterId const &id, TypeConverter typeConverter);
 
     std::unique_ptr<NodeDelegateModel> create(QString const &modelName);
 
@@ -102,11 +105,19 @@ public:
 
     CategoriesSet const &categories() const;
 
-#if 0
-  TypeConverter
-  getTypeConverter(NodeDataType const& d1,
-                   NodeDataType const& d2) const;
-#endif
+    /**
+   * The conversion from `from` to `to` through the shortest chain of
+   * registered converters, an empty function when there is none.
+   *
+   * Lookups are thread-safe. Every resolved pair, including the unresolvable
+   * ones, is cached until the next `registerTypeConverter()` call.
+   */
+    TypeConverter getTypeConverter(NodeDataType const &from, NodeDataType const &to) const;
+
+    TypeConverter getTypeConverter(TypeConverterId const &id) const;
+
+    /// Lock-free check letting the data propagation skip the lookups.
+    bool hasTypeConverters() const;
 
 private:
     RegisteredModelsCategoryMap _registeredModelsCategory;
@@ -115,9 +126,9 @@ private:
 
     RegisteredModelCreatorsMap _registeredItemCreators;
 
-#if 0
-  RegisteredTypeConvertersMap _registeredTypeConverters;
-#endif
+    struct TypeConverters;
+
+    std::unique_ptr<TypeConverters> _typeConverters;
 
 private:
     // If the registered ModelType class has the static member method
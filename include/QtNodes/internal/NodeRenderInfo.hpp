@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QtCore/QSize>
+#include <QtCore/QString>
+
+#include <vector>
+
+#include "Definitions.hpp"
+#include "NodeData.hpp"
+
+namespace QtNodes {
+
+/// Port part of NodeRenderInfo.
+struct NodeRenderPortInfo
+{
+    NodeDataType dataType;
+    QString caption;
+    bool captionVisible = false;
+
+    /// Text displayed next to the port: the caption if visible, the type name otherwise.
+    QString const &label() const { return captionVisible ? caption : dataType.name; }
+};
+
+/// Snapshot of the node data used by the painters and the node geometries.
+/**
+ * Returned by `AbstractGraphModel::nodeRenderInfo()`, it replaces a dozen of
+ * `nodeData()`/`portData()` calls, each boxing its value into a QVariant.
+ */
+struct NodeRenderInfo
+{
+    QString caption;                         ///< NodeRole::Caption
+    bool captionVisible = true;              ///< NodeRole::CaptionVisible
+    QString description;                     ///< NodeRole::Description
+    QString icon;                            ///< NodeRole::Icon
+    QSize size;                              ///< NodeRole::Size
+    bool running = false;                    ///< NodeRole::Running
+    int computeTime = 0;                     ///< NodeRole::Time, in milliseconds
+    NodeResultType result = ResultType_NONE; ///< NodeRole::ResultValue
+    int paintType = 0;                       ///< NodeRole::PaintType
+
+    std::vector<NodeRenderPortInfo> inPorts;
+    std::vector<NodeRenderPortInfo> outPorts;
+
+    std::vector<NodeRenderPortInfo> const &ports(PortType portType) const
+    {
+        return (portType == PortType::In) ? inPorts : outPorts;
+    }
+};
+
+} // namespace QtNodes
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Definitions.hpp"
+
+namespace QtNodes {
+
+/// Per-node values stored contiguously and looked up by NodeId.
+/**
+ * Node ids handed out by `AbstractGraphModel::newNodeId()` are dense
+ * counters, so a plain vector indexed by the id locates the slot of a node
+ * without hashing. The values themselves are packed in a second vector, in
+ * no particular order, which makes visiting all the nodes a linear scan.
+ * Erasing moves the last value into the freed slot.
+ *
+ * Every slot keeps the id it was inserted for and lookups compare it with
+ * the requested one, so a stale index entry never yields another node's
+ * value.
+ *
+ * Ids far beyond the number of stored nodes, e.g. read from a hand-edited
+ * file, go to a small hash map instead of growing the index.
+ */
+template<typename T>
+class NodeSlotArray
+{
+public:
+    /// @returns `nullptr` when there is no value for `nodeId`.
+    T *find(NodeId const nodeId)
+    {
+        std::size_t const slot = slotOf(nodeId);
+        return (slot != NoSlot) ? &_values[slot] : nullptr;
+    }
+
+    T const *find(NodeId const nodeId) const
+    {
+        std::size_t const slot = slotOf(nodeId);
+        return (slot != NoSlot) ? &_values[slot] : nullptr;
+    }
+
+    bool contains(NodeId const nodeId) const { return slotOf(nodeId) != NoSlot; }
+
+    /// Stores `value` for `nodeId`, replacing the previous one if any.
+    /**
+   * References to the other values are invalidated when the storage grows.
+   */
+    T &insert(NodeId const nodeId, T value)
+    {
+        std::size_t slot = slotOf(nodeId);
+
+        if (slot != NoSlot) {
+            _values[slot] = std::move(value);
+            return _values[slot];
+        }
+
+        slot = _values.size();
+
+        _ids.push_back(nodeId);
+        _values.push_back(std::move(value));
+
+        setSlot(nodeId, slot);
+
+        return _values[slot];
+    }
+
+    /// @returns `false` when there was no value for `nodeId`.
+    bool erase(NodeId const nodeId)
+    {
+        std::size_t const slot = slotOf(nodeId);
+
+        if (slot == NoSlot)
+            return false;
+
+        std::size_t const last = _values.size() - 1;
+
+        if (slot != last) {
+            _ids[slot] = _ids[last];
+            _values[slot] = std::move(_values[last]);
+
+            setSlot(_ids[slot], slot);
+        }
+
+        _ids.pop_back();
+        _values.pop_back();
+
+        clearSlot(nodeId);
+
+        return true;
+    }
+
+    void clear()
+    {
+        _ids.clear();
+        _values.clear();
+        _index.clear();
+        _sparseIndex.clear();
+    }
+
+    std::size_t size() const { return _values.size(); }
+
+    bool empty() const { return _values.empty(); }
+
+    /// Ids of the stored values, `ids()[i]` belongs to `values()[i]`.
+    std::vector<NodeId> const &ids() const { return _ids; }
+
+    std::vector<T> &values() { return _values; }
+
+    std::vector<T> const &values() const { return _values; }
+
+private:
+    static constexpr std::size_t NoSlot = static_cast<std::size_t>(-1);
+
+    /// The index always covers that many ids.
+    static constexpr std::size_t MinIndexSize = 1024;
+
+    /// Ids up to `IndexSlack` times the node count are kept in the index.
+    static constexpr std::size_t IndexSlack = 4;
+
+    std::size_t slotOf(NodeId const nodeId) const
+    {
+        std::size_t slot = NoSlot;
+
+        if (nodeId < _index.size() && _index[nodeId] != 0) {
+            slot = _index[nodeId] - 1;
+        } else if (!_sparseIndex.empty()) {
+            auto it = _sparseIndex.find(nodeId);
+            if (it != _sparseIndex.end())
+                slot = it->second;
+        }
+
+        if (slot >= _ids.size() || _ids[slot] != nodeId)
+            return NoSlot;
+
+        return slot;
+    }
+
+    void setSlot(NodeId const nodeId, std::size_t const slot)
+    {
+        std::size_t const slack = IndexSlack * _values.size();
+        std::size_t const limit = (slack > MinIndexSize) ? slack : MinIndexSize;
+
+        if (nodeId >= _index.size() && nodeId < limit)
+            _index.resize(std::min(limit, std::max<std::size_t>(nodeId + 1, 2 * _index.size())));
+
+        if (nodeId < _index.size() && _sparseIndex.find(nodeId) == _sparseIndex.end()) {
+            _index[nodeId] = static_cast<std::uint32_t>(slot + 1);
+        } else {
+            _sparseIndex[nodeId] = slot;
+        }
+    }
+
+    void clearSlot(NodeId const nodeId)
+    {
+        if (nodeId < _index.size())
+            _index[nodeId] = 0;
+
+        if (!_sparseIndex.empty())
+            _sparseIndex.erase(nodeId);
+    }
+
+private:
+    std::vector<NodeId> _ids;
+
+    std::vector<T> _values;
+
+    /// Slot of every id plus one, `0` for ids without a value.
+    std::vector<std::uint32_t> _index;
+
+    std::unordered_map<NodeId, std::size_t> _sparseIndex;
+};
+
+} // namespace QtNodes
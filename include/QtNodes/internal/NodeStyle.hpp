@@ -43,11 +43,24 @@ public:
     QColor WarningColor;
     QColor ErrorColor;
 
+    QColor HoverBoundaryColor;
+    QColor OperationBoundaryColor;
+    QColor NormalCaptionRectColor;
+    QColor SelectedCaptionRectColor;
+    QColor HoverCaptionRectColor;
+    QColor OperationCaptionRectColor;
+
     float PenWidth;
     float HoveredPenWidth;
 
     float ConnectionPointDiameter;
 
     float Opacity;
+
+    /// Below this level of detail captions, icons and port ellipses are skipped.
+    float TextLevelOfDetail = 0.5f;
+
+    /// Below this level of detail the node is painted as a plain filled rect.
+    float SimplifiedLevelOfDetail = 0.3f;
 };
 } // namespace QtNodes
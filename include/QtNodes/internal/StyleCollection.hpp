@@ -2,6 +2,10 @@
 
 #include "Export.hpp"
 
+#include <QtCore/QtGlobal>
+
+#include <memory>
+
 #include "ConnectionStyle.hpp"
 #include "GraphicsViewStyle.hpp"
 #include "NodeStyle.hpp"
@@ -13,6 +17,12 @@ class NODE_EDITOR_PUBLIC StyleCollection
 public:
     static NodeStyle const &nodeStyle();
 
+    /// Same instance as `nodeStyle()`, safe to keep after the style is replaced.
+    static std::shared_ptr<NodeStyle const> sharedNodeStyle();
+
+    /// Incremented by every `setNodeStyle()` call, for caches derived from the style.
+    static quint64 nodeStyleVersion();
+
     static ConnectionStyle const &connectionStyle();
 
     static GraphicsViewStyle const &flowViewStyle();
@@ -25,7 +35,7 @@ public:
     static void setGraphicsViewStyle(GraphicsViewStyle);
 
 private:
-    StyleCollection() = default;
+    StyleCollection();
 
     StyleCollection(StyleCollection const &) = delete;
 
@@ -34,7 +44,9 @@ private:
     static StyleCollection &instance();
 
 private:
-    NodeStyle _nodeStyle;
+    std::shared_ptr<NodeStyle const> _nodeStyle;
+
+    quint64 _nodeStyleVersion;
 
     ConnectionStyle _connectionStyle;
 
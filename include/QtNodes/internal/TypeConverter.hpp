@@ -0,0 +1,23 @@
+#pragma once
+
+#include "NodeData.hpp"
+
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace QtNodes {
+
+using SharedNodeData = std::shared_ptr<NodeData>;
+
+/// Turns the data of one type into the data of another one.
+/**
+ * A converter receives non-null data and may return `nullptr` when the value
+ * has no counterpart in the target type.
+ */
+using TypeConverter = std::function<SharedNodeData(SharedNodeData)>;
+
+/// The (from, to) pair of interned data types a converter is registered for.
+using TypeConverterId = std::pair<NodeDataTypeHandle, NodeDataTypeHandle>;
+
+} // namespace QtNodes
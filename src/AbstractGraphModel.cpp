@@ -2,8 +2,186 @@
 
 #include <QtNodes/ConnectionIdUtils>
 
+#include <QtCore/QJsonDocument>
+
+#include <utility>
+
+#include "NodeStyle.hpp"
+
 namespace QtNodes {
 
+std::shared_ptr<NodeStyle const> AbstractGraphModel::nodeStyle(NodeId nodeId) const
+{
+    QJsonDocument json = QJsonDocument::fromVariant(nodeData(nodeId, NodeRole::Style));
+
+    return std::make_shared<NodeStyle const>(json.object());
+}
+
+NodeRenderInfo AbstractGraphModel::nodeRenderInfo(NodeId nodeId) const
+{
+    NodeRenderInfo info;
+
+    info.caption = nodeData<QString>(nodeId, NodeRole::Caption);
+    info.captionVisible = nodeData<bool>(nodeId, NodeRole::CaptionVisible);
+    info.description = nodeData<QString>(nodeId, NodeRole::Description);
+    info.icon = nodeData<QString>(nodeId, NodeRole::Icon);
+    info.size = nodeData<QSize>(nodeId, NodeRole::Size);
+    info.running = nodeData<bool>(nodeId, NodeRole::Running);
+    info.computeTime = nodeData<int>(nodeId, NodeRole::Time);
+    info.result = static_cast<NodeResultType>(nodeData<int>(nodeId, NodeRole::ResultValue));
+    info.paintType = nodeData<int>(nodeId, NodeRole::PaintType);
+
+    for (PortType portType : {PortType::In, PortType::Out}) {
+        auto &ports = (portType == PortType::In) ? info.inPorts : info.outPorts;
+
+        ports.resize(nodeData<PortCount>(nodeId,
+                                         (portType == PortType::In) ? NodeRole::InPortCount
+                                                                    : NodeRole::OutPortCount));
+
+        for (PortIndex portIndex = 0; portIndex < ports.size(); ++portIndex) {
+            NodeRenderPortInfo &port = ports[portIndex];
+
+            port.dataType = portData<NodeDataType>(nodeId, portType, portIndex, PortRole::DataType);
+            port.captionVisible = portData<bool>(nodeId,
+                                                 portType,
+                                                 portIndex,
+                                                 PortRole::CaptionVisible);
+            port.caption = portData<QString>(nodeId, portType, portIndex, PortRole::Caption);
+        }
+    }
+
+    return info;
+}
+
+void AbstractGraphModel::moveNodes(std::vector<NodeId> const &nodeIds, QPointF const &offset)
+{
+    for (NodeId const nodeId : nodeIds) {
+        QPointF const pos = nodeData<QPointF>(nodeId, NodeRole::Position);
+
+        setNodeData(nodeId, NodeRole::Position, pos + offset);
+    }
+}
+
+void AbstractGraphModel::forEachNode(NodeVisitor const &visitor) const
+{
+    for (NodeId const nodeId : allNodeIds()) {
+        visitor(nodeId);
+    }
+}
+
+void AbstractGraphModel::forEachNodeConnection(NodeId const nodeId,
+                                               ConnectionVisitor const &visitor) const
+{
+    for (ConnectionId const &connectionId : allConnectionIds(nodeId)) {
+        visitor(connectionId);
+    }
+}
+
+void AbstractGraphModel::forEachConnection(NodeId const nodeId,
+                                           PortType const portType,
+                                           PortIndex const index,
+                                           ConnectionVisitor const &visitor) const
+{
+    for (ConnectionId const &connectionId : connections(nodeId, portType, index)) {
+        visitor(connectionId);
+    }
+}
+
+std::size_t AbstractGraphModel::connectionCount(NodeId const nodeId,
+                                                PortType const portType,
+                                                PortIndex const index) const
+{
+    return connections(nodeId, portType, index).size();
+}
+
+void AbstractGraphModel::beginBatch()
+{
+    if (_batchDepth++ > 0)
+        return;
+
+    GraphChangeSet &changes = _batchChanges;
+
+    auto nodeCreated = [&changes](NodeId const nodeId) {
+        changes.createdNodes.insert(nodeId);
+    };
+
+    auto nodeDeleted = [&changes](NodeId const nodeId) {
+        changes.updatedNodes.erase(nodeId);
+        changes.movedNodes.erase(nodeId);
+
+        // Nodes living only within the batch are never seen by the observers.
+        if (changes.createdNodes.erase(nodeId) == 0)
+            changes.deletedNodes.insert(nodeId);
+    };
+
+    auto nodeUpdated = [&changes](NodeId const nodeId) {
+        if (changes.createdNodes.count(nodeId) == 0)
+            changes.updatedNodes.insert(nodeId);
+    };
+
+    auto nodeMoved = [&changes](NodeId const nodeId) {
+        if (changes.createdNodes.count(nodeId) == 0)
+            changes.movedNodes.insert(nodeId);
+    };
+
+    auto connectionCreated = [&changes](ConnectionId const connectionId) {
+        changes.createdConnections.insert(connectionId);
+    };
+
+    auto connectionDeleted = [&changes](ConnectionId const connectionId) {
+        if (changes.createdConnections.erase(connectionId) == 0)
+            changes.deletedConnections.insert(connectionId);
+    };
+
+    _batchRecorders = {
+        connect(this, &AbstractGraphModel::nodeCreated, this, nodeCreated),
+        connect(this, &AbstractGraphModel::nodeDeleted, this, nodeDeleted),
+        connect(this, &AbstractGraphModel::nodeUpdated, this, nodeUpdated),
+        connect(this, &AbstractGraphModel::nodeFlagsUpdated, this, nodeUpdated),
+        connect(this, &AbstractGraphModel::nodePositionUpdated, this, nodeMoved),
+        connect(this,
+                &AbstractGraphModel::nodePositionsUpdated,
+                this,
+                [nodeMoved](std::vector<NodeId> const &nodeIds) {
+                    for (NodeId const nodeId : nodeIds) {
+                        nodeMoved(nodeId);
+                    }
+                }),
+        connect(this, &AbstractGraphModel::connectionCreated, this, connectionCreated),
+        connect(this, &AbstractGraphModel::connectionDeleted, this, connectionDeleted),
+        // The observers rebuild everything after a reset.
+        connect(this, &AbstractGraphModel::modelReset, this, [&changes]() {
+            changes = GraphChangeSet();
+            changes.reset = true;
+        }),
+    };
+}
+
+void AbstractGraphModel::endBatch()
+{
+    if (_batchDepth == 0 || --_batchDepth > 0)
+        return;
+
+    for (QMetaObject::Connection const &connection : _batchRecorders) {
+        disconnect(connection);
+    }
+    _batchRecorders.clear();
+
+    GraphChangeSet changes;
+    std::swap(changes, _batchChanges);
+
+    // A reset already covers everything recorded after it.
+    if (changes.reset) {
+        changes = GraphChangeSet();
+        changes.reset = true;
+    }
+
+    if (!changes.empty())
+        Q_EMIT batchCommitted(changes);
+
+    batchEnded();
+}
+
 void AbstractGraphModel::portsAboutToBeDeleted(NodeId const nodeId,
                                                PortType const portType,
                                                PortIndex const first,
@@ -8,6 +8,9 @@
 #include "DefaultVerticalNodeGeometry.hpp"
 #include "GraphicsView.hpp"
 #include "NodeGraphicsObject.hpp"
+#include "SpatialGridIndex.hpp"
+#include "UndoCommands.hpp"
+#include "UndoPayloadStore.hpp"
 #include "DefaultFlowControlNodePainter.hpp"
 
 #include <QUndoStack>
@@ -22,9 +25,13 @@
 #include <QtCore/QJsonArray>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
+#include <QtCore/QSignalBlocker>
 #include <QtCore/QtGlobal>
 
+#include <algorithm>
+#include <deque>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <unordered_set>
 #include <utility>
@@ -35,13 +42,19 @@ namespace QtNodes {
 BasicGraphicsScene::BasicGraphicsScene(AbstractGraphModel &graphModel, QObject *parent)
     : QGraphicsScene(parent)
     , _graphModel(graphModel)
+    , _nodeIndex(std::make_unique<SpatialGridIndex<NodeId>>())
+    , _connectionIndex(std::make_unique<SpatialGridIndex<ConnectionId>>())
     , _nodeGeometry(std::make_unique<DefaultHorizontalNodeGeometry>(_graphModel))
     , _nodePainter(std::make_unique<DefaultNodePainter>())
     , _flowControlPainter(std::make_unique<DefaultFlowControlNodePainter>())
     , _nodeDrag(false)
     , _undoStack(new QUndoStack(this))
+    , _undoPayloadStore(std::make_shared<UndoPayloadStore>())
     , _orientation(Qt::Horizontal)
 {
+    // Qt's BSP index is rebuilt on every item move. Nodes and connections
+    // are looked up through `_nodeIndex` and `_connectionIndex` instead, see
+    // `nodeAt()`, `connectionAt()` and `selectItemsIn()`.
     setItemIndexMethod(QGraphicsScene::NoIndex);
 
     connect(&_graphModel,
@@ -69,15 +82,30 @@ BasicGraphicsScene::BasicGraphicsScene(AbstractGraphModel &graphModel, QObject *
             this,
             &BasicGraphicsScene::onNodePositionUpdated);
 
+    connect(&_graphModel,
+            &AbstractGraphModel::nodePositionsUpdated,
+            this,
+            &BasicGraphicsScene::onNodePositionsUpdated);
+
     connect(&_graphModel,
             &AbstractGraphModel::nodeUpdated,
             this,
             &BasicGraphicsScene::onNodeUpdated);
 
+    connect(&_graphModel,
+            &AbstractGraphModel::batchCommitted,
+            this,
+            &BasicGraphicsScene::onBatchCommitted);
+
     connect(this, &BasicGraphicsScene::nodeClicked, this, &BasicGraphicsScene::onNodeClicked);
 
     connect(&_graphModel, &AbstractGraphModel::modelReset, this, &BasicGraphicsScene::onModelReset);
 
+    connect(_undoStack,
+            &QUndoStack::indexChanged,
+            this,
+            &BasicGraphicsScene::onUndoIndexChanged);
+
     traverseGraphAndPopulateGraphicsObjects();
 }
 
@@ -108,10 +136,12 @@ void BasicGraphicsScene::setNodePainter(std::unique_ptr<AbstractNodePainter> new
     _nodePainter = std::move(newPainter);
 }
 
-void BasicGraphicsScene::setFlowControlNodePainter(std::unique_ptr<DefaultFlowControlNodePainter> newPainter)
+void BasicGraphicsScene::setFlowControlNodePainter(
+    std::unique_ptr<DefaultFlowControlNodePainter> newPainter)
 {
     _flowControlPainter = std::move(newPainter);
 }
+
 DefaultFlowControlNodePainter &BasicGraphicsScene::flowControlNodePainter()
 {
     return *_flowControlPainter;
@@ -122,12 +152,48 @@ QUndoStack &BasicGraphicsScene::undoStack()
     return *_undoStack;
 }
 
+std::shared_ptr<UndoPayloadStore> const &BasicGraphicsScene::undoPayloadStore() const
+{
+    return _undoPayloadStore;
+}
+
+void BasicGraphicsScene::setUndoMemoryBudget(std::size_t bytes)
+{
+    _undoMemoryBudget = bytes;
+
+    enforceUndoMemoryBudget();
+}
+
+void BasicGraphicsScene::setUndoSpillEnabled(bool enabled)
+{
+    _undoPayloadStore->setSpillEnabled(enabled);
+
+    enforceUndoMemoryBudget();
+}
+
+bool BasicGraphicsScene::undoSpillEnabled() const
+{
+    return _undoPayloadStore->spillEnabled();
+}
+
+static std::size_t commandMemoryUsage(QUndoCommand const *command)
+{
+    auto sceneCommand = dynamic_cast<SceneUndoCommand const *>(command);
+
+    return sceneCommand ? sceneCommand->memoryUsage() : sizeof(QUndoCommand);
+}
+
+std::size_t BasicGraphicsScene::undoMemoryUsage() const
+{
+    return _undoCommandBytes + _undoPayloadStore->residentBytes();
+}
+
 void BasicGraphicsScene::setNodeExecType(const NodeId nodeId, NodeExecType nType)
 {
     _graphModel.setNodeExecType(nodeId, nType);
 }
 
-bool BasicGraphicsScene::hasNodeExec()
+bool BasicGraphicsScene::hasNodeExec() const
 {
     return _graphModel.hasNodeExec();
 }
@@ -149,6 +215,8 @@ void BasicGraphicsScene::resetDraftConnection()
 
 void BasicGraphicsScene::clearScene()
 {
+    AbstractGraphModel::BatchGuard batch(graphModel());
+
     auto const &allNodeIds = graphModel().allNodeIds();
 
     for (auto nodeId : allNodeIds) {
@@ -178,6 +246,158 @@ ConnectionGraphicsObject *BasicGraphicsScene::connectionGraphicsObject(Connectio
     return cgo;
 }
 
+NodeGraphicsObject *BasicGraphicsScene::nodeAt(QPointF const &scenePoint)
+{
+    NodeGraphicsObject *topmost = nullptr;
+
+    _nodeIndex->forEachAt(scenePoint, [&](NodeId const nodeId, QRectF const &) {
+        NodeGraphicsObject *ngo = nodeGraphicsObject(nodeId);
+
+        if (!ngo || !ngo->isVisible() || !ngo->contains(ngo->mapFromScene(scenePoint)))
+            return;
+
+        if (!topmost || ngo->zValue() > topmost->zValue())
+            topmost = ngo;
+    });
+
+    return topmost;
+}
+
+std::vector<NodeGraphicsObject *> BasicGraphicsScene::nodesIn(QRectF const &sceneRect)
+{
+    std::vector<NodeGraphicsObject *> result;
+
+    _nodeIndex->forEachIn(sceneRect, [&](NodeId const nodeId, QRectF const &) {
+        if (NodeGraphicsObject *ngo = nodeGraphicsObject(nodeId))
+            result.push_back(ngo);
+    });
+
+    return result;
+}
+
+ConnectionGraphicsObject *BasicGraphicsScene::connectionAt(QPointF const &scenePoint)
+{
+    ConnectionGraphicsObject *topmost = nullptr;
+
+    _connectionIndex->forEachAt(scenePoint, [&](ConnectionId const &connectionId, QRectF const &) {
+        ConnectionGraphicsObject *cgo = connectionGraphicsObject(connectionId);
+
+        if (!cgo || !cgo->isVisible() || !cgo->contains(cgo->mapFromScene(scenePoint)))
+            return;
+
+        if (!topmost || cgo->zValue() > topmost->zValue())
+            topmost = cgo;
+    });
+
+    return topmost;
+}
+
+std::vector<ConnectionGraphicsObject *> BasicGraphicsScene::connectionsIn(QRectF const &sceneRect)
+{
+    std::vector<ConnectionGraphicsObject *> result;
+
+    _connectionIndex->forEachIn(sceneRect, [&](ConnectionId const &connectionId, QRectF const &) {
+        if (ConnectionGraphicsObject *cgo = connectionGraphicsObject(connectionId))
+            result.push_back(cgo);
+    });
+
+    return result;
+}
+
+void BasicGraphicsScene::selectItemsIn(QPainterPath const &sceneArea,
+                                       Qt::ItemSelectionOperation operation)
+{
+    QRectF const bounds = sceneArea.boundingRect();
+
+    std::unordered_set<QGraphicsItem *> hits;
+
+    auto collect = [&](QGraphicsItem *item) {
+        if (item->isVisible()
+            && item->collidesWithPath(item->mapFromScene(sceneArea), Qt::IntersectsItemShape))
+            hits.insert(item);
+    };
+
+    for (NodeGraphicsObject *ngo : nodesIn(bounds))
+        collect(ngo);
+
+    for (ConnectionGraphicsObject *cgo : connectionsIn(bounds))
+        collect(cgo);
+
+    bool changed = false;
+
+    {
+        // Every setSelected() call would emit selectionChanged() otherwise.
+        QSignalBlocker blocker(this);
+
+        if (operation == Qt::ReplaceSelection) {
+            for (QGraphicsItem *item : selectedItems()) {
+                if (hits.count(item) == 0) {
+                    item->setSelected(false);
+                    changed = true;
+                }
+            }
+        }
+
+        for (QGraphicsItem *item : hits) {
+            if (!item->isSelected()) {
+                item->setSelected(true);
+                changed = true;
+            }
+        }
+    }
+
+    if (changed)
+        Q_EMIT selectionChanged();
+}
+
+void BasicGraphicsScene::updateNodeIndex(NodeId const nodeId)
+{
+    if (NodeGraphicsObject *ngo = nodeGraphicsObject(nodeId))
+        _nodeIndex->insert(nodeId, ngo->sceneBoundingRect());
+}
+
+void BasicGraphicsScene::updateConnectionIndex(ConnectionId const connectionId)
+{
+    if (ConnectionGraphicsObject *cgo = connectionGraphicsObject(connectionId))
+        _connectionIndex->insert(connectionId, cgo->sceneBoundingRect());
+}
+
+void BasicGraphicsScene::dragSelectedNodes(QPointF const &offset)
+{
+    if (_draggedNodes.empty()) {
+        for (QGraphicsItem *item : selectedItems()) {
+            if (auto n = qgraphicsitem_cast<NodeGraphicsObject *>(item))
+                _draggedNodes.push_back(n->nodeId());
+        }
+
+        std::sort(_draggedNodes.begin(), _draggedNodes.end());
+        _dragOffset = QPointF();
+    }
+
+    _dragOffset += offset;
+
+    for (NodeId const nodeId : _draggedNodes) {
+        if (NodeGraphicsObject *ngo = nodeGraphicsObject(nodeId))
+            ngo->moveBy(offset.x(), offset.y());
+    }
+}
+
+void BasicGraphicsScene::finishNodeDrag()
+{
+    if (_draggedNodes.empty())
+        return;
+
+    std::vector<NodeId> nodeIds;
+    nodeIds.swap(_draggedNodes);
+
+    // The model positions are still the ones from before the gesture, the
+    // command applies the whole offset at once.
+    if (!_dragOffset.isNull())
+        _undoStack->push(new MoveNodeCommand(this, std::move(nodeIds), _dragOffset));
+
+    _dragOffset = QPointF();
+}
+
 void BasicGraphicsScene::setOrientation(Qt::Orientation const orientation)
 {
     if (_orientation != orientation) {
@@ -205,26 +425,161 @@ QMenu *BasicGraphicsScene::createSceneMenu(QPointF const scenePos)
 
 void BasicGraphicsScene::traverseGraphAndPopulateGraphicsObjects()
 {
-    auto allNodeIds = _graphModel.allNodeIds();
-
     // First create all the nodes.
-    for (NodeId const nodeId : allNodeIds) {
+    _graphModel.forEachNode([this](NodeId const nodeId) {
         _nodeGraphicsObjects[nodeId] = std::make_unique<NodeGraphicsObject>(*this, nodeId);
-    }
+        updateNodeIndex(nodeId);
+    });
 
     // Then for each node check output connections and insert them.
-    for (NodeId const nodeId : allNodeIds) {
+    _graphModel.forEachNode([this](NodeId const nodeId) {
         auto nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
 
-        for (PortIndex index = 0; index < nOutPorts; ++index) {
-            auto const &outConnectionIds = _graphModel.connections(nodeId, PortType::Out, index);
+        auto createConnection = [this](ConnectionId const &cid) {
+            _connectionGraphicsObjects[cid] = std::make_unique<ConnectionGraphicsObject>(*this, cid);
+            updateConnectionIndex(cid);
+        };
 
-            for (auto cid : outConnectionIds) {
-                _connectionGraphicsObjects[cid] = std::make_unique<ConnectionGraphicsObject>(*this,
-                                                                                             cid);
-            }
+        for (PortIndex index = 0; index < nOutPorts; ++index) {
+            _graphModel.forEachConnection(nodeId, PortType::Out, index, createConnection);
         }
+    });
+}
+
+void BasicGraphicsScene::onUndoIndexChanged(int const index)
+{
+    // Rebuilding the history changes the index of the stack again.
+    if (_trimmingUndoHistory)
+        return;
+
+    int const count = _undoStack->count();
+    int const accounted = static_cast<int>(_undoCommandSizes.size());
+
+    // Only the commands around the index change. A push removes the redo
+    // side and appends a command or merges into the top one, undo and redo
+    // update the commands they run. With an undo limit, a push may also drop
+    // commands from the bottom, which shifts all the others.
+    int first = 0;
+    int last = count;
+
+    if (_undoStack->undoLimit() > 0) {
+        // Recount everything.
+    } else if (count == accounted) {
+        first = std::min(index, _accountedUndoIndex);
+        last = std::max(index, _accountedUndoIndex);
+
+        if (first == last)
+            --first;
+    } else {
+        first = std::min(accounted, index - 1);
     }
+
+    first = std::max(first, 0);
+
+    for (int i = count; i < accounted; ++i) {
+        _undoCommandBytes -= _undoCommandSizes[i];
+    }
+
+    _undoCommandSizes.resize(count, 0);
+
+    for (int i = first; i < last; ++i) {
+        _undoCommandBytes -= _undoCommandSizes[i];
+        _undoCommandSizes[i] = commandMemoryUsage(_undoStack->command(i));
+        _undoCommandBytes += _undoCommandSizes[i];
+    }
+
+    _accountedUndoIndex = index;
+
+    enforceUndoMemoryBudget();
+}
+
+void BasicGraphicsScene::enforceUndoMemoryBudget()
+{
+    if (_undoMemoryBudget == 0 || _trimmingUndoHistory)
+        return;
+
+    std::size_t commandBytes = _undoCommandBytes;
+
+    auto overBudget = [&]() {
+        return commandBytes + _undoPayloadStore->residentBytes() > _undoMemoryBudget;
+    };
+
+    if (!overBudget())
+        return;
+
+    // Spilling keeps the whole history, so it comes first.
+    _undoPayloadStore->spill(commandBytes < _undoMemoryBudget ? _undoMemoryBudget - commandBytes
+                                                              : 0);
+
+    // The most recent done command is always kept.
+    if (!overBudget() || _undoStack->index() < 2)
+        return;
+
+    // QUndoStack only drops commands from its bottom when it is pushed beyond
+    // its undo limit, which cannot change once the stack holds commands. The
+    // history is therefore rebuilt from the state of the commands, in order.
+    for (int i = 0; i < _undoStack->count(); ++i) {
+        // Commands of the application cannot be carried over.
+        if (!dynamic_cast<SceneUndoCommand const *>(_undoStack->command(i)))
+            return;
+    }
+
+    int const index = _undoStack->index();
+    int const cleanIndex = _undoStack->cleanIndex();
+
+    std::deque<std::unique_ptr<SceneUndoCommand>> commands;
+    std::deque<std::size_t> sizes;
+    commandBytes = 0;
+
+    for (int i = 0; i < _undoStack->count(); ++i) {
+        // QUndoStack only gives out const access to its commands.
+        auto command = static_cast<SceneUndoCommand *>(
+            const_cast<QUndoCommand *>(_undoStack->command(i)));
+
+        commands.emplace_back(command->takeState());
+        commands.back()->setText(command->text());
+        sizes.push_back(commands.back()->memoryUsage());
+        commandBytes += sizes.back();
+    }
+
+    // Dropping a command releases the payloads only it was holding.
+    int dropped = 0;
+
+    while (dropped + 1 < index && overBudget()) {
+        commandBytes -= sizes.front();
+        commands.pop_front();
+        sizes.pop_front();
+        ++dropped;
+    }
+
+    _trimmingUndoHistory = true;
+
+    _undoStack->clear();
+
+    if (cleanIndex != dropped)
+        _undoStack->resetClean();
+
+    for (auto &command : commands) {
+        command->setSuspended(true);
+        _undoStack->push(command.release());
+
+        if (_undoStack->index() == cleanIndex - dropped)
+            _undoStack->setClean();
+    }
+
+    // Puts the undone commands back on the redo side.
+    _undoStack->setIndex(index - dropped);
+
+    for (int i = 0; i < _undoStack->count(); ++i) {
+        static_cast<SceneUndoCommand *>(const_cast<QUndoCommand *>(_undoStack->command(i)))
+            ->setSuspended(false);
+    }
+
+    _undoCommandSizes.assign(sizes.begin(), sizes.end());
+    _undoCommandBytes = commandBytes;
+    _accountedUndoIndex = _undoStack->index();
+
+    _trimmingUndoHistory = false;
 }
 
 void BasicGraphicsScene::updateAttachedNodes(ConnectionId const connectionId,
@@ -237,13 +592,15 @@ void BasicGraphicsScene::updateAttachedNodes(ConnectionId const connectionId,
     }
 }
 
-void BasicGraphicsScene::onConnectionDeleted(ConnectionId const connectionId)
+void BasicGraphicsScene::removeConnectionObject(ConnectionId const connectionId)
 {
     auto it = _connectionGraphicsObjects.find(connectionId);
     if (it != _connectionGraphicsObjects.end()) {
         _connectionGraphicsObjects.erase(it);
     }
 
+    _connectionIndex->remove(connectionId);
+
     // TODO: do we need it?
     if (_draftConnection && _draftConnection->connectionId() == connectionId) {
         _draftConnection.reset();
@@ -251,62 +608,163 @@ void BasicGraphicsScene::onConnectionDeleted(ConnectionId const connectionId)
 
     updateAttachedNodes(connectionId, PortType::Out);
     updateAttachedNodes(connectionId, PortType::In);
-
-    Q_EMIT modified(this);
 }
 
-void BasicGraphicsScene::onConnectionCreated(ConnectionId const connectionId)
+void BasicGraphicsScene::createConnectionObject(ConnectionId const connectionId)
 {
     _connectionGraphicsObjects[connectionId]
         = std::make_unique<ConnectionGraphicsObject>(*this, connectionId);
+    updateConnectionIndex(connectionId);
 
     updateAttachedNodes(connectionId, PortType::Out);
     updateAttachedNodes(connectionId, PortType::In);
+}
+
+bool BasicGraphicsScene::removeNodeObject(NodeId const nodeId)
+{
+    auto it = _nodeGraphicsObjects.find(nodeId);
+    if (it == _nodeGraphicsObjects.end())
+        return false;
+
+    _nodeGraphicsObjects.erase(it);
+    _nodeIndex->remove(nodeId);
+    _nodeGeometry->invalidate(nodeId);
+
+    return true;
+}
+
+void BasicGraphicsScene::createNodeObject(NodeId const nodeId)
+{
+    _nodeGraphicsObjects[nodeId] = std::make_unique<NodeGraphicsObject>(*this, nodeId);
+    updateNodeIndex(nodeId);
+}
+
+void BasicGraphicsScene::onConnectionDeleted(ConnectionId const connectionId)
+{
+    if (_graphModel.inBatch())
+        return;
+
+    removeConnectionObject(connectionId);
+
+    Q_EMIT modified(this);
+}
+
+void BasicGraphicsScene::onConnectionCreated(ConnectionId const connectionId)
+{
+    if (_graphModel.inBatch())
+        return;
+
+    createConnectionObject(connectionId);
 
     Q_EMIT modified(this);
 }
 
 void BasicGraphicsScene::onNodeDeleted(NodeId const nodeId)
 {
-    auto it = _nodeGraphicsObjects.find(nodeId);
-    if (it != _nodeGraphicsObjects.end()) {
-        _nodeGraphicsObjects.erase(it);
+    if (_graphModel.inBatch())
+        return;
 
+    if (removeNodeObject(nodeId))
         Q_EMIT modified(this);
-    }
 }
 
 void BasicGraphicsScene::onNodeCreated(NodeId const nodeId)
 {
-    _nodeGraphicsObjects[nodeId] = std::make_unique<NodeGraphicsObject>(*this, nodeId);
+    if (_graphModel.inBatch())
+        return;
+
+    createNodeObject(nodeId);
 
     Q_EMIT modified(this);
 }
 
 void BasicGraphicsScene::onNodePositionUpdated(NodeId const nodeId)
 {
+    if (_graphModel.inBatch())
+        return;
+
     auto node = nodeGraphicsObject(nodeId);
     if (node) {
         node->setPos(_graphModel.nodeData(nodeId, NodeRole::Position).value<QPointF>());
+        updateNodeIndex(nodeId);
         node->update();
         _nodeDrag = true;
     }
 }
 
+void BasicGraphicsScene::onNodePositionsUpdated(std::vector<NodeId> const &nodeIds)
+{
+    if (_graphModel.inBatch())
+        return;
+
+    for (NodeId const nodeId : nodeIds) {
+        if (NodeGraphicsObject *node = nodeGraphicsObject(nodeId)) {
+            // No-op for the items already moved by a drag.
+            node->setPos(_graphModel.nodeData<QPointF>(nodeId, NodeRole::Position));
+            updateNodeIndex(nodeId);
+        }
+    }
+
+    if (!nodeIds.empty())
+        _nodeDrag = true;
+}
+
 void BasicGraphicsScene::onNodeUpdated(NodeId const nodeId)
 {
+    if (_graphModel.inBatch())
+        return;
+
     auto node = nodeGraphicsObject(nodeId);
 
     if (node) {
         node->setGeometryChanged();
 
+        _nodeGeometry->invalidate(nodeId);
         _nodeGeometry->recomputeSize(nodeId);
+        updateNodeIndex(nodeId);
 
         node->update();
         node->moveConnections();
     }
 }
 
+void BasicGraphicsScene::onBatchCommitted(GraphChangeSet const &changes)
+{
+    if (changes.reset) {
+        onModelReset();
+        return;
+    }
+
+    for (ConnectionId const &connectionId : changes.deletedConnections) {
+        removeConnectionObject(connectionId);
+    }
+
+    for (NodeId const nodeId : changes.deletedNodes) {
+        removeNodeObject(nodeId);
+    }
+
+    for (NodeId const nodeId : changes.createdNodes) {
+        createNodeObject(nodeId);
+    }
+
+    for (ConnectionId const &connectionId : changes.createdConnections) {
+        createConnectionObject(connectionId);
+    }
+
+    for (NodeId const nodeId : changes.movedNodes) {
+        if (NodeGraphicsObject *node = nodeGraphicsObject(nodeId)) {
+            node->setPos(_graphModel.nodeData<QPointF>(nodeId, NodeRole::Position));
+            updateNodeIndex(nodeId);
+        }
+    }
+
+    for (NodeId const nodeId : changes.updatedNodes) {
+        onNodeUpdated(nodeId);
+    }
+
+    Q_EMIT modified(this);
+}
+
 void BasicGraphicsScene::onNodeClicked(NodeId const nodeId)
 {
     if (_nodeDrag) {
@@ -318,8 +776,17 @@ void BasicGraphicsScene::onNodeClicked(NodeId const nodeId)
 
 void BasicGraphicsScene::onModelReset()
 {
+    if (_graphModel.inBatch())
+        return;
+
+    _draggedNodes.clear();
+    _dragOffset = QPointF();
+
     _connectionGraphicsObjects.clear();
     _nodeGraphicsObjects.clear();
+    _nodeIndex->clear();
+    _connectionIndex->clear();
+    _nodeGeometry->invalidateAll();
 
     clear();
 
@@ -31,6 +31,8 @@ ConnectionGraphicsObject::ConnectionGraphicsObject(BasicGraphicsScene &scene,
     , _connectionState(*this)
     , _out{0, 0}
     , _in{0, 0}
+    , _pathValid(false)
+    , _shapeValid(false)
 {
     scene.addItem(this);
 
@@ -98,8 +100,22 @@ ConnectionId const &ConnectionGraphicsObject::connectionId() const
 
 QRectF ConnectionGraphicsObject::boundingRect() const
 {
+    // Computed together with the path.
+    path();
+
+    return _boundingRect;
+}
+
+QPainterPath const &ConnectionGraphicsObject::path() const
+{
+    if (_pathValid)
+        return _path;
+
     auto points = pointsC1C2();
 
+    _path = QPainterPath(_out);
+    _path.cubicTo(points.first, points.second, _in);
+
     // `normalized()` fixes inverted rects.
     QRectF basicRect = QRectF(_out, _in).normalized();
 
@@ -115,7 +131,10 @@ QRectF ConnectionGraphicsObject::boundingRect() const
     commonRect.setTopLeft(commonRect.topLeft() - cornerOffset);
     commonRect.setBottomRight(commonRect.bottomRight() + 2 * cornerOffset);
 
-    return commonRect;
+    _boundingRect = commonRect;
+    _pathValid = true;
+
+    return _path;
 }
 
 QPainterPath ConnectionGraphicsObject::shape() const
@@ -128,7 +147,12 @@ QPainterPath ConnectionGraphicsObject::shape() const
     //return path;
 
 #else
-    return ConnectionPainter::getPainterStroke(*this);
+    if (!_shapeValid) {
+        _shape = ConnectionPainter::getPainterStroke(*this);
+        _shapeValid = true;
+    }
+
+    return _shape;
 #endif
 }
 
@@ -145,10 +169,21 @@ void ConnectionGraphicsObject::setEndPoint(PortType portType, QPointF const &poi
         _in = point;
     else
         _out = point;
+
+    invalidateGeometry();
+}
+
+void ConnectionGraphicsObject::invalidateGeometry()
+{
+    _pathValid = false;
+    _shapeValid = false;
 }
 
 void ConnectionGraphicsObject::move()
 {
+    // The scene needs the old bounding rect to repaint the area left behind.
+    prepareGeometryChange();
+
     auto moveEnd = [this](ConnectionId cId, PortType portType) {
         NodeId nodeId = getNodeId(portType, cId);
 
@@ -174,7 +209,8 @@ void ConnectionGraphicsObject::move()
     moveEnd(_connectionId, PortType::Out);
     moveEnd(_connectionId, PortType::In);
 
-    prepareGeometryChange();
+    if (BasicGraphicsScene *scene = nodeScene())
+        scene->updateConnectionIndex(_connectionId);
 
     update();
 }
@@ -1,6 +1,8 @@
 #include "ConnectionPainter.hpp"
 
 #include <QtGui/QIcon>
+#include <QtGui/QPixmapCache>
+#include <QtWidgets/QStyleOptionGraphicsItem>
 
 #include "AbstractGraphModel.hpp"
 #include "ConnectionGraphicsObject.hpp"
@@ -9,26 +11,13 @@
 #include "NodeData.hpp"
 #include "StyleCollection.hpp"
 
-namespace QtNodes {
-
-static QPainterPath cubicPath(ConnectionGraphicsObject const &connection)
-{
-    QPointF const &in = connection.endPoint(PortType::In);
-    QPointF const &out = connection.endPoint(PortType::Out);
-
-    auto const c1c2 = connection.pointsC1C2();
-
-    // cubic spline
-    QPainterPath cubic(out);
+#include <utility>
 
-    cubic.cubicTo(c1c2.first, c1c2.second, in);
-
-    return cubic;
-}
+namespace QtNodes {
 
 QPainterPath ConnectionPainter::getPainterStroke(ConnectionGraphicsObject const &connection)
 {
-    auto cubic = cubicPath(connection);
+    QPainterPath const &cubic = connection.path();
 
     QPointF const &out = connection.endPoint(PortType::Out);
     QPainterPath result(out);
@@ -67,7 +56,7 @@ static void debugDrawing(QPainter *painter, ConnectionGraphicsObject const &cgo)
         painter->drawEllipse(points.second, 3, 3);
 
         painter->setBrush(Qt::NoBrush);
-        painter->drawPath(cubicPath(cgo));
+        painter->drawPath(cgo.path());
     }
 
     {
@@ -93,10 +82,8 @@ static void drawSketchLine(QPainter *painter, ConnectionGraphicsObject const &cg
         painter->setPen(pen);
         painter->setBrush(Qt::NoBrush);
 
-        auto cubic = cubicPath(cgo);
-
         // cubic spline
-        painter->drawPath(cubic);
+        painter->drawPath(cgo.path());
     }
 }
 
@@ -120,9 +107,47 @@ static void drawHoveredOrSelected(QPainter *painter, ConnectionGraphicsObject co
         painter->setBrush(Qt::NoBrush);
 
         // cubic spline
-        auto const cubic = cubicPath(cgo);
-        painter->drawPath(cubic);
+        painter->drawPath(cgo.path());
+    }
+}
+
+/// Splits the connection spline at its parameter midpoint (de Casteljau).
+static std::pair<QPainterPath, QPainterPath> halfPaths(ConnectionGraphicsObject const &cgo)
+{
+    QPointF const &out = cgo.endPoint(PortType::Out);
+    QPointF const &in = cgo.endPoint(PortType::In);
+
+    auto const c1c2 = cgo.pointsC1C2();
+
+    QPointF const p01 = (out + c1c2.first) / 2.0;
+    QPointF const p12 = (c1c2.first + c1c2.second) / 2.0;
+    QPointF const p23 = (c1c2.second + in) / 2.0;
+    QPointF const p012 = (p01 + p12) / 2.0;
+    QPointF const p123 = (p12 + p23) / 2.0;
+    QPointF const middle = (p012 + p123) / 2.0;
+
+    QPainterPath first(out);
+    first.cubicTo(p01, p012, middle);
+
+    QPainterPath second(middle);
+    second.cubicTo(p123, p23, in);
+
+    return std::make_pair(first, second);
+}
+
+/// The icon drawn in the middle of connections between different data types.
+static QPixmap convertPixmap()
+{
+    static QString const key = QStringLiteral("QtNodes/convert");
+
+    QPixmap pixmap;
+
+    if (!QPixmapCache::find(key, &pixmap)) {
+        pixmap = QIcon(":convert.png").pixmap(QSize(22, 22));
+        QPixmapCache::insert(key, pixmap);
     }
+
+    return pixmap;
 }
 
 static void drawNormalLine(QPainter *painter, ConnectionGraphicsObject const &cgo)
@@ -160,10 +185,10 @@ static void drawNormalLine(QPainter *painter, ConnectionGraphicsObject const &cg
             = graphModel.portData(cId.inNodeId, PortType::In, cId.inPortIndex, PortRole::DataType)
                   .value<NodeDataType>();
 
-        useGradientColor = (dataTypeOut.id != dataTypeIn.id);
+        useGradientColor = !dataTypeOut.sameType(dataTypeIn);
 
-        normalColorOut = connectionStyle.normalColor(dataTypeOut.id);
-        normalColorIn = connectionStyle.normalColor(dataTypeIn.id);
+        normalColorOut = connectionStyle.normalColor(dataTypeOut);
+        normalColorIn = connectionStyle.normalColor(dataTypeIn);
         selectedColor = normalColorOut.darker(200);
     }
 
@@ -178,41 +203,32 @@ static void drawNormalLine(QPainter *painter, ConnectionGraphicsObject const &cg
 
     bool const selected = cgo.isSelected();
 
-    auto cubic = cubicPath(cgo);
     if (useGradientColor) {
         painter->setBrush(Qt::NoBrush);
 
         QColor cOut = normalColorOut;
-        if (selected)
+        QColor cIn = normalColorIn;
+        if (selected) {
             cOut = cOut.darker(200);
-        p.setColor(cOut);
-        painter->setPen(p);
-
-        unsigned int const segments = 60;
+            cIn = cIn.darker(200);
+        }
 
-        for (unsigned int i = 0ul; i < segments; ++i) {
-            double ratioPrev = double(i) / segments;
-            double ratio = double(i + 1) / segments;
+        // The out half is drawn in the out type color, the in half in the in
+        // type color.
+        auto const halves = halfPaths(cgo);
 
-            if (i == segments / 2) {
-                QColor cIn = normalColorIn;
-                if (selected)
-                    cIn = cIn.darker(200);
+        p.setColor(cOut);
+        painter->setPen(p);
+        painter->drawPath(halves.first);
 
-                p.setColor(cIn);
-                painter->setPen(p);
-            }
-            painter->drawLine(cubic.pointAtPercent(ratioPrev), cubic.pointAtPercent(ratio));
-        }
+        p.setColor(cIn);
+        painter->setPen(p);
+        painter->drawPath(halves.second);
 
-        {
-            QIcon icon(":convert.png");
+        QPixmap const pixmap = convertPixmap();
+        QPointF const middle = halves.second.elementAt(0);
 
-            QPixmap pixmap = icon.pixmap(QSize(22, 22));
-            painter->drawPixmap(cubic.pointAtPercent(0.50)
-                                    - QPoint(pixmap.width() / 2, pixmap.height() / 2),
-                                pixmap);
-        }
+        painter->drawPixmap(middle - QPointF(pixmap.width() / 2, pixmap.height() / 2), pixmap);
     } else {
         p.setColor(normalColorOut);
 
@@ -223,12 +239,35 @@ static void drawNormalLine(QPainter *painter, ConnectionGraphicsObject const &cg
         painter->setPen(p);
         painter->setBrush(Qt::NoBrush);
 
-        painter->drawPath(cubic);
+        painter->drawPath(cgo.path());
     }
 }
 
+static void drawSimplifiedLine(QPainter *painter, ConnectionGraphicsObject const &cgo)
+{
+    auto const &connectionStyle = QtNodes::StyleCollection::connectionStyle();
+
+    QPen pen(cgo.isSelected() ? connectionStyle.selectedHaloColor()
+                              : connectionStyle.normalColor());
+    pen.setWidthF(connectionStyle.lineWidth());
+
+    painter->setPen(pen);
+    painter->drawLine(cgo.endPoint(PortType::Out), cgo.endPoint(PortType::In));
+}
+
 void ConnectionPainter::paint(QPainter *painter, ConnectionGraphicsObject const &cgo)
 {
+    auto const &style = QtNodes::StyleCollection::connectionStyle();
+
+    qreal const lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+        painter->worldTransform());
+
+    // Draft connections are always drawn in full, they follow the cursor.
+    if (lod < style.simplifiedLevelOfDetail() && !cgo.connectionState().requiresPort()) {
+        drawSimplifiedLine(painter, cgo);
+        return;
+    }
+
     drawHoveredOrSelected(painter, cgo);
 
     drawSketchLine(painter, cgo);
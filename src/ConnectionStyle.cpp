@@ -85,6 +85,13 @@ void ConnectionStyle::setConnectionStyle(QString jsonText)
             variable = valueRef.toDouble(); \
     }
 
+#define CONNECTION_STYLE_READ_OPTIONAL_FLOAT(values, variable) \
+    { \
+        auto valueRef = values[#variable]; \
+        if (valueRef.isDouble()) \
+            variable = valueRef.toDouble(); \
+    }
+
 #define CONNECTION_STYLE_WRITE_FLOAT(values, variable) \
     { \
         values[#variable] = variable; \
@@ -103,6 +110,21 @@ void ConnectionStyle::setConnectionStyle(QString jsonText)
         values[#variable] = variable; \
     }
 
+/// Accepts the same color notations as the CONNECTION_STYLE_READ_COLOR macro.
+static QColor colorFromJson(QJsonValue const &value)
+{
+    if (value.isArray()) {
+        QJsonArray const rgb = value.toArray();
+
+        if (rgb.size() < 3)
+            return QColor();
+
+        return QColor(rgb[0].toInt(), rgb[1].toInt(), rgb[2].toInt());
+    }
+
+    return QColor(value.toString());
+}
+
 void ConnectionStyle::loadJson(QJsonObject const &json)
 {
     QJsonValue nodeStyleValues = json["ConnectionStyle"];
@@ -118,8 +140,24 @@ void ConnectionStyle::loadJson(QJsonObject const &json)
     CONNECTION_STYLE_READ_FLOAT(obj, LineWidth);
     CONNECTION_STYLE_READ_FLOAT(obj, ConstructionLineWidth);
     CONNECTION_STYLE_READ_FLOAT(obj, PointDiameter);
+    CONNECTION_STYLE_READ_OPTIONAL_FLOAT(obj, SimplifiedLevelOfDetail);
 
     CONNECTION_STYLE_READ_BOOL(obj, UseDataDefinedColors);
+
+    // A loaded style replaces the pinned colors, it does not add to them.
+    DataTypeColors.clear();
+
+    QJsonObject const typeColors = obj["DataTypeColors"].toObject();
+    for (auto it = typeColors.begin(); it != typeColors.end(); ++it) {
+        QColor const color = colorFromJson(it.value());
+
+        if (color.isValid())
+            DataTypeColors[it.key()] = color;
+    }
+
+    _dataTypeColorIndices.clear();
+    _dataTypeColorTable.clear();
+    _dataTypeHandleColorIndices.clear();
 }
 
 QJsonObject ConnectionStyle::toJson() const
@@ -135,9 +173,18 @@ QJsonObject ConnectionStyle::toJson() const
     CONNECTION_STYLE_WRITE_FLOAT(obj, LineWidth);
     CONNECTION_STYLE_WRITE_FLOAT(obj, ConstructionLineWidth);
     CONNECTION_STYLE_WRITE_FLOAT(obj, PointDiameter);
+    CONNECTION_STYLE_WRITE_FLOAT(obj, SimplifiedLevelOfDetail);
 
     CONNECTION_STYLE_WRITE_BOOL(obj, UseDataDefinedColors);
 
+    if (!DataTypeColors.isEmpty()) {
+        QJsonObject typeColors;
+        for (auto it = DataTypeColors.begin(); it != DataTypeColors.end(); ++it) {
+            typeColors[it.key()] = it.value().name();
+        }
+        obj["DataTypeColors"] = typeColors;
+    }
+
     QJsonObject root;
     root["ConnectionStyle"] = obj;
 
@@ -154,7 +201,33 @@ QColor ConnectionStyle::normalColor() const
     return NormalColor;
 }
 
-QColor ConnectionStyle::normalColor(QString typeId) const
+QColor ConnectionStyle::normalColor(QString const &typeId) const
+{
+    return dataTypeColor(dataTypeColorIndex(typeId));
+}
+
+QColor ConnectionStyle::normalColor(NodeDataType const &dataType) const
+{
+    NodeDataTypeHandle const typeHandle = dataType.handle();
+
+    if (typeHandle == InvalidNodeDataTypeHandle)
+        return normalColor(dataType.id);
+
+    std::size_t const handle = static_cast<std::size_t>(typeHandle);
+
+    if (handle >= _dataTypeHandleColorIndices.size())
+        _dataTypeHandleColorIndices.resize(handle + 1, -1);
+
+    int &index = _dataTypeHandleColorIndices[handle];
+
+    if (index < 0)
+        index = dataTypeColorIndex(dataType.id);
+
+    return _dataTypeColorTable[index];
+}
+
+/// The color of a type without a pinned one, stable across runs.
+static QColor derivedColor(QString const &typeId)
 {
     std::size_t hash = qHash(typeId);
 
@@ -169,6 +242,49 @@ QColor ConnectionStyle::normalColor(QString typeId) const
     return QColor::fromHsl(hue, sat, 160);
 }
 
+int ConnectionStyle::dataTypeColorIndex(QString const &typeId) const
+{
+    auto it = _dataTypeColorIndices.constFind(typeId);
+    if (it != _dataTypeColorIndices.constEnd())
+        return it.value();
+
+    QColor color = DataTypeColors.value(typeId);
+
+    if (!color.isValid())
+        color = derivedColor(typeId);
+
+    int const index = static_cast<int>(_dataTypeColorTable.size());
+
+    _dataTypeColorTable.push_back(color);
+    _dataTypeColorIndices.insert(typeId, index);
+
+    return index;
+}
+
+QColor const &ConnectionStyle::dataTypeColor(int index) const
+{
+    Q_ASSERT(index >= 0 && index < static_cast<int>(_dataTypeColorTable.size()));
+
+    return _dataTypeColorTable[index];
+}
+
+void ConnectionStyle::setDataTypeColor(QString const &typeId, QColor const &color)
+{
+    if (color.isValid())
+        DataTypeColors[typeId] = color;
+    else
+        DataTypeColors.remove(typeId);
+
+    auto it = _dataTypeColorIndices.constFind(typeId);
+    if (it != _dataTypeColorIndices.constEnd())
+        _dataTypeColorTable[it.value()] = color.isValid() ? color : derivedColor(typeId);
+}
+
+QHash<QString, QColor> const &ConnectionStyle::dataTypeColors() const
+{
+    return DataTypeColors;
+}
+
 QColor ConnectionStyle::selectedColor() const
 {
     return SelectedColor;
@@ -199,6 +315,11 @@ float ConnectionStyle::pointDiameter() const
     return PointDiameter;
 }
 
+float ConnectionStyle::simplifiedLevelOfDetail() const
+{
+    return SimplifiedLevelOfDetail;
+}
+
 bool ConnectionStyle::useDataDefinedColors() const
 {
     return UseDataDefinedColors;
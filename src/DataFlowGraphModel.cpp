@@ -1,55 +1,245 @@
 #include "DataFlowGraphModel.hpp"
 #include "ConnectionIdHash.hpp"
+#include "DataFlowScheduler.hpp"
+#include "WorkStealingThreadPool.hpp"
 
+#include <QDebug>
 #include <QJsonArray>
+#include <QJsonDocument>
+#include <QDataStream>
 #include <QGraphicsItem>
+#include <QThread>
 
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
+#include <QCborMap>
+#include <QCborValue>
+#endif
+
+#include <algorithm>
+#include <deque>
 #include <stdexcept>
 
 namespace QtNodes {
 
+namespace {
+
+/// Collects the ports updated by a model running on a pool worker.
+thread_local std::vector<PortIndex> *workerEmissions = nullptr;
+
+/// "QNGF", first bytes of a binary flow file.
+constexpr quint32 BinaryMagic = 0x514E4746;
+
+constexpr quint16 BinaryFormatVersion = 1;
+
+/// How the per-node payload blobs of a binary flow file are encoded.
+enum class PayloadEncoding : quint8 {
+    CompactJson = 0,
+    Cbor = 1,
+};
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
+constexpr PayloadEncoding DefaultPayloadEncoding = PayloadEncoding::Cbor;
+#else
+constexpr PayloadEncoding DefaultPayloadEncoding = PayloadEncoding::CompactJson;
+#endif
+
+QByteArray encodePayload(QJsonObject const &internalData)
+{
+    // Most nodes only store their model name, which lives in the string table.
+    if (internalData.isEmpty())
+        return QByteArray();
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
+    return QCborValue::fromJsonValue(internalData).toCbor();
+#else
+    return QJsonDocument(internalData).toJson(QJsonDocument::Compact);
+#endif
+}
+
+bool payloadEncodingSupported(quint8 const encoding)
+{
+    switch (static_cast<PayloadEncoding>(encoding)) {
+    case PayloadEncoding::CompactJson:
+        return true;
+
+    case PayloadEncoding::Cbor:
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
+        return true;
+#else
+        // Written by a newer Qt, cannot be read here.
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+bool decodePayload(QByteArray const &payload, quint8 const encoding, QJsonObject &internalData)
+{
+    if (payload.isEmpty()) {
+        internalData = QJsonObject();
+        return true;
+    }
+
+    switch (static_cast<PayloadEncoding>(encoding)) {
+    case PayloadEncoding::CompactJson: {
+        QJsonParseError error;
+        QJsonDocument const document = QJsonDocument::fromJson(payload, &error);
+
+        if (error.error != QJsonParseError::NoError || !document.isObject())
+            return false;
+
+        internalData = document.object();
+        return true;
+    }
+
+    case PayloadEncoding::Cbor:
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
+    {
+        QCborParserError error;
+        QCborValue const value = QCborValue::fromCbor(payload, &error);
+
+        if (error.error != QCborError::NoError || !value.isMap())
+            return false;
+
+        internalData = value.toMap().toJsonObject();
+        return true;
+    }
+#else
+        // Written by a newer Qt, cannot be read here.
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+} // namespace
+
+struct DataFlowGraphModel::ExecutionPass
+{
+    using Inputs = std::vector<std::pair<PortIndex, std::shared_ptr<NodeData>>>;
+
+    /// Affected nodes, in topological order.
+    std::vector<NodeId> order;
+
+    /// Incoming connections from nodes of `order` which are not settled yet.
+    std::unordered_map<NodeId, std::size_t> pendingUpstream;
+
+    /// Latest data per input port, collected from the upstream nodes.
+    std::unordered_map<NodeId, Inputs> inbox;
+
+    std::deque<NodeId> ready;
+
+    std::unordered_set<NodeId> started;
+
+    /// Nodes being evaluated on a worker thread, with the generation of their
+    /// asynchronous run or `0` for a thread-safe `setInData()`.
+    std::unordered_map<NodeId, std::uint64_t> running;
+
+    std::unordered_set<NodeId> settled;
+
+    /// Models deleted while a worker was still using them.
+    std::vector<std::unique_ptr<NodeDelegateModel>> retired;
+
+    /// Cancelled when the model is destroyed, the queued evaluations of the
+    /// pass are then skipped.
+    CancellationToken token;
+};
+
 DataFlowGraphModel::DataFlowGraphModel(std::shared_ptr<NodeDelegateModelRegistry> registry)
     : _registry(std::move(registry))
     , _nextNodeId{0}
 {}
 
+DataFlowGraphModel::~DataFlowGraphModel()
+{
+    // Asynchronous runs, those of the current pass included, are asked to
+    // stop so that joining the workers does not wait for long jobs.
+    for (auto &p : _asyncRuns) {
+        p.second.token.cancel();
+    }
+
+    _asyncRuns.clear();
+
+    if (_pass)
+        _pass->token.cancel();
+
+    // Workers may still reference the models, let them finish first.
+    _threadPool.reset();
+}
+
 std::unordered_set<NodeId> DataFlowGraphModel::allNodeIds() const
 {
-    std::unordered_set<NodeId> nodeIds;
-    for_each(_models.begin(), _models.end(), [&nodeIds](auto const &p) { nodeIds.insert(p.first); });
+    std::vector<NodeId> const &ids = _nodes.ids();
 
-    return nodeIds;
+    return std::unordered_set<NodeId>(ids.begin(), ids.end());
 }
 
 std::unordered_set<ConnectionId> DataFlowGraphModel::allConnectionIds(NodeId const nodeId) const
 {
-    std::unordered_set<ConnectionId> result;
+    auto it = _nodeConnections.find(nodeId);
 
-    std::copy_if(_connectivity.begin(),
-                 _connectivity.end(),
-                 std::inserter(result, std::end(result)),
-                 [&nodeId](ConnectionId const &cid) {
-                     return cid.inNodeId == nodeId || cid.outNodeId == nodeId;
-                 });
+    if (it == _nodeConnections.end())
+        return {};
 
-    return result;
+    return it->second;
 }
 
 std::unordered_set<ConnectionId> DataFlowGraphModel::connections(NodeId nodeId,
                                                                  PortType portType,
                                                                  PortIndex portIndex) const
 {
-    std::unordered_set<ConnectionId> result;
+    auto it = _portConnections.find(PortKey{nodeId, portType, portIndex});
 
-    std::copy_if(_connectivity.begin(),
-                 _connectivity.end(),
-                 std::inserter(result, std::end(result)),
-                 [&portType, &portIndex, &nodeId](ConnectionId const &cid) {
-                     return (getNodeId(portType, cid) == nodeId
-                             && getPortIndex(portType, cid) == portIndex);
-                 });
+    if (it == _portConnections.end())
+        return {};
 
-    return result;
+    return it->second;
+}
+
+void DataFlowGraphModel::forEachNode(NodeVisitor const &visitor) const
+{
+    for (NodeId const nodeId : _nodes.ids()) {
+        visitor(nodeId);
+    }
+}
+
+void DataFlowGraphModel::forEachNodeConnection(NodeId const nodeId,
+                                               ConnectionVisitor const &visitor) const
+{
+    auto it = _nodeConnections.find(nodeId);
+
+    if (it == _nodeConnections.end())
+        return;
+
+    for (ConnectionId const &connectionId : it->second) {
+        visitor(connectionId);
+    }
+}
+
+void DataFlowGraphModel::forEachConnection(NodeId const nodeId,
+                                           PortType const portType,
+                                           PortIndex const portIndex,
+                                           ConnectionVisitor const &visitor) const
+{
+    auto it = _portConnections.find(PortKey{nodeId, portType, portIndex});
+
+    if (it == _portConnections.end())
+        return;
+
+    for (ConnectionId const &connectionId : it->second) {
+        visitor(connectionId);
+    }
+}
+
+std::size_t DataFlowGraphModel::connectionCount(NodeId const nodeId,
+                                                PortType const portType,
+                                                PortIndex const portIndex) const
+{
+    auto it = _portConnections.find(PortKey{nodeId, portType, portIndex});
+
+    return (it == _portConnections.end()) ? 0 : it->second.size();
 }
 
 bool DataFlowGraphModel::connectionExists(ConnectionId const connectionId) const
@@ -67,32 +257,37 @@ NodeId DataFlowGraphModel::addNode(QString const nodeType)
         connect(model.get(),
                 &NodeDelegateModel::dataUpdated,this,
                 [newId, this](PortIndex const portIndex,bool bContinue) {
-                    onOutPortDataUpdated(newId, portIndex,bContinue);
-                },Qt::QueuedConnection);
+                    onNodeDataUpdated(newId, portIndex, bContinue);
+                },
+                Qt::DirectConnection);
 
         connect(model.get(),
                 &NodeDelegateModel::portsAboutToBeDeleted,
                 this,
                 [newId, this](PortType const portType, PortIndex const first, PortIndex const last) {
+                    // Port indices are about to shift.
+                    _inputStamps.erase(newId);
                     portsAboutToBeDeleted(newId, portType, first, last);
                 });
 
-        connect(model.get(),
-                &NodeDelegateModel::portsDeleted,
-                this,
-                &DataFlowGraphModel::portsDeleted);
+        connect(model.get(), &NodeDelegateModel::portsDeleted, this, [newId, this]() {
+            portsDeleted();
+            // Port positions and the node size depend on the port count.
+            Q_EMIT nodeUpdated(newId);
+        });
 
         connect(model.get(),
                 &NodeDelegateModel::portsAboutToBeInserted,
                 this,
                 [newId, this](PortType const portType, PortIndex const first, PortIndex const last) {
+                    _inputStamps.erase(newId);
                     portsAboutToBeInserted(newId, portType, first, last);
                 });
 
-        connect(model.get(),
-                &NodeDelegateModel::portsInserted,
-                this,
-                &DataFlowGraphModel::portsInserted);
+        connect(model.get(), &NodeDelegateModel::portsInserted, this, [newId, this]() {
+            portsInserted();
+            Q_EMIT nodeUpdated(newId);
+        });
 
         connect(model.get(), &NodeDelegateModel::computingStarted, this, [newId, this]() {
             Q_EMIT computingStarted(newId);
@@ -109,7 +304,7 @@ NodeId DataFlowGraphModel::addNode(QString const nodeType)
             Q_EMIT inPortDataWasSet(newId, PortType::In, 0);
         });
 
-        _models[newId] = std::move(model);
+        insertNode(newId, std::move(model));
 
         Q_EMIT nodeCreated(newId);
 
@@ -136,45 +331,138 @@ bool DataFlowGraphModel::connectionPossible(ConnectionId const connectionId) con
     auto portVacant = [&](PortType const portType) {
         NodeId const nodeId = getNodeId(portType, connectionId);
         PortIndex const portIndex = getPortIndex(portType, connectionId);
-        auto const connected = connections(nodeId, portType, portIndex);
+
+        if (connectionCount(nodeId, portType, portIndex) == 0)
+            return true;
 
         auto policy = portData(nodeId, portType, portIndex, PortRole::ConnectionPolicyRole)
                           .value<ConnectionPolicy>();
 
-        return connected.empty() || (policy == ConnectionPolicy::Many);
+        return policy == ConnectionPolicy::Many;
+    };
+
+    auto typesCompatible = [&]() {
+        NodeDataType const from = getDataType(PortType::Out);
+        NodeDataType const to = getDataType(PortType::In);
+
+        return from.sameType(to) || static_cast<bool>(_registry->getTypeConverter(from, to));
     };
 
-    return getDataType(PortType::Out).id == getDataType(PortType::In).id
-           && portVacant(PortType::Out) && portVacant(PortType::In);
+    return typesCompatible() && portVacant(PortType::Out) && portVacant(PortType::In);
 }
 
 void DataFlowGraphModel::addConnection(ConnectionId const connectionId)
 {
     _connectivity.insert(connectionId);
 
+    indexConnection(connectionId);
+
     sendConnectionCreation(connectionId);
 
-    QVariant const portDataToPropagate = portData(connectionId.outNodeId,
-                                                  PortType::Out,
-                                                  connectionId.outPortIndex,
-                                                  PortRole::Data);
+    // Data is propagated once the whole graph is loaded.
+    if (_bulkLoading)
+        return;
+
+    if (inBatch()) {
+        _batchConnections.push_back(connectionId);
+        return;
+    }
+
+    NodeDelegateModel *model = findModel(connectionId.outNodeId);
+    if (!model)
+        return;
+
+    std::shared_ptr<NodeData> const data = model->outData(connectionId.outPortIndex);
+
+    deliverInput(connectionId.inNodeId,
+                 connectionId.inPortIndex,
+                 convertedData(connectionId, data));
+}
+
+void DataFlowGraphModel::indexConnection(ConnectionId const connectionId)
+{
+    _portConnections[PortKey{connectionId.outNodeId, PortType::Out, connectionId.outPortIndex}]
+        .insert(connectionId);
+    _portConnections[PortKey{connectionId.inNodeId, PortType::In, connectionId.inPortIndex}]
+        .insert(connectionId);
+
+    _nodeConnections[connectionId.outNodeId].insert(connectionId);
+    _nodeConnections[connectionId.inNodeId].insert(connectionId);
+}
+
+void DataFlowGraphModel::unindexConnection(ConnectionId const connectionId)
+{
+    auto erasePort = [&](PortType const portType) {
+        PortKey const key{getNodeId(portType, connectionId),
+                          portType,
+                          getPortIndex(portType, connectionId)};
+
+        auto it = _portConnections.find(key);
+
+        if (it == _portConnections.end())
+            return;
+
+        it->second.erase(connectionId);
+
+        // Empty buckets are dropped so that the index does not grow with the
+        // history of dynamic port insertions and removals.
+        if (it->second.empty())
+            _portConnections.erase(it);
+    };
+
+    auto eraseNode = [&](NodeId const nodeId) {
+        auto it = _nodeConnections.find(nodeId);
+
+        if (it == _nodeConnections.end())
+            return;
+
+        it->second.erase(connectionId);
+
+        if (it->second.empty())
+            _nodeConnections.erase(it);
+    };
+
+    erasePort(PortType::Out);
+    erasePort(PortType::In);
+
+    eraseNode(connectionId.outNodeId);
+    eraseNode(connectionId.inNodeId);
+}
+
+void DataFlowGraphModel::insertNode(NodeId const nodeId,
+                                    std::unique_ptr<NodeDelegateModel> model,
+                                    QPointF const &pos)
+{
+    int const type = nodeTypeHandle(model->name());
+
+    _nodes.insert(nodeId, NodeSlot{std::move(model), pos, QSize(), type});
+}
+
+int DataFlowGraphModel::nodeTypeHandle(QString const &typeName)
+{
+    auto inserted = _nodeTypeHandles.emplace(typeName, static_cast<int>(_nodeTypeNames.size()));
+
+    if (inserted.second)
+        _nodeTypeNames.push_back(typeName);
+
+    return inserted.first->second;
+}
 
-    setPortData(connectionId.inNodeId,
-                PortType::In,
-                connectionId.inPortIndex,
-                portDataToPropagate,
-                PortRole::Data);
+NodeDelegateModel *DataFlowGraphModel::findModel(NodeId const nodeId) const
+{
+    NodeSlot const *slot = _nodes.find(nodeId);
+
+    return slot ? slot->model.get() : nullptr;
 }
 
 void DataFlowGraphModel::sendConnectionCreation(ConnectionId const connectionId)
 {
-    Q_EMIT connectionCreated(connectionId);
+    if (!_bulkLoading)
+        Q_EMIT connectionCreated(connectionId);
 
-    auto iti = _models.find(connectionId.inNodeId);
-    auto ito = _models.find(connectionId.outNodeId);
-    if (iti != _models.end() && ito != _models.end()) {
-        auto &modeli = iti->second;
-        auto &modelo = ito->second;
+    NodeDelegateModel *modeli = findModel(connectionId.inNodeId);
+    NodeDelegateModel *modelo = findModel(connectionId.outNodeId);
+    if (modeli && modelo) {
         modeli->inputConnectionCreated(connectionId);
         modelo->outputConnectionCreated(connectionId);
     }
@@ -184,11 +472,9 @@ void DataFlowGraphModel::sendConnectionDeletion(ConnectionId const connectionId)
 {
     Q_EMIT connectionDeleted(connectionId);
 
-    auto iti = _models.find(connectionId.inNodeId);
-    auto ito = _models.find(connectionId.outNodeId);
-    if (iti != _models.end() && ito != _models.end()) {
-        auto &modeli = iti->second;
-        auto &modelo = ito->second;
+    NodeDelegateModel *modeli = findModel(connectionId.inNodeId);
+    NodeDelegateModel *modelo = findModel(connectionId.outNodeId);
+    if (modeli && modelo) {
         modeli->inputConnectionDeleted(connectionId);
         modelo->outputConnectionDeleted(connectionId);
     }
@@ -196,30 +482,30 @@ void DataFlowGraphModel::sendConnectionDeletion(ConnectionId const connectionId)
 
 bool DataFlowGraphModel::nodeExists(NodeId const nodeId) const
 {
-    return (_models.find(nodeId) != _models.end());
+    return _nodes.contains(nodeId);
 }
 
 QVariant DataFlowGraphModel::nodeData(NodeId nodeId, NodeRole role) const
 {
     QVariant result;
 
-    auto it = _models.find(nodeId);
-    if (it == _models.end())
+    NodeSlot const *slot = _nodes.find(nodeId);
+    if (!slot)
         return result;
 
-    auto &model = it->second;
+    auto &model = slot->model;
 
     switch (role) {
     case NodeRole::Type:
-        result = model->name();
+        result = _nodeTypeNames[static_cast<std::size_t>(slot->type)];
         break;
 
     case NodeRole::Position:
-        result = _nodeGeometryData[nodeId].pos;
+        result = slot->pos;
         break;
 
     case NodeRole::Size:
-        result = _nodeGeometryData[nodeId].size;
+        result = slot->size;
         break;
 
     case NodeRole::CaptionVisible:
@@ -238,7 +524,7 @@ QVariant DataFlowGraphModel::nodeData(NodeId nodeId, NodeRole role) const
     case NodeRole::InternalData: {
         QJsonObject nodeJson;
 
-        nodeJson["internal-data"] = _models.at(nodeId)->save();
+        nodeJson["internal-data"] = model->save();
 
         result = nodeJson.toVariantMap();
         break;
@@ -279,14 +565,60 @@ QVariant DataFlowGraphModel::nodeData(NodeId nodeId, NodeRole role) const
     return result;
 }
 
+std::shared_ptr<NodeStyle const> DataFlowGraphModel::nodeStyle(NodeId nodeId) const
+{
+    Q_UNUSED(nodeId);
+
+    // Same style as the one serialized for NodeRole::Style.
+    return StyleCollection::sharedNodeStyle();
+}
+
+NodeRenderInfo DataFlowGraphModel::nodeRenderInfo(NodeId nodeId) const
+{
+    NodeRenderInfo info;
+
+    NodeSlot const *slot = _nodes.find(nodeId);
+    if (!slot)
+        return info;
+
+    auto &model = slot->model;
+
+    info.caption = model->caption();
+    info.captionVisible = model->captionVisible();
+    info.description = model->descriptions();
+    info.icon = model->icon();
+    info.size = slot->size;
+    info.running = model->operationStatus();
+    info.computeTime = model->nodeComputeTime();
+    info.result = model->getResult();
+    info.paintType = model->getPaintType();
+
+    for (PortType portType : {PortType::In, PortType::Out}) {
+        auto &ports = (portType == PortType::In) ? info.inPorts : info.outPorts;
+
+        ports.resize(model->nPorts(portType));
+
+        for (PortIndex portIndex = 0; portIndex < ports.size(); ++portIndex) {
+            NodeRenderPortInfo &port = ports[portIndex];
+
+            port.dataType = model->dataType(portType, portIndex);
+            port.captionVisible = model->portCaptionVisible(portType, portIndex);
+            port.caption = model->portCaption(portType, portIndex);
+        }
+    }
+
+    return info;
+}
+
 NodeFlags DataFlowGraphModel::nodeFlags(NodeId nodeId) const
 {
-    auto it = _models.find(nodeId);
+    NodeSlot const *slot = _nodes.find(nodeId);
 
-    if (it != _models.end() && it->second->resizable())
-        return NodeFlag::Resizable;
+    // Asked on every call, a delegate may become resizable after its creation.
+    if (!slot || !slot->model->resizable())
+        return NodeFlags(NodeFlag::NoFlags);
 
-    return NodeFlag::NoFlags;
+    return NodeFlags(NodeFlag::Resizable);
 }
 
 bool DataFlowGraphModel::setNodeData(NodeId nodeId, NodeRole role, QVariant value)
@@ -297,11 +629,15 @@ bool DataFlowGraphModel::setNodeData(NodeId nodeId, NodeRole role, QVariant valu
 
     bool result = false;
 
+    NodeSlot *slot = _nodes.find(nodeId);
+    if (!slot)
+        return result;
+
     switch (role) {
     case NodeRole::Type:
         break;
     case NodeRole::Position: {
-        _nodeGeometryData[nodeId].pos = value.value<QPointF>();
+        slot->pos = value.value<QPointF>();
 
         Q_EMIT nodePositionUpdated(nodeId);
 
@@ -309,7 +645,7 @@ bool DataFlowGraphModel::setNodeData(NodeId nodeId, NodeRole role, QVariant valu
     } break;
 
     case NodeRole::Size: {
-        _nodeGeometryData[nodeId].size = value.value<QSize>();
+        slot->size = value.value<QSize>();
         result = true;
     } break;
 
@@ -338,6 +674,24 @@ bool DataFlowGraphModel::setNodeData(NodeId nodeId, NodeRole role, QVariant valu
     return result;
 }
 
+void DataFlowGraphModel::moveNodes(std::vector<NodeId> const &nodeIds, QPointF const &offset)
+{
+    std::vector<NodeId> moved;
+    moved.reserve(nodeIds.size());
+
+    for (NodeId const nodeId : nodeIds) {
+        NodeSlot *slot = _nodes.find(nodeId);
+        if (!slot)
+            continue;
+
+        slot->pos += offset;
+        moved.push_back(nodeId);
+    }
+
+    if (!moved.empty())
+        Q_EMIT nodePositionsUpdated(moved);
+}
+
 QVariant DataFlowGraphModel::portData(NodeId nodeId,
                                       PortType portType,
                                       PortIndex portIndex,
@@ -345,12 +699,10 @@ QVariant DataFlowGraphModel::portData(NodeId nodeId,
 {
     QVariant result;
 
-    auto it = _models.find(nodeId);
-    if (it == _models.end())
+    NodeDelegateModel *model = findModel(nodeId);
+    if (!model)
         return result;
 
-    auto &model = it->second;
-
     switch (role) {
     case PortRole::Data:
         if (portType == PortType::Out)
@@ -381,24 +733,10 @@ QVariant DataFlowGraphModel::portData(NodeId nodeId,
 bool DataFlowGraphModel::setPortData(
     NodeId nodeId, PortType portType, PortIndex portIndex, QVariant const &value, PortRole role)
 {
-    Q_UNUSED(nodeId);
-
-    QVariant result;
-
-    auto it = _models.find(nodeId);
-    if (it == _models.end())
-        return false;
-
-    auto &model = it->second;
-
     switch (role) {
     case PortRole::Data:
-        if (portType == PortType::In) {
-            model->setInData(value.value<std::shared_ptr<NodeData>>(), portIndex,_nodeContinueExec);
-
-            // Triggers repainting on the scene.
-            Q_EMIT inPortDataWasSet(nodeId, portType, portIndex);
-        }
+        if (portType == PortType::In)
+            deliverInput(nodeId, portIndex, value.value<std::shared_ptr<NodeData>>());
         break;
 
     default:
@@ -408,6 +746,34 @@ bool DataFlowGraphModel::setPortData(
     return false;
 }
 
+void DataFlowGraphModel::deliverInput(NodeId const nodeId,
+                                      PortIndex const portIndex,
+                                      std::shared_ptr<NodeData> const &data)
+{
+    NodeDelegateModel *model = findModel(nodeId);
+    if (!model)
+        return;
+
+    if (!recordInput(nodeId, portIndex, data))
+        return;
+
+    // Whatever is computed from the previous inputs is stale now.
+    cancelAsyncCompute(nodeId);
+
+    bool const async = _nodeContinueExec && model->supportsAsyncCompute();
+
+    model->setInData(data, portIndex, _nodeContinueExec && !async);
+
+    // Triggers repainting on the scene.
+    Q_EMIT inPortDataWasSet(nodeId, PortType::In, portIndex);
+
+    if (inBatch())
+        _batchInputNodes.insert(nodeId);
+
+    if (async)
+        launchAsyncCompute(nodeId, model);
+}
+
 bool DataFlowGraphModel::deleteConnection(ConnectionId const connectionId)
 {
     bool disconnected = false;
@@ -418,6 +784,16 @@ bool DataFlowGraphModel::deleteConnection(ConnectionId const connectionId)
         disconnected = true;
 
         _connectivity.erase(it);
+
+        unindexConnection(connectionId);
+
+        _conversions.erase(connectionId);
+
+        // The receiving node no longer waits for an upstream node which has
+        // not settled yet in the running pass.
+        if (_pass && _pass->pendingUpstream.count(connectionId.outNodeId)
+            && _pass->settled.count(connectionId.outNodeId) == 0)
+            releaseDownstream(connectionId);
     }
 
     if (disconnected) {
@@ -438,8 +814,28 @@ bool DataFlowGraphModel::deleteNode(NodeId const nodeId)
         deleteConnection(cId);
     }
 
-    _nodeGeometryData.erase(nodeId);
-    _models.erase(nodeId);
+    _dirtyOutPorts.erase(nodeId);
+
+    cancelAsyncCompute(nodeId);
+    _inputStamps.erase(nodeId);
+
+    if (_pass) {
+        _pass->inbox.erase(nodeId);
+
+        // A worker is still evaluating the node, keep the model alive until
+        // the pass no longer runs anything. The worker settles the node once
+        // it is done.
+        NodeSlot *slot = _nodes.find(nodeId);
+        if (_pass->running.count(nodeId) && slot) {
+            disconnect(slot->model.get(), nullptr, this, nullptr);
+            _pass->retired.push_back(std::move(slot->model));
+        } else if (_pass->pendingUpstream.count(nodeId)) {
+            _pass->started.insert(nodeId);
+            _pass->settled.insert(nodeId);
+        }
+    }
+
+    _nodes.erase(nodeId);
 
     Q_EMIT nodeDeleted(nodeId);
 
@@ -450,12 +846,16 @@ QJsonObject DataFlowGraphModel::saveNode(NodeId const nodeId) const
 {
     QJsonObject nodeJson;
 
+    NodeSlot const *slot = _nodes.find(nodeId);
+    if (!slot)
+        throw std::out_of_range("DataFlowGraphModel::saveNode: unknown node id");
+
     nodeJson["id"] = static_cast<qint64>(nodeId);
 
-    nodeJson["internal-data"] = _models.at(nodeId)->save();
+    nodeJson["internal-data"] = slot->model->save();
 
     {
-        QPointF const pos = nodeData(nodeId, NodeRole::Position).value<QPointF>();
+        QPointF const pos = slot->pos;
 
         QJsonObject posJson;
         posJson["x"] = pos.x();
@@ -471,9 +871,9 @@ QJsonObject DataFlowGraphModel::save() const
     QJsonObject sceneJson;
 
     QJsonArray nodesJsonArray;
-    for (auto const nodeId : allNodeIds()) {
+    forEachNode([&nodesJsonArray, this](NodeId const nodeId) {
         nodesJsonArray.append(saveNode(nodeId));
-    }
+    });
     sceneJson["nodes"] = nodesJsonArray;
 
     QJsonArray connJsonArray;
@@ -496,9 +896,17 @@ void DataFlowGraphModel::loadNode(QJsonObject const &nodeJson)
     // because all the new ids were created past the removed nodes.
     NodeId restoredNodeId = nodeJson["id"].toInt();
 
-    _nextNodeId = std::max(_nextNodeId, restoredNodeId + 1);
+    QJsonObject posJson = nodeJson["position"].toObject();
+    QPointF const pos(posJson["x"].toDouble(), posJson["y"].toDouble());
 
-    QJsonObject const internalDataJson = nodeJson["internal-data"].toObject();
+    restoreNode(restoredNodeId, pos, nodeJson["internal-data"].toObject());
+}
+
+void DataFlowGraphModel::restoreNode(NodeId const restoredNodeId,
+                                     QPointF const &pos,
+                                     QJsonObject const &internalDataJson)
+{
+    _nextNodeId = std::max(_nextNodeId, restoredNodeId + 1);
 
     QString delegateModelName = internalDataJson["model-name"].toString();
 
@@ -508,8 +916,9 @@ void DataFlowGraphModel::loadNode(QJsonObject const &nodeJson)
         connect(model.get(),
                 &NodeDelegateModel::dataUpdated,this,
                 [restoredNodeId, this](PortIndex const portIndex,bool bContinue) {
-                    onOutPortDataUpdated(restoredNodeId, portIndex,bContinue);
-                },Qt::QueuedConnection);
+                    onNodeDataUpdated(restoredNodeId, portIndex, bContinue);
+                },
+                Qt::DirectConnection);
 
         connect(model.get(), &NodeDelegateModel::computingStarted, this, [restoredNodeId, this]() {
             Q_EMIT computingStarted(restoredNodeId);
@@ -525,16 +934,19 @@ void DataFlowGraphModel::loadNode(QJsonObject const &nodeJson)
             Q_EMIT inPortDataWasSet(restoredNodeId, PortType::In, 0);
         });
 
-        _models[restoredNodeId] = std::move(model);
+        NodeDelegateModel *restoredModel = model.get();
 
-        Q_EMIT nodeCreated(restoredNodeId);
+        insertNode(restoredNodeId, std::move(model), pos);
 
-        QJsonObject posJson = nodeJson["position"].toObject();
-        QPointF const pos(posJson["x"].toDouble(), posJson["y"].toDouble());
+        if (_bulkLoading) {
+            _bulkLoadedNodes.push_back(restoredNodeId);
+        } else {
+            Q_EMIT nodeCreated(restoredNodeId);
 
-        setNodeData(restoredNodeId, NodeRole::Position, pos);
+            setNodeData(restoredNodeId, NodeRole::Position, pos);
+        }
 
-        _models[restoredNodeId]->load(internalDataJson);
+        restoredModel->load(internalDataJson);
     } else {
         throw std::logic_error(std::string("No registered model with name ")
                                + delegateModelName.toLocal8Bit().data());
@@ -543,89 +955,842 @@ void DataFlowGraphModel::loadNode(QJsonObject const &nodeJson)
 
 void DataFlowGraphModel::load(QJsonObject const &jsonDocument)
 {
-    QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
+    beginBulkLoad();
 
-    for (QJsonValueRef nodeJson : nodesJsonArray) {
-        loadNode(nodeJson.toObject());
-    }
+    try {
+        QJsonArray nodesJsonArray = jsonDocument["nodes"].toArray();
+
+        for (QJsonValueRef nodeJson : nodesJsonArray) {
+            loadNode(nodeJson.toObject());
+        }
 
-    QJsonArray connectionJsonArray = jsonDocument["connections"].toArray();
+        QJsonArray connectionJsonArray = jsonDocument["connections"].toArray();
 
-    for (QJsonValueRef connection : connectionJsonArray) {
-        QJsonObject connJson = connection.toObject();
+        for (QJsonValueRef connection : connectionJsonArray) {
+            QJsonObject connJson = connection.toObject();
 
-        ConnectionId connId = fromJson(connJson);
+            ConnectionId connId = fromJson(connJson);
 
-        // Restore the connection
-        addConnection(connId);
+            // Restore the connection
+            addConnection(connId);
+        }
+    } catch (...) {
+        endBulkLoad();
+        throw;
     }
+
+    endBulkLoad();
 }
 
-void DataFlowGraphModel::setNodeExecType(NodeId nodeId,NodeExecType nType) const
+void DataFlowGraphModel::beginBulkLoad()
 {
-    auto it = _models.find(nodeId);
-    if (it == _models.end())
-    {
-        qDebug() << "error:can't find nodeid";
-        return;
-    }
-    Q_EMIT sgnDataFlowBegin(nodeId);
-    auto &nodeModel = it->second;
-
-    if (nType == NodeExecType::EXECTYPE_STEP_NEXT)
-    {
-        nodeModel->execStepNext();
-    }
-    else if (nType == NodeExecType::EXECTYPE_STEP_OVER)
-    { 
-        nodeModel->execStepOver();
-    }
+    _bulkLoading = true;
+    _bulkLoadedNodes.clear();
 }
 
-bool DataFlowGraphModel::hasNodeExec()
+void DataFlowGraphModel::endBulkLoad()
 {
-    return _nodeContinueExec;
+    _bulkLoading = false;
+
+    std::vector<NodeId> const loadedNodes = std::move(_bulkLoadedNodes);
+    _bulkLoadedNodes.clear();
+
+    // The scenes rebuild all their graphics objects in one go.
+    Q_EMIT modelReset();
+
+    std::vector<ConnectionId> incoming;
+
+    for (NodeId const nodeId : loadedNodes) {
+        forEachNodeConnection(nodeId, [&](ConnectionId const &cn) {
+            if (cn.inNodeId == nodeId)
+                incoming.push_back(cn);
+        });
+    }
+
+    propagateConnections(incoming);
 }
 
-void DataFlowGraphModel::onOutPortDataUpdated(NodeId const nodeId,PortIndex const portIndex,bool bContinue)
+void DataFlowGraphModel::propagateConnections(std::vector<ConnectionId> const &connections)
 {
-    std::unordered_set<ConnectionId> const &connected = connections(nodeId,
-                                                                    PortType::Out,
-                                                                    portIndex);
+    std::unordered_map<NodeId, std::vector<ConnectionId>> incoming;
+    std::vector<NodeId> targets;
 
-    QVariant const portDataToPropagate = portData(nodeId, PortType::Out, portIndex, PortRole::Data);
-    _nodeContinueExec = bContinue;
+    for (ConnectionId const &cn : connections) {
+        auto &nodeConnections = incoming[cn.inNodeId];
 
-    if (connected.empty())
-    {
-        _nodeContinueExec = false;
-        Q_EMIT sgnDataFlowFinished(nodeId);
-        qDebug() << "no connected node";
-        return;
+        if (nodeConnections.empty())
+            targets.push_back(cn.inNodeId);
+
+        nodeConnections.push_back(cn);
     }
 
-    //judge last node
-    std::unordered_set<ConnectionId> lastConnected;
+    // Upstream nodes come first, so every input receives the data of an
+    // already initialized producer.
+    for (NodeId const nodeId : DataFlowScheduler::topologicalOrder(*this, targets)) {
+        auto it = incoming.find(nodeId);
+        if (it == incoming.end())
+            continue;
+
+        for (ConnectionId const &cn : it->second) {
+            NodeDelegateModel *outModel = findModel(cn.outNodeId);
+            if (!outModel || _connectivity.count(cn) == 0)
+                continue;
 
-    for (auto const &cn : connected) {
-        setPortData(cn.inNodeId, PortType::In, cn.inPortIndex, portDataToPropagate, PortRole::Data);
-         std::unordered_set<ConnectionId> currentConnected = connections(cn.outNodeId,PortType::Out,portIndex);
-         if(!currentConnected.empty())
-            lastConnected.insert(currentConnected.begin(),currentConnected.end());
+            std::shared_ptr<NodeData> const data = outModel->outData(cn.outPortIndex);
+
+            deliverInput(cn.inNodeId, cn.inPortIndex, convertedData(cn, data));
+        }
     }
-    if(lastConnected.empty())
-    {
-         _nodeContinueExec = false;
-         Q_EMIT sgnDataFlowFinished(nodeId);
-         qDebug() << "no connected node";
+}
+
+void DataFlowGraphModel::batchEnded()
+{
+    std::vector<ConnectionId> connections;
+    connections.swap(_batchConnections);
+
+    std::unordered_set<NodeId> inputNodes;
+    inputNodes.swap(_batchInputNodes);
+
+    // The scenes skipped the repaints requested during the batch.
+    for (NodeId const nodeId : inputNodes) {
+        if (nodeExists(nodeId))
+            Q_EMIT inPortDataWasSet(nodeId, PortType::In, 0);
     }
+
+    propagateConnections(connections);
 }
 
-void DataFlowGraphModel::propagateEmptyDataTo(NodeId const nodeId, PortIndex const portIndex)
+bool DataFlowGraphModel::isBinaryFormat(QByteArray const &data)
+{
+    QDataStream in(data);
+
+    quint32 magic = 0;
+    in >> magic;
+
+    return in.status() == QDataStream::Ok && magic == BinaryMagic;
+}
+
+QByteArray DataFlowGraphModel::saveBinary() const
 {
-    QVariant emptyData{};
+    QByteArray result;
 
-    setPortData(nodeId, PortType::In, portIndex, emptyData, PortRole::Data);
+    QDataStream out(&result, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_11);
+
+    out << BinaryMagic << BinaryFormatVersion << static_cast<quint8>(DefaultPayloadEncoding);
+
+    // Model names are stored once and referenced by index from the node table.
+    std::vector<QString> names;
+    std::unordered_map<QString, quint32> nameIndices;
+
+    struct NodeRecord
+    {
+        NodeId id;
+        quint32 nameIndex;
+        QPointF pos;
+        QByteArray payload;
+    };
+
+    std::vector<NodeRecord> nodes;
+    nodes.reserve(_nodes.size());
+
+    for (std::size_t i = 0; i < _nodes.size(); ++i) {
+        NodeSlot const &slot = _nodes.values()[i];
+
+        QJsonObject internalData = slot.model->save();
+
+        QString const name = internalData.take("model-name").toString();
+
+        auto inserted = nameIndices.emplace(name, static_cast<quint32>(names.size()));
+        if (inserted.second)
+            names.push_back(name);
+
+        nodes.push_back(NodeRecord{_nodes.ids()[i],
+                                   inserted.first->second,
+                                   slot.pos,
+                                   encodePayload(internalData)});
+    }
+
+    out << static_cast<quint32>(names.size());
+    for (QString const &name : names) {
+        out << name;
+    }
+
+    out << static_cast<quint32>(nodes.size());
+    for (NodeRecord const &node : nodes) {
+        out << static_cast<quint32>(node.id) << node.nameIndex << node.pos.x() << node.pos.y()
+            << node.payload;
+    }
+
+    out << static_cast<quint32>(_connectivity.size());
+    for (ConnectionId const &cid : _connectivity) {
+        out << static_cast<quint32>(cid.outNodeId) << static_cast<quint32>(cid.outPortIndex)
+            << static_cast<quint32>(cid.inNodeId) << static_cast<quint32>(cid.inPortIndex);
+    }
+
+    return result;
+}
+
+bool DataFlowGraphModel::loadBinary(QByteArray const &data)
+{
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_11);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint8 encoding = 0;
+
+    in >> magic >> version >> encoding;
+
+    if (in.status() != QDataStream::Ok || magic != BinaryMagic || version < 1
+        || version > BinaryFormatVersion || !payloadEncodingSupported(encoding))
+        return false;
+
+    // The whole stream is parsed before touching the graph so that truncated
+    // or corrupted data leaves the model unchanged.
+    quint32 nameCount = 0;
+    in >> nameCount;
+
+    std::vector<QString> names;
+    for (quint32 i = 0; i < nameCount && in.status() == QDataStream::Ok; ++i) {
+        QString name;
+        in >> name;
+        names.push_back(name);
+    }
+
+    struct NodeRecord
+    {
+        quint32 id;
+        quint32 nameIndex;
+        double x;
+        double y;
+        QByteArray payload;
+    };
+
+    quint32 nodeCount = 0;
+    in >> nodeCount;
+
+    std::vector<NodeRecord> nodes;
+    for (quint32 i = 0; i < nodeCount && in.status() == QDataStream::Ok; ++i) {
+        NodeRecord node;
+        in >> node.id >> node.nameIndex >> node.x >> node.y >> node.payload;
+
+        if (node.nameIndex >= names.size())
+            return false;
+
+        nodes.push_back(std::move(node));
+    }
+
+    quint32 connectionCount = 0;
+    in >> connectionCount;
+
+    std::vector<ConnectionId> connectionIds;
+    for (quint32 i = 0; i < connectionCount && in.status() == QDataStream::Ok; ++i) {
+        quint32 outNodeId = 0, outPortIndex = 0, inNodeId = 0, inPortIndex = 0;
+        in >> outNodeId >> outPortIndex >> inNodeId >> inPortIndex;
+
+        connectionIds.push_back(ConnectionId{outNodeId, outPortIndex, inNodeId, inPortIndex});
+    }
+
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    // Node ids must be unique and free in the model, connections must join
+    // nodes of the same stream.
+    std::unordered_set<NodeId> nodeIds;
+    for (NodeRecord const &node : nodes) {
+        if (!nodeIds.insert(node.id).second || nodeExists(node.id))
+            return false;
+    }
+
+    for (ConnectionId const &connId : connectionIds) {
+        if (!nodeIds.count(connId.outNodeId) || !nodeIds.count(connId.inNodeId))
+            return false;
+    }
+
+    for (QString const &name : names) {
+        if (!_registry->registeredModelCreators().count(name))
+            throw std::logic_error(std::string("No registered model with name ")
+                                   + name.toLocal8Bit().data());
+    }
+
+    std::vector<QJsonObject> internalData;
+    internalData.reserve(nodes.size());
+
+    for (NodeRecord const &node : nodes) {
+        QJsonObject nodeData;
+        if (!decodePayload(node.payload, encoding, nodeData))
+            return false;
+
+        nodeData["model-name"] = names[node.nameIndex];
+        internalData.push_back(std::move(nodeData));
+    }
+
+    beginBulkLoad();
+
+    try {
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            restoreNode(nodes[i].id, QPointF(nodes[i].x, nodes[i].y), internalData[i]);
+        }
+
+        for (ConnectionId const &connId : connectionIds) {
+            addConnection(connId);
+        }
+    } catch (...) {
+        endBulkLoad();
+        throw;
+    }
+
+    endBulkLoad();
+
+    return true;
+}
+
+void DataFlowGraphModel::setNodeExecType(NodeId nodeId, NodeExecType nType)
+{
+    NodeDelegateModel *nodeModel = findModel(nodeId);
+    if (!nodeModel)
+    {
+        qDebug() << "error:can't find nodeid";
+        return;
+    }
+    Q_EMIT sgnDataFlowBegin(nodeId);
+
+    if (nType == NodeExecType::EXECTYPE_STEP_NEXT)
+    {
+        nodeModel->execStepNext();
+    }
+    else if (nType == NodeExecType::EXECTYPE_STEP_OVER)
+    { 
+        nodeModel->execStepOver();
+    }
+}
+
+bool DataFlowGraphModel::hasNodeExec() const
+{
+    return _nodeContinueExec;
+}
+
+void DataFlowGraphModel::onNodeDataUpdated(NodeId const nodeId,
+                                           PortIndex const portIndex,
+                                           bool bContinue)
+{
+    if (QThread::currentThread() != thread()) {
+        // Emitted by a model running on one of our workers, the pass collects
+        // it once the worker is done.
+        if (workerEmissions) {
+            workerEmissions->push_back(portIndex);
+            return;
+        }
+
+        QMetaObject::invokeMethod(
+            this,
+            [nodeId, portIndex, bContinue, this]() {
+                onNodeDataUpdated(nodeId, portIndex, bContinue);
+            },
+            Qt::QueuedConnection);
+        return;
+    }
+
+    // Plain updates (step over) only refresh the direct neighbours and take
+    // the push path in every mode.
+    if (_executionMode == ExecutionMode::Push || !bContinue) {
+        QMetaObject::invokeMethod(
+            this,
+            [nodeId, portIndex, bContinue, this]() {
+                onOutPortDataUpdated(nodeId, portIndex, bContinue);
+            },
+            Qt::QueuedConnection);
+        return;
+    }
+
+    _dirtyOutPorts[nodeId].insert(portIndex);
+    _nodeContinueExec = true;
+
+    // Updates emitted while a pass is running are consumed by that pass.
+    if (!_pass)
+        schedulePass();
+}
+
+void DataFlowGraphModel::setWorkerCount(std::size_t count)
+{
+    _workerCount = count;
+}
+
+WorkStealingThreadPool &DataFlowGraphModel::threadPool()
+{
+    std::size_t const requested = (_workerCount != 0)
+                                      ? _workerCount
+                                      : std::max(1u, std::thread::hardware_concurrency());
+
+    // The pool is only replaced while none of its workers is busy, otherwise
+    // destroying it would block until the running jobs return. Cancelled
+    // asynchronous runs are still counted until their job has returned.
+    bool const idle = (!_pass || _pass->running.empty()) && _asyncJobsInFlight == 0;
+
+    if (!_threadPool || (idle && _threadPool->workerCount() != requested))
+        _threadPool = std::make_unique<WorkStealingThreadPool>(requested);
+
+    return *_threadPool;
+}
+
+void DataFlowGraphModel::schedulePass()
+{
+    if (_passScheduled)
+        return;
+
+    _passScheduled = true;
+    QMetaObject::invokeMethod(this, [this]() { runPass(); }, Qt::QueuedConnection);
+}
+
+void DataFlowGraphModel::runPass()
+{
+    _passScheduled = false;
+
+    if (_pass || _dirtyOutPorts.empty())
+        return;
+
+    _pass = std::make_unique<ExecutionPass>();
+
+    std::vector<NodeId> sources;
+    sources.reserve(_dirtyOutPorts.size());
+    for (auto const &p : _dirtyOutPorts) {
+        sources.push_back(p.first);
+    }
+
+    _pass->order = DataFlowScheduler::topologicalOrder(*this, sources, &_pass->pendingUpstream);
+
+    for (NodeId const nodeId : _pass->order) {
+        if (_pass->pendingUpstream[nodeId] == 0)
+            _pass->ready.push_back(nodeId);
+    }
+
+    advancePass();
+}
+
+void DataFlowGraphModel::advancePass()
+{
+    while (true) {
+        while (!_pass->ready.empty()) {
+            NodeId const nodeId = _pass->ready.front();
+            _pass->ready.pop_front();
+
+            startNode(nodeId);
+        }
+
+        // The pass resumes in onWorkerFinished().
+        if (!_pass->running.empty())
+            return;
+
+        if (_pass->settled.size() == _pass->order.size())
+            break;
+
+        // Only nodes sitting on a cycle are left. They are taken in the order
+        // computed by the scheduler, one at a time.
+        for (NodeId const nodeId : _pass->order) {
+            if (_pass->started.count(nodeId) == 0) {
+                _pass->ready.push_back(nodeId);
+                break;
+            }
+        }
+    }
+
+    finishPass();
+}
+
+void DataFlowGraphModel::startNode(NodeId const nodeId)
+{
+    if (!_pass->started.insert(nodeId).second)
+        return;
+
+    ExecutionPass::Inputs inputs;
+
+    auto inboxIt = _pass->inbox.find(nodeId);
+    if (inboxIt != _pass->inbox.end()) {
+        inputs = std::move(inboxIt->second);
+        _pass->inbox.erase(inboxIt);
+    }
+
+    NodeDelegateModel *model = findModel(nodeId);
+
+    if (model) {
+        auto unchanged = [&](ExecutionPass::Inputs::value_type const &in) {
+            return !recordInput(nodeId, in.first, in.second);
+        };
+
+        inputs.erase(std::remove_if(inputs.begin(), inputs.end(), unchanged), inputs.end());
+    }
+
+    // Without new inputs the node keeps its outputs and releases its
+    // downstream without propagating anything.
+    if (!model || inputs.empty()) {
+        settleNode(nodeId);
+        return;
+    }
+
+    if (model->supportsAsyncCompute()) {
+        for (auto const &in : inputs) {
+            model->setInData(in.second, in.first, false);
+
+            Q_EMIT inPortDataWasSet(nodeId, PortType::In, in.first);
+        }
+
+        std::uint64_t const generation = launchAsyncCompute(nodeId, model);
+
+        if (generation != 0)
+            _pass->running.emplace(nodeId, generation);
+        else
+            settleNode(nodeId);
+
+        return;
+    }
+
+    if (_executionMode == ExecutionMode::Parallel && model->computeIsThreadSafe()) {
+        _pass->running.emplace(nodeId, 0);
+
+        CancellationToken const token = _pass->token;
+
+        threadPool().submit([this, nodeId, model, inputs, token]() {
+            if (token.isCancelled())
+                return;
+
+            std::vector<PortIndex> inPorts;
+            std::vector<PortIndex> emittedPorts;
+
+            workerEmissions = &emittedPorts;
+
+            for (std::size_t i = 0; i < inputs.size(); ++i) {
+                model->setInData(inputs[i].second, inputs[i].first, i + 1 == inputs.size());
+                inPorts.push_back(inputs[i].first);
+            }
+
+            workerEmissions = nullptr;
+
+            QMetaObject::invokeMethod(
+                this,
+                [this, nodeId, inPorts, emittedPorts]() {
+                    onWorkerFinished(nodeId, inPorts, emittedPorts);
+                },
+                Qt::QueuedConnection);
+        });
+
+        return;
+    }
+
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        model->setInData(inputs[i].second, inputs[i].first, i + 1 == inputs.size());
+
+        // Triggers repainting on the scene.
+        Q_EMIT inPortDataWasSet(nodeId, PortType::In, inputs[i].first);
+    }
+
+    settleNode(nodeId);
+}
+
+void DataFlowGraphModel::onWorkerFinished(NodeId const nodeId,
+                                          std::vector<PortIndex> const &inPorts,
+                                          std::vector<PortIndex> const &emittedPorts)
+{
+    if (!_pass)
+        return;
+
+    _pass->running.erase(nodeId);
+
+    if (nodeExists(nodeId)) {
+        for (PortIndex const portIndex : inPorts) {
+            Q_EMIT inPortDataWasSet(nodeId, PortType::In, portIndex);
+        }
+
+        for (PortIndex const portIndex : emittedPorts) {
+            _dirtyOutPorts[nodeId].insert(portIndex);
+        }
+    }
+
+    settleNode(nodeId);
+
+    if (_pass->running.empty())
+        _pass->retired.clear();
+
+    advancePass();
+}
+
+void DataFlowGraphModel::settleNode(NodeId const nodeId)
+{
+    _pass->settled.insert(nodeId);
+
+    auto dirtyIt = _dirtyOutPorts.find(nodeId);
+    NodeDelegateModel *model = findModel(nodeId);
+
+    if (dirtyIt != _dirtyOutPorts.end() && model) {
+        auto const ports = std::move(dirtyIt->second);
+        _dirtyOutPorts.erase(dirtyIt);
+
+        for (PortIndex const portIndex : ports) {
+            if (connectionCount(nodeId, PortType::Out, portIndex) == 0) {
+                Q_EMIT sgnDataFlowFinished(nodeId);
+                continue;
+            }
+
+            std::shared_ptr<NodeData> const data = model->outData(portIndex);
+
+            forEachConnection(nodeId, PortType::Out, portIndex, [&](ConnectionId const &cn) {
+                ExecutionPass::Inputs &inputs = _pass->inbox[cn.inNodeId];
+
+                auto existing = std::find_if(inputs.begin(), inputs.end(), [&](auto const &in) {
+                    return in.first == cn.inPortIndex;
+                });
+
+                std::shared_ptr<NodeData> const &converted = convertedData(cn, data);
+
+                if (existing != inputs.end())
+                    existing->second = converted;
+                else
+                    inputs.emplace_back(cn.inPortIndex, converted);
+            });
+        }
+    }
+
+    forEachNodeConnection(nodeId, [&](ConnectionId const &cn) {
+        if (cn.outNodeId == nodeId)
+            releaseDownstream(cn);
+    });
+}
+
+void DataFlowGraphModel::releaseDownstream(ConnectionId const &connectionId)
+{
+    auto it = _pass->pendingUpstream.find(connectionId.inNodeId);
+    if (it != _pass->pendingUpstream.end() && it->second > 0 && --it->second == 0)
+        _pass->ready.push_back(connectionId.inNodeId);
+}
+
+void DataFlowGraphModel::finishPass()
+{
+    // Inputs left at this point were produced by a cycle or by a connection
+    // created during the pass. They are stored without re-evaluating the
+    // receiving node, otherwise a cycle would never settle.
+    for (auto const &p : _pass->inbox) {
+        NodeDelegateModel *model = findModel(p.first);
+        if (!model)
+            continue;
+
+        for (auto const &in : p.second) {
+            if (!recordInput(p.first, in.first, in.second))
+                continue;
+
+            cancelAsyncCompute(p.first);
+
+            model->setInData(in.second, in.first, false);
+
+            Q_EMIT inPortDataWasSet(p.first, PortType::In, in.first);
+        }
+    }
+
+    _pass.reset();
+
+    if (!_dirtyOutPorts.empty())
+        schedulePass();
+    else
+        _nodeContinueExec = false;
+}
+
+std::uint64_t DataFlowGraphModel::launchAsyncCompute(NodeId const nodeId,
+                                                     NodeDelegateModel *model)
+{
+    cancelAsyncCompute(nodeId);
+
+    NodeDelegateModel::ComputeJob job = model->computeAsync();
+
+    if (!job)
+        return 0;
+
+    std::uint64_t const generation = ++_lastAsyncGeneration;
+    CancellationToken const token;
+
+    _asyncRuns[nodeId] = AsyncRun{token, generation};
+
+    WorkStealingThreadPool &pool = threadPool();
+
+    ++_asyncJobsInFlight;
+
+    pool.submit([this, nodeId, generation, token, job]() {
+        NodeDelegateModel::ComputeResult result;
+
+        if (!token.isCancelled())
+            result = job(token);
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, nodeId, generation, result]() {
+                onAsyncComputeFinished(nodeId, generation, result);
+            },
+            Qt::QueuedConnection);
+    });
+
+    return generation;
+}
+
+void DataFlowGraphModel::setMemoizationEnabled(bool enabled)
+{
+    _memoizationEnabled = enabled;
+
+    if (!enabled)
+        _inputStamps.clear();
+}
+
+bool DataFlowGraphModel::recordInput(NodeId const nodeId,
+                                     PortIndex const portIndex,
+                                     std::shared_ptr<NodeData> const &data)
+{
+    if (!_memoizationEnabled)
+        return true;
+
+    // Version 0 is never given to an actual NodeData and marks empty data.
+    std::size_t const hash = data ? data->contentHash() : 0;
+    InputStamp stamp{data ? data->version() : 0, hash, (hash != 0) ? data : nullptr};
+
+    auto &stamps = _inputStamps[nodeId];
+    auto it = stamps.find(portIndex);
+
+    if (it == stamps.end()) {
+        stamps.emplace(portIndex, std::move(stamp));
+        return true;
+    }
+
+    InputStamp const &last = it->second;
+
+    // The hash only tells different contents apart, equal hashes still have
+    // to be confirmed since they may collide.
+    bool const same = (last.version == stamp.version)
+                      || (hash != 0 && last.hash == hash && last.data
+                          && data->sameContent(*last.data));
+
+    it->second = std::move(stamp);
+
+    return !same;
+}
+
+std::shared_ptr<NodeData> const &DataFlowGraphModel::convertedData(
+    ConnectionId const &connectionId, std::shared_ptr<NodeData> const &data)
+{
+    if (!data || !_registry->hasTypeConverters())
+        return data;
+
+    NodeDelegateModel *outModel = findModel(connectionId.outNodeId);
+    NodeDelegateModel *inModel = findModel(connectionId.inNodeId);
+
+    if (!outModel || !inModel)
+        return data;
+
+    NodeDataType const from = outModel->dataType(PortType::Out, connectionId.outPortIndex);
+    NodeDataType const to = inModel->dataType(PortType::In, connectionId.inPortIndex);
+
+    if (from.sameType(to))
+        return data;
+
+    TypeConverter const converter = _registry->getTypeConverter(from, to);
+
+    if (!converter)
+        return data;
+
+    Conversion &conversion = _conversions[connectionId];
+
+    // Without memoization the data may have been modified in place since the
+    // last conversion, so the stored result is only reused with it.
+    if (_memoizationEnabled && conversion.data && conversion.sourceVersion == data->version())
+        return conversion.data;
+
+    conversion.sourceVersion = data->version();
+    conversion.data = converter(data);
+
+    return conversion.data;
+}
+
+void DataFlowGraphModel::cancelAsyncCompute(NodeId const nodeId)
+{
+    auto it = _asyncRuns.find(nodeId);
+
+    if (it == _asyncRuns.end())
+        return;
+
+    it->second.token.cancel();
+    _asyncRuns.erase(it);
+}
+
+void DataFlowGraphModel::onAsyncComputeFinished(NodeId const nodeId,
+                                                std::uint64_t const generation,
+                                                NodeDelegateModel::ComputeResult const &result)
+{
+    --_asyncJobsInFlight;
+
+    auto it = _asyncRuns.find(nodeId);
+
+    // Results of cancelled or superseded runs are dropped.
+    if (it != _asyncRuns.end() && it->second.generation == generation) {
+        _asyncRuns.erase(it);
+
+        if (result)
+            result();
+    }
+
+    if (!_pass)
+        return;
+
+    auto runningIt = _pass->running.find(nodeId);
+    if (runningIt == _pass->running.end() || runningIt->second != generation)
+        return;
+
+    _pass->running.erase(runningIt);
+
+    settleNode(nodeId);
+
+    if (_pass->running.empty())
+        _pass->retired.clear();
+
+    advancePass();
+}
+
+void DataFlowGraphModel::onOutPortDataUpdated(NodeId const nodeId,PortIndex const portIndex,bool bContinue)
+{
+    _nodeContinueExec = bContinue;
+
+    if (connectionCount(nodeId, PortType::Out, portIndex) == 0)
+    {
+        _nodeContinueExec = false;
+        Q_EMIT sgnDataFlowFinished(nodeId);
+        qDebug() << "no connected node";
+        return;
+    }
+
+    // The connections are copied on purpose: `setInData` is allowed to
+    // reshape the downstream ports, which would invalidate a live iteration.
+    std::vector<ConnectionId> connected;
+    connected.reserve(connectionCount(nodeId, PortType::Out, portIndex));
+
+    forEachConnection(nodeId, PortType::Out, portIndex, [&](ConnectionId const &cn) {
+        connected.push_back(cn);
+    });
+
+    // The output is fetched once and the same pointer is handed to every
+    // consumer, without boxing it into a QVariant per connection.
+    NodeDelegateModel *model = findModel(nodeId);
+    std::shared_ptr<NodeData> const data = model ? model->outData(portIndex) : nullptr;
+
+    for (ConnectionId const &cn : connected) {
+        deliverInput(cn.inNodeId, cn.inPortIndex, convertedData(cn, data));
+    }
+
+    //judge last node
+    if (connectionCount(nodeId, PortType::Out, portIndex) == 0)
+    {
+         _nodeContinueExec = false;
+         Q_EMIT sgnDataFlowFinished(nodeId);
+         qDebug() << "no connected node";
+    }
+}
+
+void DataFlowGraphModel::propagateEmptyDataTo(NodeId const nodeId, PortIndex const portIndex)
+{
+    deliverInput(nodeId, portIndex, nullptr);
 }
 
 } // namespace QtNodes
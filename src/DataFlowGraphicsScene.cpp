@@ -193,7 +193,11 @@ bool DataFlowGraphicsScene::load()
 
     QByteArray const wholeFile = file.readAll();
 
-    _graphModel.load(QJsonDocument::fromJson(wholeFile).object());
+    // Both the JSON and the binary flavours share the `.flow` extension.
+    if (DataFlowGraphModel::isBinaryFormat(wholeFile))
+        _graphModel.loadBinary(wholeFile);
+    else
+        _graphModel.load(QJsonDocument::fromJson(wholeFile).object());
 
     Q_EMIT sceneLoaded();
 
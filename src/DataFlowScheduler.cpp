@@ -0,0 +1,82 @@
+#include "DataFlowScheduler.hpp"
+
+#include "AbstractGraphModel.hpp"
+
+#include <deque>
+
+namespace QtNodes {
+
+std::vector<NodeId> DataFlowScheduler::topologicalOrder(
+    AbstractGraphModel const &model,
+    std::vector<NodeId> const &sources,
+    std::unordered_map<NodeId, std::size_t> *inDegreeResult)
+{
+    // Downstream closure of the sources, kept in discovery order so that the
+    // result does not depend on the hash order of the containers.
+    std::vector<NodeId> closure;
+
+    // Number of incoming connections coming from inside the closure.
+    std::unordered_map<NodeId, std::size_t> inDegree;
+
+    for (NodeId const nodeId : sources) {
+        if (inDegree.emplace(nodeId, 0).second)
+            closure.push_back(nodeId);
+    }
+
+    for (std::size_t i = 0; i < closure.size(); ++i) {
+        model.forEachNodeConnection(closure[i], [&](ConnectionId const &cn) {
+            if (cn.outNodeId != closure[i])
+                return;
+
+            if (inDegree.emplace(cn.inNodeId, 0).second)
+                closure.push_back(cn.inNodeId);
+        });
+    }
+
+    for (NodeId const nodeId : closure) {
+        model.forEachNodeConnection(nodeId, [&](ConnectionId const &cn) {
+            if (cn.outNodeId == nodeId)
+                ++inDegree[cn.inNodeId];
+        });
+    }
+
+    if (inDegreeResult)
+        *inDegreeResult = inDegree;
+
+    std::vector<NodeId> order;
+    order.reserve(closure.size());
+
+    std::deque<NodeId> ready;
+    for (NodeId const nodeId : closure) {
+        if (inDegree[nodeId] == 0)
+            ready.push_back(nodeId);
+    }
+
+    while (!ready.empty()) {
+        NodeId const nodeId = ready.front();
+        ready.pop_front();
+
+        order.push_back(nodeId);
+
+        model.forEachNodeConnection(nodeId, [&](ConnectionId const &cn) {
+            if (cn.outNodeId != nodeId)
+                return;
+
+            if (--inDegree[cn.inNodeId] == 0)
+                ready.push_back(cn.inNodeId);
+        });
+    }
+
+    // Whatever is left has a non-zero in-degree and therefore sits on a cycle
+    // or downstream of one.
+    if (order.size() != closure.size()) {
+        for (NodeId const nodeId : closure) {
+            if (inDegree[nodeId] != 0)
+                order.push_back(nodeId);
+        }
+    }
+
+    return order;
+}
+
+} // namespace QtNodes
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "Definitions.hpp"
+
+namespace QtNodes {
+
+class AbstractGraphModel;
+
+/// Orders the part of a graph affected by a data update.
+/**
+ * The class is stateless and only wraps the graph traversal used by the
+ * `DataFlowGraphModel::ExecutionMode::Topological` and
+ * `DataFlowGraphModel::ExecutionMode::Parallel` execution modes.
+ */
+class DataFlowScheduler
+{
+public:
+    /**
+   * Returns `sources` together with every node reachable from them through
+   * the output ports. Each node is placed after all of its upstream nodes
+   * from the same set (Kahn's algorithm).
+   *
+   * Nodes taking part in a cycle cannot be ordered; they are appended at the
+   * end in discovery order so that every affected node is still visited
+   * exactly once.
+   *
+   * When `inDegreeResult` is given it receives, for every returned node, the
+   * number of its incoming connections that originate inside the returned set.
+   */
+    static std::vector<NodeId> topologicalOrder(
+        AbstractGraphModel const &model,
+        std::vector<NodeId> const &sources,
+        std::unordered_map<NodeId, std::size_t> *inDegreeResult = nullptr);
+};
+
+} // namespace QtNodes
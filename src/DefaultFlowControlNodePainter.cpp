@@ -3,6 +3,7 @@
 #include <cmath>
 
 #include <QtCore/QMargins>
+#include <QtWidgets/QStyleOptionGraphicsItem>
 
 #include "AbstractGraphModel.hpp"
 #include "AbstractNodeGeometry.hpp"
@@ -21,32 +22,43 @@ void DefaultFlowControlNodePainter::paint(QPainter *painter, NodeGraphicsObject
     //AbstractNodeGeometry & geometry = ngo.nodeScene()->nodeGeometry();
     //geometry.recomputeSizeIfFontChanged(painter->font());
 
-    drawNodeRect(painter, ngo);
+    AbstractGraphModel &model = ngo.graphModel();
+    NodeId const nodeId = ngo.nodeId();
+    std::shared_ptr<NodeStyle const> style = model.nodeStyle(nodeId);
+    NodeStyle const &nodeStyle = *style;
 
-    drawConnectionPoints(painter, ngo);
+    NodeRenderInfo const info = model.nodeRenderInfo(nodeId);
 
-    drawFilledConnectionPoints(painter, ngo);
+    qreal const lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+        painter->worldTransform());
 
-    drawNodeCaption(painter, ngo);
+    if (lod < nodeStyle.SimplifiedLevelOfDetail) {
+        painter->fillRect(QRect(QPoint(0, 0), info.size), nodeStyle.GradientColor2);
+        return;
+    }
 
-    drawEntryLabels(painter, ngo);
+    drawNodeRect(painter, ngo, info, nodeStyle);
 
-    drawResizeRect(painter, ngo);
-}
+    if (lod < nodeStyle.TextLevelOfDetail)
+        return;
 
-void DefaultFlowControlNodePainter::drawNodeRect(QPainter *painter, NodeGraphicsObject &ngo) const
-{
-    AbstractGraphModel &model = ngo.graphModel();
+    drawConnectionPoints(painter, ngo, info, nodeStyle);
 
-    NodeId const nodeId = ngo.nodeId();
+    drawFilledConnectionPoints(painter, ngo, info, nodeStyle);
 
-    AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
+    drawNodeCaption(painter, ngo, info, nodeStyle);
 
-    QSize size = geometry.size(nodeId);
+    drawEntryLabels(painter, ngo, info, nodeStyle);
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
+    drawResizeRect(painter, ngo);
+}
 
-    NodeStyle nodeStyle(json.object());
+void DefaultFlowControlNodePainter::drawNodeRect(QPainter *painter,
+                                                 NodeGraphicsObject &ngo,
+                                                 NodeRenderInfo const &info,
+                                                 NodeStyle const &nodeStyle) const
+{
+    QSize size = info.size;
 
     auto color = ngo.isSelected() ? nodeStyle.SelectedBoundaryColor : nodeStyle.NormalBoundaryColor;
 
@@ -58,15 +70,14 @@ void DefaultFlowControlNodePainter::drawNodeRect(QPainter *painter, NodeGraphics
         painter->setPen(p);
     }
 
-    // QLinearGradient gradient(QPointF(0.0, 0.0), QPointF(2.0, size.height()));
+    QLinearGradient gradient(QPointF(0.0, 0.0), QPointF(2.0, size.height()));
 
-    // gradient.setColorAt(0.0, nodeStyle.GradientColor0);
-    // gradient.setColorAt(0.10, nodeStyle.GradientColor1);
-    // gradient.setColorAt(0.90, nodeStyle.GradientColor2);
-    // gradient.setColorAt(1.0, nodeStyle.GradientColor3);
-    QBrush brush(QColor::fromRgb(0x25, 0x37, 0x49));
+    gradient.setColorAt(0.0, nodeStyle.GradientColor0);
+    gradient.setColorAt(0.10, nodeStyle.GradientColor1);
+    gradient.setColorAt(0.90, nodeStyle.GradientColor2);
+    gradient.setColorAt(1.0, nodeStyle.GradientColor3);
 
-    painter->setBrush(brush);
+    painter->setBrush(gradient);
 
     QRectF boundary(0, 0, size.width(), size.height());
 
@@ -75,32 +86,27 @@ void DefaultFlowControlNodePainter::drawNodeRect(QPainter *painter, NodeGraphics
     painter->drawRoundedRect(boundary, radius, radius);
 }
 
-void DefaultFlowControlNodePainter::drawConnectionPoints(QPainter *painter, NodeGraphicsObject &ngo) const
+void DefaultFlowControlNodePainter::drawConnectionPoints(QPainter *painter,
+                                                         NodeGraphicsObject &ngo,
+                                                         NodeRenderInfo const &info,
+                                                         NodeStyle const &nodeStyle) const
 {
     AbstractGraphModel &model = ngo.graphModel();
     NodeId const nodeId = ngo.nodeId();
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
-
     auto const &connectionStyle = StyleCollection::connectionStyle();
 
     float diameter = nodeStyle.ConnectionPointDiameter;
     auto reducedDiameter = diameter * 0.6;
 
     for (PortType portType : {PortType::Out, PortType::In}) {
-        size_t const n = model
-                             .nodeData(nodeId,
-                                       (portType == PortType::Out) ? NodeRole::OutPortCount
-                                                                   : NodeRole::InPortCount)
-                             .toUInt();
+        auto const &ports = info.ports(portType);
 
-        for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
+        for (PortIndex portIndex = 0; portIndex < ports.size(); ++portIndex) {
             QPointF p = geometry.portPosition(nodeId, portType, portIndex);
 
-            auto const &dataType = model.portData(nodeId, portType, portIndex, PortRole::DataType)
-                                       .value<NodeDataType>();
+            auto const &dataType = ports[portIndex].dataType;
 
             double r = 1.0;
 
@@ -133,7 +139,7 @@ void DefaultFlowControlNodePainter::drawConnectionPoints(QPainter *painter, Node
             }
 
             if (connectionStyle.useDataDefinedColors()) {
-                painter->setBrush(connectionStyle.normalColor(dataType.id));
+                painter->setBrush(connectionStyle.normalColor(dataType));
             } else {
                 painter->setBrush(nodeStyle.ConnectionPointColor);
             }
@@ -147,37 +153,29 @@ void DefaultFlowControlNodePainter::drawConnectionPoints(QPainter *painter, Node
     }
 }
 
-void DefaultFlowControlNodePainter::drawFilledConnectionPoints(QPainter *painter, NodeGraphicsObject &ngo) const
+void DefaultFlowControlNodePainter::drawFilledConnectionPoints(QPainter *painter,
+                                                               NodeGraphicsObject &ngo,
+                                                               NodeRenderInfo const &info,
+                                                               NodeStyle const &nodeStyle) const
 {
     AbstractGraphModel &model = ngo.graphModel();
     NodeId const nodeId = ngo.nodeId();
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
-
     auto diameter = nodeStyle.ConnectionPointDiameter;
 
     for (PortType portType : {PortType::Out, PortType::In}) {
-        size_t const n = model
-                             .nodeData(nodeId,
-                                       (portType == PortType::Out) ? NodeRole::OutPortCount
-                                                                   : NodeRole::InPortCount)
-                             .toUInt();
+        auto const &ports = info.ports(portType);
 
-        for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
+        for (PortIndex portIndex = 0; portIndex < ports.size(); ++portIndex) {
             QPointF p = geometry.portPosition(nodeId, portType, portIndex);
 
-            auto const &connected = model.connections(nodeId, portType, portIndex);
-
-            if (!connected.empty()) {
-                auto const &dataType = model
-                                           .portData(nodeId, portType, portIndex, PortRole::DataType)
-                                           .value<NodeDataType>();
+            if (model.connectionCount(nodeId, portType, portIndex) > 0) {
+                auto const &dataType = ports[portIndex].dataType;
 
                 auto const &connectionStyle = StyleCollection::connectionStyle();
                 if (connectionStyle.useDataDefinedColors()) {
-                    QColor const c = connectionStyle.normalColor(dataType.id);
+                    QColor const c = connectionStyle.normalColor(dataType);
                     painter->setPen(c);
                     painter->setBrush(c);
                 } else {
@@ -191,25 +189,24 @@ void DefaultFlowControlNodePainter::drawFilledConnectionPoints(QPainter *painter
     }
 }
 
-void DefaultFlowControlNodePainter::drawNodeCaption(QPainter *painter, NodeGraphicsObject &ngo) const
+void DefaultFlowControlNodePainter::drawNodeCaption(QPainter *painter,
+                                                    NodeGraphicsObject &ngo,
+                                                    NodeRenderInfo const &info,
+                                                    NodeStyle const &nodeStyle) const
 {
-    AbstractGraphModel &model = ngo.graphModel();
     NodeId const nodeId = ngo.nodeId();
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    if (!model.nodeData(nodeId, NodeRole::CaptionVisible).toBool())
+    if (!info.captionVisible)
         return;
 
-    QString const name = model.nodeData(nodeId, NodeRole::Caption).toString();
+    QString const &name = info.caption;
 
     QFont f = painter->font();
     f.setBold(true);
 
     QPointF position = geometry.captionPosition(nodeId);
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
-
     painter->setFont(f);
     painter->setPen(nodeStyle.FontColor);
     painter->drawText(position, name);
@@ -218,42 +215,29 @@ void DefaultFlowControlNodePainter::drawNodeCaption(QPainter *painter, NodeGraph
     painter->setFont(f);
 }
 
-void DefaultFlowControlNodePainter::drawEntryLabels(QPainter *painter, NodeGraphicsObject &ngo) const
+void DefaultFlowControlNodePainter::drawEntryLabels(QPainter *painter,
+                                                    NodeGraphicsObject &ngo,
+                                                    NodeRenderInfo const &info,
+                                                    NodeStyle const &nodeStyle) const
 {
     AbstractGraphModel &model = ngo.graphModel();
     NodeId const nodeId = ngo.nodeId();
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
-
     for (PortType portType : {PortType::Out, PortType::In}) {
-        unsigned int n = model.nodeData<unsigned int>(nodeId,
-                                                      (portType == PortType::Out)
-                                                          ? NodeRole::OutPortCount
-                                                          : NodeRole::InPortCount);
+        auto const &ports = info.ports(portType);
 
-        for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
-            auto const &connected = model.connections(nodeId, portType, portIndex);
+        for (PortIndex portIndex = 0; portIndex < ports.size(); ++portIndex) {
+            bool const connected = model.connectionCount(nodeId, portType, portIndex) > 0;
 
             QPointF p = geometry.portTextPosition(nodeId, portType, portIndex);
 
-            if (connected.empty())
+            if (!connected)
                 painter->setPen(nodeStyle.FontColorFaded);
             else
                 painter->setPen(nodeStyle.FontColor);
 
-            QString s;
-
-            if (model.portData<bool>(nodeId, portType, portIndex, PortRole::CaptionVisible)) {
-                s = model.portData<QString>(nodeId, portType, portIndex, PortRole::Caption);
-            } else {
-                auto portData = model.portData(nodeId, portType, portIndex, PortRole::DataType);
-
-                s = portData.value<NodeDataType>().name;
-            }
-
-            painter->drawText(p, s);
+            painter->drawText(p, ports[portIndex].label());
         }
     }
 }
@@ -2,6 +2,7 @@
 
 #include "AbstractGraphModel.hpp"
 #include "NodeData.hpp"
+#include "StyleCollection.hpp"
 
 #include <QPoint>
 #include <QRect>
@@ -25,26 +26,30 @@ DefaultHorizontalNodeGeometry::DefaultHorizontalNodeGeometry(AbstractGraphModel
 
 QSize DefaultHorizontalNodeGeometry::size(NodeId const nodeId) const
 {
-    return _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    return layout(nodeId).size;
 }
 
 void DefaultHorizontalNodeGeometry::recomputeSize(NodeId const nodeId) const
 {
-    unsigned int height = maxVerticalPortsExtent(nodeId);
+    invalidate(nodeId);
+
+    NodeRenderInfo const info = _graphModel.nodeRenderInfo(nodeId);
+
+    unsigned int height = maxVerticalPortsExtent(info);
 
     if (auto w = _graphModel.nodeData<QWidget *>(nodeId, NodeRole::Widget)) {
         height = std::max(height, static_cast<unsigned int>(w->height()));
     }
 
-    QRectF const capRect = captionRect(nodeId);
+    QRectF const capRect = captionRect(info);
 
     height += capRect.height();
 
     height += _portSpasing; // space above caption
     height += _portSpasing; // space below caption
 
-    unsigned int inPortWidth = maxPortsTextAdvance(nodeId, PortType::In);
-    unsigned int outPortWidth = maxPortsTextAdvance(nodeId, PortType::Out);
+    unsigned int inPortWidth = maxPortsTextAdvance(info, PortType::In);
+    unsigned int outPortWidth = maxPortsTextAdvance(info, PortType::Out);
 
     unsigned int width = inPortWidth + outPortWidth + 4 * _portSpasing;
 
@@ -62,6 +67,20 @@ void DefaultHorizontalNodeGeometry::recomputeSize(NodeId const nodeId) const
 QPointF DefaultHorizontalNodeGeometry::portPosition(NodeId const nodeId,
                                                     PortType const portType,
                                                     PortIndex const portIndex) const
+{
+    NodeLayout const &l = layout(nodeId);
+
+    auto const &positions = l.portPositions(portType);
+
+    if (portType != PortType::None && portIndex < positions.size())
+        return positions[portIndex];
+
+    return portPosition(l, portType, portIndex);
+}
+
+QPointF DefaultHorizontalNodeGeometry::portPosition(NodeLayout const &layout,
+                                                    PortType const portType,
+                                                    PortIndex const portIndex) const
 {
     unsigned int const step = _portSize + _portSpasing;
 
@@ -69,13 +88,13 @@ QPointF DefaultHorizontalNodeGeometry::portPosition(NodeId const nodeId,
 
     double totalHeight = 0.0;
 
-    totalHeight += captionRect(nodeId).height();
+    totalHeight += layout.captionRect.height();
     totalHeight += _portSpasing;
 
     totalHeight += step * portIndex;
     totalHeight += step / 2.0;
 
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    QSize size = layout.size;
 
     switch (portType) {
     case PortType::In: {
@@ -103,13 +122,18 @@ QPointF DefaultHorizontalNodeGeometry::portTextPosition(NodeId const nodeId,
                                                         PortType const portType,
                                                         PortIndex const portIndex) const
 {
+    NodeLayout const &l = layout(nodeId);
+
     QPointF p = portPosition(nodeId, portType, portIndex);
 
-    QRectF rect = portTextRect(nodeId, portType, portIndex);
+    auto const &textRects = l.portTextRects(portType);
+
+    QRectF rect = (portIndex < textRects.size()) ? textRects[portIndex]
+                                                 : portTextRect(nodeId, portType, portIndex);
 
     p.setY(p.y() + rect.height() / 4.0);
 
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    QSize size = l.size;
 
     switch (portType) {
     case PortType::In:
@@ -129,44 +153,30 @@ QPointF DefaultHorizontalNodeGeometry::portTextPosition(NodeId const nodeId,
 
 QRectF DefaultHorizontalNodeGeometry::captionRect(NodeId const nodeId) const
 {
-    if (!_graphModel.nodeData<bool>(nodeId, NodeRole::CaptionVisible))
-        return QRect();
+    return layout(nodeId).captionRect;
+}
 
-    QString name = _graphModel.nodeData<QString>(nodeId, NodeRole::Caption);
+QRectF DefaultHorizontalNodeGeometry::captionRect(NodeRenderInfo const &info) const
+{
+    if (!info.captionVisible)
+        return QRect();
 
-    return _boldFontMetrics.boundingRect(name);
+    return _boldFontMetrics.boundingRect(info.caption);
 }
 
 QPointF DefaultHorizontalNodeGeometry::captionPosition(NodeId const nodeId) const
 {
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
-    return QPointF(0.5 * (size.width() - captionRect(nodeId).width()),
-                   0.5 * _portSpasing + captionRect(nodeId).height());
+    return layout(nodeId).captionPosition;
 }
 
 QPointF DefaultHorizontalNodeGeometry::widgetPosition(NodeId const nodeId) const
 {
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
-
-    unsigned int captionHeight = captionRect(nodeId).height();
-
-    if (auto w = _graphModel.nodeData<QWidget *>(nodeId, NodeRole::Widget)) {
-        // If the widget wants to use as much vertical space as possible,
-        // place it immediately after the caption.
-        if (w->sizePolicy().verticalPolicy() & QSizePolicy::ExpandFlag) {
-            return QPointF(2.0 * _portSpasing + maxPortsTextAdvance(nodeId, PortType::In),
-                           captionHeight);
-        } else {
-            return QPointF(2.0 * _portSpasing + maxPortsTextAdvance(nodeId, PortType::In),
-                           (captionHeight + size.height() - w->height()) / 2.0);
-        }
-    }
-    return QPointF();
+    return layout(nodeId).widgetPosition;
 }
 
 QRect DefaultHorizontalNodeGeometry::resizeHandleRect(NodeId const nodeId) const
 {
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    QSize size = layout(nodeId).size;
 
     unsigned int rectSize = 7;
 
@@ -189,11 +199,12 @@ QRectF DefaultHorizontalNodeGeometry::portTextRect(NodeId const nodeId,
     return _fontMetrics.boundingRect(s);
 }
 
-unsigned int DefaultHorizontalNodeGeometry::maxVerticalPortsExtent(NodeId const nodeId) const
+unsigned int DefaultHorizontalNodeGeometry::maxVerticalPortsExtent(
+    NodeRenderInfo const &info) const
 {
-    PortCount nInPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::InPortCount);
+    std::size_t const nInPorts = info.inPorts.size();
 
-    PortCount nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
+    std::size_t const nOutPorts = info.outPorts.size();
 
     unsigned int maxNumOfEntries = std::max(nInPorts, nOutPorts);
     unsigned int step = _portSize + _portSpasing;
@@ -201,30 +212,13 @@ unsigned int DefaultHorizontalNodeGeometry::maxVerticalPortsExtent(NodeId const
     return step * maxNumOfEntries;
 }
 
-unsigned int DefaultHorizontalNodeGeometry::maxPortsTextAdvance(NodeId const nodeId,
+unsigned int DefaultHorizontalNodeGeometry::maxPortsTextAdvance(NodeRenderInfo const &info,
                                                                 PortType const portType) const
 {
     unsigned int width = 0;
 
-    size_t const n = _graphModel
-                         .nodeData(nodeId,
-                                   (portType == PortType::Out) ? NodeRole::OutPortCount
-                                                               : NodeRole::InPortCount)
-                         .toUInt();
-
-    for (PortIndex portIndex = 0ul; portIndex < n; ++portIndex) {
-        QString name;
-
-        if (_graphModel.portData<bool>(nodeId, portType, portIndex, PortRole::CaptionVisible)) {
-            name = _graphModel.portData<QString>(nodeId, portType, portIndex, PortRole::Caption);
-        } else {
-            NodeDataType portData = _graphModel.portData<NodeDataType>(nodeId,
-                                                                       portType,
-                                                                       portIndex,
-                                                                       PortRole::DataType);
-
-            name = portData.name;
-        }
+    for (NodeRenderPortInfo const &port : info.ports(portType)) {
+        QString const &name = port.label();
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
         width = std::max(unsigned(_fontMetrics.horizontalAdvance(name)), width);
@@ -236,4 +230,74 @@ unsigned int DefaultHorizontalNodeGeometry::maxPortsTextAdvance(NodeId const nod
     return width;
 }
 
+void DefaultHorizontalNodeGeometry::invalidate(NodeId const nodeId) const
+{
+    _layouts.erase(nodeId);
+}
+
+void DefaultHorizontalNodeGeometry::invalidateAll() const
+{
+    _layouts.clear();
+}
+
+NodeLayout const &DefaultHorizontalNodeGeometry::layout(NodeId const nodeId) const
+{
+    auto it = _layouts.find(nodeId);
+
+    if (it != _layouts.end() && it->second.styleVersion == StyleCollection::nodeStyleVersion())
+        return it->second;
+
+    NodeLayout &layout = _layouts[nodeId];
+    layout = computeLayout(nodeId);
+    return layout;
+}
+
+NodeLayout DefaultHorizontalNodeGeometry::computeLayout(NodeId const nodeId) const
+{
+    NodeRenderInfo const info = _graphModel.nodeRenderInfo(nodeId);
+
+    NodeLayout layout;
+
+    layout.styleVersion = StyleCollection::nodeStyleVersion();
+    layout.size = info.size;
+
+    layout.captionRect = captionRect(info);
+    layout.captionPosition = QPointF(0.5 * (layout.size.width() - layout.captionRect.width()),
+                                     0.5 * _portSpasing + layout.captionRect.height());
+
+    layout.inPortsTextAdvance = maxPortsTextAdvance(info, PortType::In);
+    layout.outPortsTextAdvance = maxPortsTextAdvance(info, PortType::Out);
+
+    for (PortType portType : {PortType::In, PortType::Out}) {
+        auto const &ports = info.ports(portType);
+
+        auto &positions = (portType == PortType::In) ? layout.inPortPositions
+                                                     : layout.outPortPositions;
+        auto &textRects = (portType == PortType::In) ? layout.inPortTextRects
+                                                     : layout.outPortTextRects;
+
+        for (PortIndex portIndex = 0; portIndex < ports.size(); ++portIndex) {
+            positions.push_back(portPosition(layout, portType, portIndex));
+            textRects.push_back(_fontMetrics.boundingRect(ports[portIndex].label()));
+        }
+    }
+
+    if (auto w = _graphModel.nodeData<QWidget *>(nodeId, NodeRole::Widget)) {
+        unsigned int captionHeight = layout.captionRect.height();
+
+        // If the widget wants to use as much vertical space as possible,
+        // place it immediately after the caption.
+        if (w->sizePolicy().verticalPolicy() & QSizePolicy::ExpandFlag) {
+            layout.widgetPosition = QPointF(2.0 * _portSpasing + layout.inPortsTextAdvance,
+                                            captionHeight);
+        } else {
+            layout.widgetPosition = QPointF(2.0 * _portSpasing + layout.inPortsTextAdvance,
+                                            (captionHeight + layout.size.height() - w->height())
+                                                / 2.0);
+        }
+    }
+
+    return layout;
+}
+
 } // namespace QtNodes
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "AbstractNodeGeometry.hpp"
+#include "NodeLayout.hpp"
+#include "NodeRenderInfo.hpp"
 
 #include <QtGui/QFontMetrics>
 
+#include <unordered_map>
+
 namespace QtNodes {
 
 class AbstractGraphModel;
@@ -34,15 +38,30 @@ public:
 
     QRect resizeHandleRect(NodeId const nodeId) const override;
 
+    void invalidate(NodeId const nodeId) const override;
+
+    void invalidateAll() const override;
+
 private:
+    /// Returns the cached layout, computes it first if needed.
+    NodeLayout const &layout(NodeId const nodeId) const;
+
+    NodeLayout computeLayout(NodeId const nodeId) const;
+
+    QPointF portPosition(NodeLayout const &layout,
+                         PortType const portType,
+                         PortIndex const portIndex) const;
+
+    QRectF captionRect(NodeRenderInfo const &info) const;
+
     QRectF portTextRect(NodeId const nodeId,
                         PortType const portType,
                         PortIndex const portIndex) const;
 
     /// Finds max number of ports and multiplies by (a port height + interval)
-    unsigned int maxVerticalPortsExtent(NodeId const nodeId) const;
+    unsigned int maxVerticalPortsExtent(NodeRenderInfo const &info) const;
 
-    unsigned int maxPortsTextAdvance(NodeId const nodeId, PortType const portType) const;
+    unsigned int maxPortsTextAdvance(NodeRenderInfo const &info, PortType const portType) const;
 
 private:
     // Some variables are mutable because we need to change drawing
@@ -53,6 +72,8 @@ private:
     unsigned int _portSpasing;
     mutable QFontMetrics _fontMetrics;
     mutable QFontMetrics _boldFontMetrics;
+
+    mutable std::unordered_map<NodeId, NodeLayout> _layouts;
 };
 
 } // namespace QtNodes
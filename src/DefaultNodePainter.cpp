@@ -2,14 +2,15 @@
 
 #include <cmath>
 
-#include <QFileInfo>
 #include <QtCore/QMargins>
+#include <QtWidgets/QStyleOptionGraphicsItem>
 
 #include "AbstractGraphModel.hpp"
 #include "AbstractNodeGeometry.hpp"
 #include "BasicGraphicsScene.hpp"
 #include "ConnectionGraphicsObject.hpp"
 #include "ConnectionIdUtils.hpp"
+#include "IconCache.hpp"
 #include "NodeGraphicsObject.hpp"
 #include "NodeState.hpp"
 #include "StyleCollection.hpp"
@@ -20,38 +21,69 @@ void DefaultNodePainter::paint(QPainter *painter, NodeGraphicsObject &ngo) const
 {
     AbstractGraphModel &model = ngo.graphModel();
     NodeId const nodeId = ngo.nodeId();
-    QJsonDocument json = QJsonDocument::fromVariant(model.nodeData(nodeId, NodeRole::Style));
-    NodeStyle nodeStyle(json.object());
+    std::shared_ptr<NodeStyle const> style = model.nodeStyle(nodeId);
+    NodeStyle const &nodeStyle = *style;
 
-    drawNodeRect(painter, ngo, nodeStyle);
+    NodeRenderInfo const info = model.nodeRenderInfo(nodeId);
 
-    drawCaptionRect(painter, ngo, nodeStyle);
+    // Device coordinate caching renders with the view scale, so the world
+    // transform tells how large the node appears on screen.
+    qreal const lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(
+        painter->worldTransform());
 
-    drawConnectionPoints(painter, ngo, nodeStyle);
+    if (lod < nodeStyle.SimplifiedLevelOfDetail) {
+        drawSimplifiedNode(painter, ngo, info, nodeStyle);
+        return;
+    }
+
+    drawNodeRect(painter, ngo, info, nodeStyle);
+
+    drawCaptionRect(painter, ngo, info, nodeStyle);
+
+    if (lod < nodeStyle.TextLevelOfDetail)
+        return;
+
+    drawNodeDescription(painter, ngo, info);
 
-    drawFilledConnectionPoints(painter, ngo, nodeStyle);
+    drawConnectionPoints(painter, ngo, info, nodeStyle);
 
-    drawNodeCaption(painter, ngo, nodeStyle);
+    drawFilledConnectionPoints(painter, ngo, info, nodeStyle);
 
-    drawShowTime(painter, ngo);
-    drawNodeIcon(painter, ngo);
+    drawNodeCaption(painter, ngo, info, nodeStyle);
+
+    drawShowTime(painter, ngo, info);
+    drawNodeIcon(painter, ngo, info);
     drawOperationIcon(painter, ngo);
-    drawOperationResult(painter, ngo);
+    drawOperationResult(painter, ngo, info);
     //drawEntryLabels(painter, ngo);
 
     drawResizeRect(painter, ngo);
 }
 
+void DefaultNodePainter::drawSimplifiedNode(QPainter *painter,
+                                            NodeGraphicsObject &ngo,
+                                            NodeRenderInfo const &info,
+                                            const NodeStyle &nodeStyle) const
+{
+    QSize size = info.size;
+
+    QRect boundary(0,
+                   DEFAULT_NODE_HIGH_BEGIN,
+                   size.width(),
+                   size.height() - DEFAULT_NODE_HIGH_BEGIN);
+
+    painter->fillRect(boundary, nodeStyle.GradientColor2);
+
+    drawCaptionRect(painter, ngo, info, nodeStyle);
+}
+
 void DefaultNodePainter::drawCaptionRect(QPainter *painter,
                                          NodeGraphicsObject &ngo,
+                                         NodeRenderInfo const &info,
                                          const NodeStyle &nodeStyle) const
 {
-    AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
-    AbstractGraphModel &model = ngo.graphModel();
-    NodeId const nodeId = ngo.nodeId();
-
-    QSize size = geometry.size(ngo.nodeId());
-    bool bRun = model.nodeData(nodeId, NodeRole::Running).toBool();
+    QSize size = info.size;
+    bool bRun = info.running;
 
     QRect captionRect(0 + 1, DEFAULT_NODE_HIGH_BEGIN + 1, size.width() - 2, NODE_CAPTION_HIGH - 1);
     QColor color = QColor("#253749");
@@ -65,8 +97,15 @@ void DefaultNodePainter::drawCaptionRect(QPainter *painter,
         color = QColor(nodeStyle.NormalCaptionRectColor);
 
     painter->fillRect(captionRect, QBrush(color));
+}
+
+void DefaultNodePainter::drawNodeDescription(QPainter *painter,
+                                             NodeGraphicsObject &ngo,
+                                             NodeRenderInfo const &info) const
+{
+    Q_UNUSED(ngo);
 
-    QString strDesprition = model.nodeData(nodeId, NodeRole::Description).toString();
+    QString const &strDesprition = info.description;
     QRect descriptionRect(BORDER_SPACE,
                           DEFAULT_NODE_HIGH_BEGIN + VERTICAL_BORDER_SPACE,
                           100,
@@ -84,16 +123,11 @@ void DefaultNodePainter::drawCaptionRect(QPainter *painter,
 
 void DefaultNodePainter::drawNodeRect(QPainter *painter,
                                       NodeGraphicsObject &ngo,
+                                      NodeRenderInfo const &info,
                                       const NodeStyle &nodeStyle) const
 {
-    AbstractGraphModel &model = ngo.graphModel();
-
-    NodeId const nodeId = ngo.nodeId();
-
-    AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
-
-    QSize size = geometry.size(nodeId);
-    bool bRun = model.nodeData(nodeId, NodeRole::Running).toBool();
+    QSize size = info.size;
+    bool bRun = info.running;
 
     auto color = nodeStyle.NormalBoundaryColor;
     if (bRun)
@@ -134,6 +168,7 @@ void DefaultNodePainter::drawNodeRect(QPainter *painter,
 
 void DefaultNodePainter::drawConnectionPoints(QPainter *painter,
                                               NodeGraphicsObject &ngo,
+                                              NodeRenderInfo const &info,
                                               const NodeStyle &nodeStyle) const
 {
     AbstractGraphModel &model = ngo.graphModel();
@@ -146,17 +181,12 @@ void DefaultNodePainter::drawConnectionPoints(QPainter *painter,
     auto reducedDiameter = diameter * 0.6;
 
     for (PortType portType : {PortType::Out, PortType::In}) {
-        size_t const n = model
-                             .nodeData(nodeId,
-                                       (portType == PortType::Out) ? NodeRole::OutPortCount
-                                                                   : NodeRole::InPortCount)
-                             .toUInt();
+        auto const &ports = info.ports(portType);
 
-        for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
+        for (PortIndex portIndex = 0; portIndex < ports.size(); ++portIndex) {
             QPointF p = geometry.portPosition(nodeId, portType, portIndex);
 
-            auto const &dataType = model.portData(nodeId, portType, portIndex, PortRole::DataType)
-                                       .value<NodeDataType>();
+            NodeDataType const &dataType = ports[portIndex].dataType;
 
             double r = 1.0;
 
@@ -189,7 +219,7 @@ void DefaultNodePainter::drawConnectionPoints(QPainter *painter,
             }
 
             if (connectionStyle.useDataDefinedColors()) {
-                painter->setBrush(connectionStyle.normalColor(dataType.id));
+                painter->setBrush(connectionStyle.normalColor(dataType));
             } else {
                 painter->setBrush(nodeStyle.ConnectionPointColor);
             }
@@ -206,6 +236,7 @@ void DefaultNodePainter::drawConnectionPoints(QPainter *painter,
 
 void DefaultNodePainter::drawFilledConnectionPoints(QPainter *painter,
                                                     NodeGraphicsObject &ngo,
+                                                    NodeRenderInfo const &info,
                                                     const NodeStyle &nodeStyle) const
 {
     AbstractGraphModel &model = ngo.graphModel();
@@ -215,25 +246,17 @@ void DefaultNodePainter::drawFilledConnectionPoints(QPainter *painter,
     auto diameter = nodeStyle.ConnectionPointDiameter;
 
     for (PortType portType : {PortType::Out, PortType::In}) {
-        size_t const n = model
-                             .nodeData(nodeId,
-                                       (portType == PortType::Out) ? NodeRole::OutPortCount
-                                                                   : NodeRole::InPortCount)
-                             .toUInt();
+        auto const &ports = info.ports(portType);
 
-        for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
+        for (PortIndex portIndex = 0; portIndex < ports.size(); ++portIndex) {
             QPointF p = geometry.portPosition(nodeId, portType, portIndex);
 
-            auto const &connected = model.connections(nodeId, portType, portIndex);
-
-            if (!connected.empty()) {
-                auto const &dataType = model
-                                           .portData(nodeId, portType, portIndex, PortRole::DataType)
-                                           .value<NodeDataType>();
+            if (model.connectionCount(nodeId, portType, portIndex) > 0) {
+                NodeDataType const &dataType = ports[portIndex].dataType;
 
                 auto const &connectionStyle = StyleCollection::connectionStyle();
                 if (connectionStyle.useDataDefinedColors()) {
-                    QColor const c = connectionStyle.normalColor(dataType.id);
+                    QColor const c = connectionStyle.normalColor(dataType);
                     painter->setPen(c);
                     painter->setBrush(c);
                 } else {
@@ -249,16 +272,16 @@ void DefaultNodePainter::drawFilledConnectionPoints(QPainter *painter,
 
 void DefaultNodePainter::drawNodeCaption(QPainter *painter,
                                          NodeGraphicsObject &ngo,
+                                         NodeRenderInfo const &info,
                                          const NodeStyle &nodeStyle) const
 {
-    AbstractGraphModel &model = ngo.graphModel();
-    NodeId const nodeId = ngo.nodeId();
+    Q_UNUSED(ngo);
     //AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
-    if (!model.nodeData(nodeId, NodeRole::CaptionVisible).toBool())
+    if (!info.captionVisible)
         return;
 
-    QString const name = model.nodeData(nodeId, NodeRole::Caption).toString();
+    QString const &name = info.caption;
 
     QFont f = painter->font();
     f.setBold(true);
@@ -281,6 +304,7 @@ void DefaultNodePainter::drawNodeCaption(QPainter *painter,
 
 void DefaultNodePainter::drawEntryLabels(QPainter *painter,
                                          NodeGraphicsObject &ngo,
+                                         NodeRenderInfo const &info,
                                          const NodeStyle &nodeStyle) const
 {
     AbstractGraphModel &model = ngo.graphModel();
@@ -288,32 +312,19 @@ void DefaultNodePainter::drawEntryLabels(QPainter *painter,
     AbstractNodeGeometry &geometry = ngo.nodeScene()->nodeGeometry();
 
     for (PortType portType : {PortType::Out, PortType::In}) {
-        unsigned int n = model.nodeData<unsigned int>(nodeId,
-                                                      (portType == PortType::Out)
-                                                          ? NodeRole::OutPortCount
-                                                          : NodeRole::InPortCount);
+        auto const &ports = info.ports(portType);
 
-        for (PortIndex portIndex = 0; portIndex < n; ++portIndex) {
-            auto const &connected = model.connections(nodeId, portType, portIndex);
+        for (PortIndex portIndex = 0; portIndex < ports.size(); ++portIndex) {
+            bool const connected = model.connectionCount(nodeId, portType, portIndex) > 0;
 
             QPointF p = geometry.portTextPosition(nodeId, portType, portIndex);
 
-            if (connected.empty())
+            if (!connected)
                 painter->setPen(nodeStyle.FontColorFaded);
             else
                 painter->setPen(nodeStyle.FontColor);
 
-            QString s;
-
-            if (model.portData<bool>(nodeId, portType, portIndex, PortRole::CaptionVisible)) {
-                s = model.portData<QString>(nodeId, portType, portIndex, PortRole::Caption);
-            } else {
-                auto portData = model.portData(nodeId, portType, portIndex, PortRole::DataType);
-
-                s = portData.value<NodeDataType>().name;
-            }
-
-            painter->drawText(p, s);
+            painter->drawText(p, ports[portIndex].label());
         }
     }
 }
@@ -331,12 +342,13 @@ void DefaultNodePainter::drawResizeRect(QPainter *painter, NodeGraphicsObject &n
     }
 }
 //showNode exec Time
-void DefaultNodePainter::drawShowTime(QPainter *painter, NodeGraphicsObject &ngo) const
+void DefaultNodePainter::drawShowTime(QPainter *painter,
+                                      NodeGraphicsObject &ngo,
+                                      NodeRenderInfo const &info) const
 {
-    AbstractGraphModel &model = ngo.graphModel();
-    NodeId const nodeId = ngo.nodeId();
+    Q_UNUSED(ngo);
 
-    int nTime = model.nodeData(nodeId, NodeRole::Time).toInt();
+    int nTime = info.computeTime;
     if (nTime == 0)
         return;
 
@@ -353,82 +365,62 @@ void DefaultNodePainter::drawShowTime(QPainter *painter, NodeGraphicsObject &ngo
     painter->restore();
 }
 
-void DefaultNodePainter::drawNodeIcon(QPainter *painter, NodeGraphicsObject &ngo) const
+void DefaultNodePainter::drawNodeIcon(QPainter *painter,
+                                      NodeGraphicsObject &ngo,
+                                      NodeRenderInfo const &info) const
 {
-    AbstractGraphModel &model = ngo.graphModel();
-    NodeId const nodeId = ngo.nodeId();
-
-    QString strIcon = model.nodeData(nodeId, NodeRole::Icon).toString();
-
-    bool bRun = model.nodeData(nodeId, NodeRole::Running).toBool();
-    int nIndex = strIcon.indexOf(".svg");
-    if (nIndex > 0) {
-        if (bRun)
-            strIcon.insert(nIndex, "_running");
-        else if (ngo.nodeState().hovered())
-            strIcon.insert(nIndex, "_hover");
-        else if (ngo.isSelected())
-            strIcon.insert(nIndex, "_selected");
-    }
+    QString const &strIcon = info.icon;
 
     if (strIcon.isEmpty())
         return;
 
-    QRect iconRect(BORDER_SPACE, NODE_CAPTION_HIGH + DEFAULT_NODE_HIGH_BEGIN + BORDER_SPACE, 16, 16);
+    QString state;
+    if (info.running)
+        state = "running";
+    else if (ngo.nodeState().hovered())
+        state = "hover";
+    else if (ngo.isSelected())
+        state = "selected";
 
-    QFileInfo fileInfo(strIcon);
-    if (!fileInfo.exists())
-        strIcon = model.nodeData(nodeId, NodeRole::Icon).toString();
+    QRect iconRect(BORDER_SPACE, NODE_CAPTION_HIGH + DEFAULT_NODE_HIGH_BEGIN + BORDER_SPACE, 16, 16);
 
-    QPixmap pixmap = RenderingSvg(strIcon);
+    QPixmap pixmap = IconCache::pixmap(IconCache::statePath(strIcon, state),
+                                       painter->device()->devicePixelRatioF());
 
     painter->drawPixmap(iconRect, pixmap, pixmap.rect());
 }
 
 void DefaultNodePainter::drawOperationIcon(QPainter *painter, NodeGraphicsObject &ngo) const
 {
-    QPixmap stepPixmap = RenderingSvg(":/imgs/step_next.svg");
-    QPixmap overPixmap = RenderingSvg(":/imgs/step_over.svg");
+    qreal const dpr = painter->device()->devicePixelRatioF();
+
+    QPixmap stepPixmap = IconCache::pixmap(":/imgs/step_next.svg", dpr);
+    QPixmap overPixmap = IconCache::pixmap(":/imgs/step_over.svg", dpr);
     painter->drawPixmap(ngo.GetStepNextRect(), stepPixmap, stepPixmap.rect());
     painter->drawPixmap(ngo.GetStepOverRect(), overPixmap, overPixmap.rect());
 }
 
-void DefaultNodePainter::drawOperationResult(QPainter *painter, NodeGraphicsObject &ngo) const
+void DefaultNodePainter::drawOperationResult(QPainter *painter,
+                                             NodeGraphicsObject &ngo,
+                                             NodeRenderInfo const &info) const
 {
-    AbstractGraphModel &model = ngo.graphModel();
-    NodeId const nodeId = ngo.nodeId();
+    Q_UNUSED(ngo);
+
+    NodeResultType resultType = info.result;
+    qreal const dpr = painter->device()->devicePixelRatioF();
 
-    NodeResultType resultType = (NodeResultType) model.nodeData(nodeId, NodeRole::ResultValue)
-                                    .toInt();
     QPixmap iconPixmap;
     if (resultType == NodeResultType::ResultType_NONE)
         return;
     else if (resultType == NodeResultType::ResultType_FAILED) {
-        iconPixmap = RenderingSvg(":/imgs/tip_failed.svg");
+        iconPixmap = IconCache::pixmap(":/imgs/tip_failed.svg", dpr);
     } else if (resultType == NodeResultType::ResultType_SUCCEED) {
-        iconPixmap = RenderingSvg(":/imgs/tip_success.svg");
+        iconPixmap = IconCache::pixmap(":/imgs/tip_success.svg", dpr);
     } else if (resultType == NodeResultType::ResultType_UNREACHABLE) {
-        iconPixmap = RenderingSvg(":/imgs/tip_error.svg");
+        iconPixmap = IconCache::pixmap(":/imgs/tip_error.svg", dpr);
     }
     QRect iconTarget(0, 0, 17, 17);
     painter->drawPixmap(iconTarget, iconPixmap, iconPixmap.rect());
 }
 
-inline QPixmap DefaultNodePainter::RenderingSvg(const QString &strPath) const
-{
-    QSvgRenderer renderer(strPath);
-    if (!renderer.isValid())
-        return QPixmap();
-
-    QSize svgSize = renderer.defaultSize(); // 获取SVG默认大小
-    svgSize *= 2;                           // 将分辨率提高2倍
-    // 渲染SVG到QPixmap
-    QPixmap pixmap(svgSize);
-    pixmap.fill(Qt::transparent);
-    QPainter painter(&pixmap);
-    painter.setRenderHint(QPainter::Antialiasing, true);
-    renderer.render(&painter);
-    return pixmap;
-}
-
 } // namespace QtNodes
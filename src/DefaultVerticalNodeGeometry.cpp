@@ -2,6 +2,7 @@
 
 #include "AbstractGraphModel.hpp"
 #include "NodeData.hpp"
+#include "StyleCollection.hpp"
 
 #include <QPoint>
 #include <QRect>
@@ -29,34 +30,38 @@ DefaultVerticalNodeGeometry::DefaultVerticalNodeGeometry(AbstractGraphModel &gra
 
 QSize DefaultVerticalNodeGeometry::size(NodeId const nodeId) const
 {
-    return _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    return layout(nodeId).size;
 }
 
 void DefaultVerticalNodeGeometry::recomputeSize(NodeId const nodeId) const
 {
+    invalidate(nodeId);
+
+    NodeRenderInfo const info = _graphModel.nodeRenderInfo(nodeId);
+
     unsigned int height = _portSpasing; // maxHorizontalPortsExtent(nodeId);
 
     if (auto w = _graphModel.nodeData<QWidget *>(nodeId, NodeRole::Widget)) {
         height = std::max(height, static_cast<unsigned int>(w->height()));
     }
 
-    QRectF const capRect = captionRect(nodeId);
+    QRectF const capRect = captionRect(info);
 
     height += capRect.height();
 
     height += _portSpasing;
     height += _portSpasing;
 
-    PortCount nInPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::InPortCount);
-    PortCount nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
+    PortCount nInPorts = info.inPorts.size();
+    PortCount nOutPorts = info.outPorts.size();
 
     // Adding double step (top and bottom) to reserve space for port captions.
 
-    height += portCaptionsHeight(nodeId, PortType::In);
-    height += portCaptionsHeight(nodeId, PortType::Out);
+    height += portCaptionsHeight(info, PortType::In);
+    height += portCaptionsHeight(info, PortType::Out);
 
-    unsigned int inPortWidth = maxPortsTextAdvance(nodeId, PortType::In);
-    unsigned int outPortWidth = maxPortsTextAdvance(nodeId, PortType::Out);
+    unsigned int inPortWidth = maxPortsTextAdvance(info, PortType::In);
+    unsigned int outPortWidth = maxPortsTextAdvance(info, PortType::Out);
 
     unsigned int totalInPortsWidth = nInPorts > 0
                                          ? inPortWidth * nInPorts + _portSpasing * (nInPorts - 1)
@@ -77,7 +82,7 @@ void DefaultVerticalNodeGeometry::recomputeSize(NodeId const nodeId) const
     width += _portSpasing;
     width += _portSpasing;
 
-    NodePaintType paintType =(NodePaintType) _graphModel.nodeData(nodeId, NodeRole::PaintType).toInt();
+    NodePaintType paintType = (NodePaintType) info.paintType;
     if (NodePaintType::PaintType_FLOWCONTROL == paintType){
         width = 178;
         height = 72;
@@ -94,16 +99,30 @@ void DefaultVerticalNodeGeometry::recomputeSize(NodeId const nodeId) const
 QPointF DefaultVerticalNodeGeometry::portPosition(NodeId const nodeId,
                                                   PortType const portType,
                                                   PortIndex const portIndex) const
+{
+    NodeLayout const &l = layout(nodeId);
+
+    auto const &positions = l.portPositions(portType);
+
+    if (portType != PortType::None && portIndex < positions.size())
+        return positions[portIndex];
+
+    return portPosition(l, portType, portIndex);
+}
+
+QPointF DefaultVerticalNodeGeometry::portPosition(NodeLayout const &layout,
+                                                  PortType const portType,
+                                                  PortIndex const portIndex) const
 {
     QPointF result;
 
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    QSize size = layout.size;
 
     switch (portType) {
     case PortType::In: {
-        unsigned int inPortWidth = maxPortsTextAdvance(nodeId, PortType::In) + _portSpasing;
+        unsigned int inPortWidth = layout.inPortsTextAdvance + _portSpasing;
 
-        PortCount nInPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::InPortCount);
+        PortCount nInPorts = layout.inPortTextRects.size();
 
         double x = (size.width() - (nInPorts - 1) * inPortWidth) / 2.0 + portIndex * inPortWidth;
 
@@ -117,8 +136,8 @@ QPointF DefaultVerticalNodeGeometry::portPosition(NodeId const nodeId,
     }
 
     case PortType::Out: {
-        unsigned int outPortWidth = maxPortsTextAdvance(nodeId, PortType::Out) + _portSpasing;
-        PortCount nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
+        unsigned int outPortWidth = layout.outPortsTextAdvance + _portSpasing;
+        PortCount nOutPorts = layout.outPortTextRects.size();
 
         double x = (size.width() - (nOutPorts - 1) * outPortWidth) / 2.0 + portIndex * outPortWidth;
 
@@ -142,13 +161,18 @@ QPointF DefaultVerticalNodeGeometry::portTextPosition(NodeId const nodeId,
                                                       PortType const portType,
                                                       PortIndex const portIndex) const
 {
+    NodeLayout const &l = layout(nodeId);
+
     QPointF p = portPosition(nodeId, portType, portIndex);
 
-    QRectF rect = portTextRect(nodeId, portType, portIndex);
+    auto const &textRects = l.portTextRects(portType);
+
+    QRectF rect = (portIndex < textRects.size()) ? textRects[portIndex]
+                                                 : portTextRect(nodeId, portType, portIndex);
 
     p.setX(p.x() - rect.width() / 2.0);
 
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    QSize size = l.size;
 
     switch (portType) {
     case PortType::In:
@@ -168,54 +192,30 @@ QPointF DefaultVerticalNodeGeometry::portTextPosition(NodeId const nodeId,
 
 QRectF DefaultVerticalNodeGeometry::captionRect(NodeId const nodeId) const
 {
-    if (!_graphModel.nodeData<bool>(nodeId, NodeRole::CaptionVisible))
-        return QRect();
+    return layout(nodeId).captionRect;
+}
 
-    QString name = _graphModel.nodeData<QString>(nodeId, NodeRole::Caption);
+QRectF DefaultVerticalNodeGeometry::captionRect(NodeRenderInfo const &info) const
+{
+    if (!info.captionVisible)
+        return QRect();
 
-    return _boldFontMetrics.boundingRect(name);
+    return _boldFontMetrics.boundingRect(info.caption);
 }
 
 QPointF DefaultVerticalNodeGeometry::captionPosition(NodeId const nodeId) const
 {
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
-
-    unsigned int step = portCaptionsHeight(nodeId, PortType::In);
-    step += _portSpasing + DEFAULT_NODE_HIGH_BEGIN;
-
-    auto rect = captionRect(nodeId);
-
-    return QPointF(0.5 * (size.width() - rect.width()), step + rect.height());
+    return layout(nodeId).captionPosition;
 }
 
 QPointF DefaultVerticalNodeGeometry::widgetPosition(NodeId const nodeId) const
 {
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
-    NodePaintType paintType =(NodePaintType) _graphModel.nodeData(nodeId, NodeRole::PaintType).toInt();
-
-    unsigned int captionHeight = captionRect(nodeId).height();
-    auto w = _graphModel.nodeData<QWidget *>(nodeId, NodeRole::Widget);
-
-    if(NodePaintType::PaintType_FLOWCONTROL == paintType && w){
-        return QPointF((size.width() - w->width())/2.0 ,(size.height() - w->height())/2.0);
-    }
-
-    if (w) {
-        // If the widget wants to use as much vertical space as possible,
-        // place it immediately after the caption.
-        if (w->sizePolicy().verticalPolicy() & QSizePolicy::ExpandFlag) {
-            return QPointF(_portSpasing + maxPortsTextAdvance(nodeId, PortType::In), captionHeight);
-        } else {
-            return QPointF(_portSpasing + maxPortsTextAdvance(nodeId, PortType::In),
-                           (captionHeight + size.height() - w->height()) / 2.0);
-        }
-    }
-    return QPointF();
+    return layout(nodeId).widgetPosition;
 }
 
 QRect DefaultVerticalNodeGeometry::resizeHandleRect(NodeId const nodeId) const
 {
-    QSize size = _graphModel.nodeData<QSize>(nodeId, NodeRole::Size);
+    QSize size = layout(nodeId).size;
 
     unsigned int rectSize = 7;
 
@@ -238,11 +238,11 @@ QRectF DefaultVerticalNodeGeometry::portTextRect(NodeId const nodeId,
     return _fontMetrics.boundingRect(s);
 }
 
-unsigned int DefaultVerticalNodeGeometry::maxHorizontalPortsExtent(NodeId const nodeId) const
+unsigned int DefaultVerticalNodeGeometry::maxHorizontalPortsExtent(NodeRenderInfo const &info) const
 {
-    PortCount nInPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::InPortCount);
+    PortCount nInPorts = info.inPorts.size();
 
-    PortCount nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
+    PortCount nOutPorts = info.outPorts.size();
 
     unsigned int maxNumOfEntries = std::max(nInPorts, nOutPorts);
     unsigned int step = _portSize + _portSpasing;
@@ -250,30 +250,13 @@ unsigned int DefaultVerticalNodeGeometry::maxHorizontalPortsExtent(NodeId const
     return step * maxNumOfEntries;
 }
 
-unsigned int DefaultVerticalNodeGeometry::maxPortsTextAdvance(NodeId const nodeId,
+unsigned int DefaultVerticalNodeGeometry::maxPortsTextAdvance(NodeRenderInfo const &info,
                                                               PortType const portType) const
 {
     unsigned int width = 0;
 
-    size_t const n = _graphModel
-                         .nodeData(nodeId,
-                                   (portType == PortType::Out) ? NodeRole::OutPortCount
-                                                               : NodeRole::InPortCount)
-                         .toUInt();
-
-    for (PortIndex portIndex = 0ul; portIndex < n; ++portIndex) {
-        QString name;
-
-        if (_graphModel.portData<bool>(nodeId, portType, portIndex, PortRole::CaptionVisible)) {
-            name = _graphModel.portData<QString>(nodeId, portType, portIndex, PortRole::Caption);
-        } else {
-            NodeDataType portData = _graphModel.portData<NodeDataType>(nodeId,
-                                                                       portType,
-                                                                       portIndex,
-                                                                       PortRole::DataType);
-
-            name = portData.name;
-        }
+    for (NodeRenderPortInfo const &port : info.ports(portType)) {
+        QString const &name = port.label();
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
         width = std::max(unsigned(_fontMetrics.horizontalAdvance(name)), width);
@@ -285,39 +268,101 @@ unsigned int DefaultVerticalNodeGeometry::maxPortsTextAdvance(NodeId const nodeI
     return width;
 }
 
-unsigned int DefaultVerticalNodeGeometry::portCaptionsHeight(NodeId const nodeId,
+unsigned int DefaultVerticalNodeGeometry::portCaptionsHeight(NodeRenderInfo const &info,
                                                              PortType const portType) const
 {
     unsigned int h = DEFAULT_NODE_HIGH_BEGIN;
 
-    switch (portType) {
-    case PortType::In: {
-        PortCount nInPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::InPortCount);
-        for (PortIndex i = 0; i < nInPorts; ++i) {
-            if (_graphModel.portData<bool>(nodeId, PortType::In, i, PortRole::CaptionVisible)) {
-                h += _portSpasing;
-                break;
-            }
+    for (NodeRenderPortInfo const &port : info.ports(portType)) {
+        if (port.captionVisible) {
+            h += _portSpasing;
+            break;
         }
-        break;
     }
 
-    case PortType::Out: {
-        PortCount nOutPorts = _graphModel.nodeData<PortCount>(nodeId, NodeRole::OutPortCount);
-        for (PortIndex i = 0; i < nOutPorts; ++i) {
-            if (_graphModel.portData<bool>(nodeId, PortType::Out, i, PortRole::CaptionVisible)) {
-                h += _portSpasing;
-                break;
-            }
-        }
-        break;
+    return h;
+}
+
+void DefaultVerticalNodeGeometry::invalidate(NodeId const nodeId) const
+{
+    _layouts.erase(nodeId);
+}
+
+void DefaultVerticalNodeGeometry::invalidateAll() const
+{
+    _layouts.clear();
+}
+
+NodeLayout const &DefaultVerticalNodeGeometry::layout(NodeId const nodeId) const
+{
+    auto it = _layouts.find(nodeId);
+
+    if (it != _layouts.end() && it->second.styleVersion == StyleCollection::nodeStyleVersion())
+        return it->second;
+
+    NodeLayout &layout = _layouts[nodeId];
+    layout = computeLayout(nodeId);
+    return layout;
+}
+
+NodeLayout DefaultVerticalNodeGeometry::computeLayout(NodeId const nodeId) const
+{
+    NodeRenderInfo const info = _graphModel.nodeRenderInfo(nodeId);
+
+    NodeLayout layout;
+
+    layout.styleVersion = StyleCollection::nodeStyleVersion();
+    layout.size = info.size;
+
+    layout.inPortsTextAdvance = maxPortsTextAdvance(info, PortType::In);
+    layout.outPortsTextAdvance = maxPortsTextAdvance(info, PortType::Out);
+
+    // Port positions depend on the number of text rects, fill them first.
+    for (NodeRenderPortInfo const &port : info.inPorts) {
+        layout.inPortTextRects.push_back(_fontMetrics.boundingRect(port.label()));
     }
 
-    default:
-        break;
+    for (NodeRenderPortInfo const &port : info.outPorts) {
+        layout.outPortTextRects.push_back(_fontMetrics.boundingRect(port.label()));
     }
 
-    return h;
+    for (PortIndex portIndex = 0; portIndex < info.inPorts.size(); ++portIndex) {
+        layout.inPortPositions.push_back(portPosition(layout, PortType::In, portIndex));
+    }
+
+    for (PortIndex portIndex = 0; portIndex < info.outPorts.size(); ++portIndex) {
+        layout.outPortPositions.push_back(portPosition(layout, PortType::Out, portIndex));
+    }
+
+    layout.captionRect = captionRect(info);
+
+    unsigned int step = portCaptionsHeight(info, PortType::In);
+    step += _portSpasing + DEFAULT_NODE_HIGH_BEGIN;
+
+    layout.captionPosition = QPointF(0.5 * (layout.size.width() - layout.captionRect.width()),
+                                     step + layout.captionRect.height());
+
+    unsigned int captionHeight = layout.captionRect.height();
+
+    if (auto w = _graphModel.nodeData<QWidget *>(nodeId, NodeRole::Widget)) {
+        NodePaintType paintType = (NodePaintType) info.paintType;
+
+        if (NodePaintType::PaintType_FLOWCONTROL == paintType) {
+            layout.widgetPosition = QPointF((layout.size.width() - w->width()) / 2.0,
+                                            (layout.size.height() - w->height()) / 2.0);
+        } else if (w->sizePolicy().verticalPolicy() & QSizePolicy::ExpandFlag) {
+            // If the widget wants to use as much vertical space as possible,
+            // place it immediately after the caption.
+            layout.widgetPosition = QPointF(_portSpasing + layout.inPortsTextAdvance,
+                                            captionHeight);
+        } else {
+            layout.widgetPosition = QPointF(_portSpasing + layout.inPortsTextAdvance,
+                                            (captionHeight + layout.size.height() - w->height())
+                                                / 2.0);
+        }
+    }
+
+    return layout;
 }
 
 } // namespace QtNodes
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "AbstractNodeGeometry.hpp"
+#include "NodeLayout.hpp"
+#include "NodeRenderInfo.hpp"
 
 #include <QtGui/QFontMetrics>
 
+#include <unordered_map>
+
 namespace QtNodes {
 
 class AbstractGraphModel;
@@ -35,16 +39,31 @@ public:
 
     QRect resizeHandleRect(NodeId const nodeId) const override;
 
+    void invalidate(NodeId const nodeId) const override;
+
+    void invalidateAll() const override;
+
 private:
+    /// Returns the cached layout, computes it first if needed.
+    NodeLayout const &layout(NodeId const nodeId) const;
+
+    NodeLayout computeLayout(NodeId const nodeId) const;
+
+    QPointF portPosition(NodeLayout const &layout,
+                         PortType const portType,
+                         PortIndex const portIndex) const;
+
+    QRectF captionRect(NodeRenderInfo const &info) const;
+
     QRectF portTextRect(NodeId const nodeId,
                         PortType const portType,
                         PortIndex const portIndex) const;
     /// Finds
-    unsigned int maxHorizontalPortsExtent(NodeId const nodeId) const;
+    unsigned int maxHorizontalPortsExtent(NodeRenderInfo const &info) const;
 
-    unsigned int maxPortsTextAdvance(NodeId const nodeId, PortType const portType) const;
+    unsigned int maxPortsTextAdvance(NodeRenderInfo const &info, PortType const portType) const;
 
-    unsigned int portCaptionsHeight(NodeId const nodeId, PortType const portType) const;
+    unsigned int portCaptionsHeight(NodeRenderInfo const &info, PortType const portType) const;
 
 private:
     // Some variables are mutable because we need to change drawing
@@ -55,6 +74,8 @@ private:
     unsigned int _portSpasing;
     mutable QFontMetrics _fontMetrics;
     mutable QFontMetrics _boldFontMetrics;
+
+    mutable std::unordered_map<NodeId, NodeLayout> _layouts;
 };
 
 } // namespace QtNodes
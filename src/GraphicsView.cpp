@@ -9,9 +9,11 @@
 #include <QtWidgets/QGraphicsScene>
 
 #include <QtGui/QBrush>
+#include <QtGui/QPainterPath>
 #include <QtGui/QPen>
 
 #include <QtWidgets/QMenu>
+#include <QtWidgets/QRubberBand>
 
 #include <QtCore/QDebug>
 #include <QtCore/QPointF>
@@ -326,6 +328,33 @@ void GraphicsView::keyReleaseEvent(QKeyEvent *event)
 
 void GraphicsView::mousePressEvent(QMouseEvent *event)
 {
+    BasicGraphicsScene *scene = nodeScene();
+
+    if (scene && dragMode() == QGraphicsView::RubberBandDrag
+        && event->button() == Qt::LeftButton) {
+        QPointF const scenePos = mapToScene(event->pos());
+
+        // Qt's own rubber band asks the scene for all the items under the
+        // band on every mouse move, which is a linear scan without a BSP
+        // index. The band is drawn here and resolved through the scene
+        // spatial index instead.
+        if (!scene->nodeAt(scenePos) && !scene->connectionAt(scenePos)) {
+            setDragMode(QGraphicsView::NoDrag);
+
+            if (!_rubberBand)
+                _rubberBand = new QRubberBand(QRubberBand::Rectangle, viewport());
+
+            _rubberBandOrigin = event->pos();
+            _rubberBandOperation = (event->modifiers() & Qt::ControlModifier)
+                                       ? Qt::AddToSelection
+                                       : Qt::ReplaceSelection;
+            _rubberBanding = true;
+
+            _rubberBand->setGeometry(QRect(_rubberBandOrigin, QSize()));
+            _rubberBand->show();
+        }
+    }
+
     QGraphicsView::mousePressEvent(event);
     if (event->button() == Qt::LeftButton) {
         _clickPos = mapToScene(event->pos());
@@ -334,6 +363,18 @@ void GraphicsView::mousePressEvent(QMouseEvent *event)
 
 void GraphicsView::mouseMoveEvent(QMouseEvent *event)
 {
+    if (_rubberBanding) {
+        QRect const band = QRect(_rubberBandOrigin, event->pos()).normalized();
+
+        _rubberBand->setGeometry(band);
+
+        QPainterPath area;
+        area.addPolygon(mapToScene(band));
+        area.closeSubpath();
+
+        nodeScene()->selectItemsIn(area, _rubberBandOperation);
+    }
+
     QGraphicsView::mouseMoveEvent(event);
     if (scene()->mouseGrabberItem() == nullptr && event->buttons() == Qt::LeftButton) {
         // Make sure shift is not being pressed
@@ -344,6 +385,20 @@ void GraphicsView::mouseMoveEvent(QMouseEvent *event)
     }
 }
 
+void GraphicsView::mouseReleaseEvent(QMouseEvent *event)
+{
+    QGraphicsView::mouseReleaseEvent(event);
+
+    if (_rubberBanding && event->button() == Qt::LeftButton) {
+        _rubberBanding = false;
+        _rubberBand->hide();
+
+        // Shift may have switched the mode while the band was active.
+        if (dragMode() == QGraphicsView::NoDrag)
+            setDragMode(QGraphicsView::RubberBandDrag);
+    }
+}
+
 void GraphicsView::drawBackground(QPainter *painter, const QRectF &r)
 {
     QGraphicsView::drawBackground(painter, r);
@@ -417,7 +472,8 @@ QPointF GraphicsView::scenePastePosition()
     return mapToScene(origin);
 }
 
-void GraphicsView::paintScaleMsg(const QPainter &painter) 
+void GraphicsView::paintScaleMsg(QPainter const &painter)
 {
+    Q_UNUSED(painter);
 
 }
@@ -0,0 +1,159 @@
+#include "IconCache.hpp"
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtGui/QPainter>
+#include <QtGui/QPixmapCache>
+#include <QtSvg/QSvgRenderer>
+
+#include <iterator>
+
+namespace QtNodes {
+
+namespace {
+
+struct CacheState
+{
+    /// Every QPixmapCache key inserted so far, per icon path.
+    QHash<QString, QSet<QString>> keys;
+
+    /// Icons which could not be rendered.
+    QSet<QString> invalid;
+
+    /// Existence of the icon state variants.
+    QHash<QString, bool> exists;
+};
+
+CacheState &cacheState()
+{
+    static CacheState state;
+    return state;
+}
+
+QString cacheKey(QString const &path, qreal devicePixelRatio)
+{
+    return QStringLiteral("QtNodes/icon|%1|%2").arg(path).arg(devicePixelRatio);
+}
+
+QPixmap render(QString const &path, qreal devicePixelRatio)
+{
+    QSvgRenderer renderer(path);
+    if (!renderer.isValid())
+        return QPixmap();
+
+    // Rendered at twice the default size, the icons are drawn scaled up.
+    QSize const svgSize = renderer.defaultSize() * 2 * qMax(devicePixelRatio, qreal(1.0));
+
+    QPixmap pixmap(svgSize);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    renderer.render(&painter);
+
+    return pixmap;
+}
+
+} // namespace
+
+QPixmap IconCache::pixmap(QString const &path, qreal devicePixelRatio)
+{
+    CacheState &state = cacheState();
+
+    if (path.isEmpty() || state.invalid.contains(path))
+        return QPixmap();
+
+    QString const key = cacheKey(path, devicePixelRatio);
+
+    QPixmap result;
+    if (QPixmapCache::find(key, &result))
+        return result;
+
+    result = render(path, devicePixelRatio);
+
+    if (result.isNull()) {
+        state.invalid.insert(path);
+        return result;
+    }
+
+    QPixmapCache::insert(key, result);
+    state.keys[path].insert(key);
+
+    return result;
+}
+
+QString IconCache::statePath(QString const &path, QString const &state)
+{
+    int const extension = path.indexOf(".svg");
+
+    if (state.isEmpty() || extension <= 0)
+        return path;
+
+    QString variant = path;
+    variant.insert(extension, QLatin1Char('_') + state);
+
+    QHash<QString, bool> &exists = cacheState().exists;
+
+    auto it = exists.find(variant);
+    if (it == exists.end())
+        it = exists.insert(variant, QFileInfo::exists(variant));
+
+    return it.value() ? variant : path;
+}
+
+void IconCache::invalidate(QString const &path)
+{
+    CacheState &state = cacheState();
+
+    int const extension = path.indexOf(".svg");
+
+    // Variants are named `<stem>_<state><suffix>`, see statePath(). Other
+    // icons merely sharing a prefix with `path` are left alone.
+    QString const variantPrefix = path.left(extension) + QLatin1Char('_');
+    QString const suffix = path.mid(extension);
+
+    auto matches = [&](QString const &key) {
+        if (key == path)
+            return true;
+
+        return extension > 0 && key.size() > variantPrefix.size() + suffix.size()
+               && key.startsWith(variantPrefix) && key.endsWith(suffix);
+    };
+
+    for (auto it = state.keys.begin(); it != state.keys.end();) {
+        if (matches(it.key())) {
+            for (QString const &key : it.value()) {
+                QPixmapCache::remove(key);
+            }
+            it = state.keys.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = state.invalid.begin(); it != state.invalid.end();) {
+        it = matches(*it) ? state.invalid.erase(it) : std::next(it);
+    }
+
+    for (auto it = state.exists.begin(); it != state.exists.end();) {
+        it = matches(it.key()) ? state.exists.erase(it) : std::next(it);
+    }
+}
+
+void IconCache::clear()
+{
+    CacheState &state = cacheState();
+
+    for (QSet<QString> const &keys : state.keys) {
+        for (QString const &key : keys) {
+            QPixmapCache::remove(key);
+        }
+    }
+
+    state.keys.clear();
+    state.invalid.clear();
+    state.exists.clear();
+}
+
+} // namespace QtNodes
@@ -0,0 +1,86 @@
+#include "NodeData.hpp"
+
+#include <QtCore/QHash>
+#include <QtCore/QReadWriteLock>
+
+#include <atomic>
+#include <vector>
+
+namespace QtNodes {
+
+namespace {
+
+struct TypeTable
+{
+    QReadWriteLock lock;
+
+    QHash<QString, NodeDataTypeHandle> handles;
+
+    std::vector<QString> ids;
+};
+
+TypeTable &typeTable()
+{
+    static TypeTable table;
+    return table;
+}
+
+} // namespace
+
+NodeDataTypeHandle NodeDataTypeRegistry::intern(QString const &typeId)
+{
+    TypeTable &table = typeTable();
+
+    {
+        QReadLocker locker(&table.lock);
+
+        auto it = table.handles.constFind(typeId);
+        if (it != table.handles.constEnd())
+            return it.value();
+    }
+
+    QWriteLocker locker(&table.lock);
+
+    // Another thread may have interned the id in the meantime.
+    auto it = table.handles.constFind(typeId);
+    if (it != table.handles.constEnd())
+        return it.value();
+
+    NodeDataTypeHandle const handle = static_cast<NodeDataTypeHandle>(table.ids.size());
+
+    table.ids.push_back(typeId);
+    table.handles.insert(typeId, handle);
+
+    return handle;
+}
+
+QString NodeDataTypeRegistry::typeId(NodeDataTypeHandle handle)
+{
+    TypeTable &table = typeTable();
+
+    QReadLocker locker(&table.lock);
+
+    if (handle < 0 || static_cast<std::size_t>(handle) >= table.ids.size())
+        return QString();
+
+    return table.ids[handle];
+}
+
+std::size_t NodeDataTypeRegistry::size()
+{
+    TypeTable &table = typeTable();
+
+    QReadLocker locker(&table.lock);
+
+    return table.ids.size();
+}
+
+std::uint64_t NodeData::nextVersion()
+{
+    // Zero is never handed out, it stands for "no data".
+    static std::atomic<std::uint64_t> lastVersion{0};
+
+    return lastVersion.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+} // namespace QtNodes
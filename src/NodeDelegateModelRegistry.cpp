@@ -3,9 +3,166 @@
 #include <QtCore/QFile>
 #include <QtWidgets/QMessageBox>
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
 using QtNodes::NodeDataType;
+using QtNodes::NodeDataTypeHandle;
+using QtNodes::NodeDataTypeRegistry;
 using QtNodes::NodeDelegateModel;
 using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::SharedNodeData;
+using QtNodes::TypeConverter;
+using QtNodes::TypeConverterId;
+
+namespace {
+
+std::uint64_t converterKey(TypeConverterId const &id)
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(id.first)) << 32)
+           | static_cast<std::uint32_t>(id.second);
+}
+
+NodeDataTypeHandle handleOf(NodeDataType const &type)
+{
+    NodeDataTypeHandle const handle = type.handle();
+
+    if (handle != QtNodes::InvalidNodeDataTypeHandle)
+        return handle;
+
+    return NodeDataTypeRegistry::intern(type.id);
+}
+
+} // namespace
+
+struct NodeDelegateModelRegistry::TypeConverters
+{
+    std::mutex mutex;
+
+    std::atomic<bool> empty{true};
+
+    /// Registered converters, per source type.
+    std::unordered_map<NodeDataTypeHandle, std::unordered_map<NodeDataTypeHandle, TypeConverter>>
+        edges;
+
+    /// Resolved conversions keyed by `converterKey()`, empty when impossible.
+    std::unordered_map<std::uint64_t, TypeConverter> resolved;
+
+    TypeConverter resolve(TypeConverterId const &id) const;
+};
+
+/// Breadth-first search for the shortest chain of converters.
+TypeConverter NodeDelegateModelRegistry::TypeConverters::resolve(TypeConverterId const &id) const
+{
+    std::unordered_map<NodeDataTypeHandle, NodeDataTypeHandle> previous;
+    std::deque<NodeDataTypeHandle> queue;
+
+    previous.emplace(id.first, id.first);
+    queue.push_back(id.first);
+
+    while (!queue.empty() && !previous.count(id.second)) {
+        NodeDataTypeHandle const type = queue.front();
+        queue.pop_front();
+
+        auto it = edges.find(type);
+        if (it == edges.end())
+            continue;
+
+        for (auto const &edge : it->second) {
+            if (previous.emplace(edge.first, type).second)
+                queue.push_back(edge.first);
+        }
+    }
+
+    if (!previous.count(id.second))
+        return TypeConverter();
+
+    std::vector<TypeConverter> chain;
+
+    for (NodeDataTypeHandle type = id.second; type != id.first; type = previous[type]) {
+        chain.push_back(edges.at(previous[type]).at(type));
+    }
+
+    if (chain.size() == 1)
+        return chain.front();
+
+    std::reverse(chain.begin(), chain.end());
+
+    return [chain](SharedNodeData data) {
+        for (TypeConverter const &converter : chain) {
+            if (!data)
+                break;
+
+            data = converter(std::move(data));
+        }
+        return data;
+    };
+}
+
+NodeDelegateModelRegistry::NodeDelegateModelRegistry()
+    : _typeConverters(std::make_unique<TypeConverters>())
+{}
+
+NodeDelegateModelRegistry::~NodeDelegateModelRegistry() = default;
+
+NodeDelegateModelRegistry::NodeDelegateModelRegistry(NodeDelegateModelRegistry &&) = default;
+
+NodeDelegateModelRegistry &NodeDelegateModelRegistry::operator=(NodeDelegateModelRegistry &&)
+    = default;
+
+void NodeDelegateModelRegistry::registerTypeConverter(NodeDataType const &from,
+                                                      NodeDataType const &to,
+                                                      TypeConverter typeConverter)
+{
+    registerTypeConverter(TypeConverterId(handleOf(from), handleOf(to)), std::move(typeConverter));
+}
+
+void NodeDelegateModelRegistry::registerTypeConverter(TypeConverterId const &id,
+                                                      TypeConverter typeConverter)
+{
+    // A moved-from registry can be reused.
+    if (!_typeConverters)
+        _typeConverters = std::make_unique<TypeConverters>();
+
+    std::lock_guard<std::mutex> lock(_typeConverters->mutex);
+
+    _typeConverters->edges[id.first][id.second] = std::move(typeConverter);
+    _typeConverters->empty = false;
+
+    // Any cached chain may be shortened or made possible by the new edge.
+    _typeConverters->resolved.clear();
+}
+
+TypeConverter NodeDelegateModelRegistry::getTypeConverter(NodeDataType const &from,
+                                                          NodeDataType const &to) const
+{
+    return getTypeConverter(TypeConverterId(handleOf(from), handleOf(to)));
+}
+
+TypeConverter NodeDelegateModelRegistry::getTypeConverter(TypeConverterId const &id) const
+{
+    if (!hasTypeConverters() || id.first == id.second)
+        return TypeConverter();
+
+    std::lock_guard<std::mutex> lock(_typeConverters->mutex);
+
+    std::uint64_t const key = converterKey(id);
+
+    auto it = _typeConverters->resolved.find(key);
+
+    if (it == _typeConverters->resolved.end())
+        it = _typeConverters->resolved.emplace(key, _typeConverters->resolve(id)).first;
+
+    return it->second;
+}
+
+bool NodeDelegateModelRegistry::hasTypeConverters() const
+{
+    return _typeConverters && !_typeConverters->empty;
+}
 
 std::unique_ptr<NodeDelegateModel> NodeDelegateModelRegistry::create(QString const &modelName)
 {
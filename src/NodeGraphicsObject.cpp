@@ -14,7 +14,6 @@
 #include "ConnectionIdUtils.hpp"
 #include "NodeConnectionInteraction.hpp"
 #include "StyleCollection.hpp"
-#include "UndoCommands.hpp"
 #include "DefaultFlowControlNodePainter.hpp"
 
 namespace QtNodes {
@@ -34,9 +33,8 @@ NodeGraphicsObject::NodeGraphicsObject(BasicGraphicsScene &scene, NodeId nodeId)
 
     setCacheMode(QGraphicsItem::DeviceCoordinateCache);
 
-    QJsonObject nodeStyleJson = _graphModel.nodeData(_nodeId, NodeRole::Style).toJsonObject();
-
-    NodeStyle nodeStyle(nodeStyleJson);
+    std::shared_ptr<NodeStyle const> style = _graphModel.nodeStyle(_nodeId);
+    NodeStyle const &nodeStyle = *style;
 
     {
         auto effect = new QGraphicsDropShadowEffect;
@@ -134,14 +132,14 @@ void NodeGraphicsObject::setGeometryChanged()
 
 void NodeGraphicsObject::moveConnections() const
 {
-    auto const &connected = _graphModel.allConnectionIds(_nodeId);
+    BasicGraphicsScene *scene = nodeScene();
 
-    for (auto &cnId : connected) {
-        auto cgo = nodeScene()->connectionGraphicsObject(cnId);
+    _graphModel.forEachNodeConnection(_nodeId, [scene](ConnectionId const &cnId) {
+        auto cgo = scene->connectionGraphicsObject(cnId);
 
         if (cgo)
             cgo->move();
-    }
+    });
 }
 
 void NodeGraphicsObject::reactToConnection(ConnectionGraphicsObject const *cgo)
@@ -281,6 +279,8 @@ void NodeGraphicsObject::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
             // Passes the new size to the model.
             geometry.recomputeSize(_nodeId);
 
+            nodeScene()->updateNodeIndex(_nodeId);
+
             update();
 
             moveConnections();
@@ -290,7 +290,7 @@ void NodeGraphicsObject::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
     } else {
         auto diff = event->pos() - event->lastPos();
 
-        nodeScene()->undoStack().push(new MoveNodeCommand(nodeScene(), diff));
+        nodeScene()->dragSelectedNodes(diff);
 
         event->accept();
     }
@@ -313,6 +313,8 @@ void NodeGraphicsObject::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
 {
     _nodeState.setResizing(false);
 
+    nodeScene()->finishNodeDrag();
+
     QGraphicsObject::mouseReleaseEvent(event);
 
     QPoint point = event->pos().toPoint(); 
@@ -339,11 +341,9 @@ void NodeGraphicsObject::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
 void NodeGraphicsObject::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
 {
     // bring all the colliding nodes to background
-    QList<QGraphicsItem *> overlapItems = collidingItems();
-
-    for (QGraphicsItem *item : overlapItems) {
-        if (item->zValue() > 0.0) {
-            item->setZValue(0.0);
+    for (NodeGraphicsObject *ngo : nodeScene()->nodesIn(sceneBoundingRect())) {
+        if (ngo->zValue() > 0.0) {
+            ngo->setZValue(0.0);
         }
     }
 
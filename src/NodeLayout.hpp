@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QtCore/QPointF>
+#include <QtCore/QRectF>
+#include <QtCore/QSize>
+#include <QtCore/QtGlobal>
+
+#include <vector>
+
+#include "Definitions.hpp"
+
+namespace QtNodes {
+
+/// Node measurements kept by the default node geometries between two updates.
+/**
+ * Computing the port positions requires the caption and every port label to
+ * be measured with QFontMetrics. The geometries do it once per node and keep
+ * the result until `AbstractNodeGeometry::invalidate()` is called for it.
+ */
+struct NodeLayout
+{
+    /// `StyleCollection::nodeStyleVersion()` at the time of the computation.
+    quint64 styleVersion = 0;
+
+    QSize size;
+
+    QRectF captionRect;
+    QPointF captionPosition;
+
+    QPointF widgetPosition;
+
+    unsigned int inPortsTextAdvance = 0;
+    unsigned int outPortsTextAdvance = 0;
+
+    std::vector<QPointF> inPortPositions;
+    std::vector<QPointF> outPortPositions;
+
+    std::vector<QRectF> inPortTextRects;
+    std::vector<QRectF> outPortTextRects;
+
+    std::vector<QPointF> const &portPositions(PortType portType) const
+    {
+        return (portType == PortType::In) ? inPortPositions : outPortPositions;
+    }
+
+    std::vector<QRectF> const &portTextRects(PortType portType) const
+    {
+        return (portType == PortType::In) ? inPortTextRects : outPortTextRects;
+    }
+
+    unsigned int portsTextAdvance(PortType portType) const
+    {
+        return (portType == PortType::In) ? inPortsTextAdvance : outPortsTextAdvance;
+    }
+};
+
+} // namespace QtNodes
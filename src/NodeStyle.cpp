@@ -83,6 +83,13 @@ void NodeStyle::setNodeStyle(QString jsonText)
         variable = valueRef.toDouble(); \
     }
 
+#define NODE_STYLE_READ_OPTIONAL_FLOAT(values, variable) \
+    { \
+        auto valueRef = values[#variable]; \
+        if (valueRef.isDouble()) \
+            variable = valueRef.toDouble(); \
+    }
+
 #define NODE_STYLE_WRITE_FLOAT(values, variable) \
     { \
         values[#variable] = variable; \
@@ -114,6 +121,10 @@ void NodeStyle::loadJson(QJsonObject const &json)
 
     NODE_STYLE_READ_FLOAT(obj, Opacity);
 
+    // Style files written before level of detail rendering keep the defaults.
+    NODE_STYLE_READ_OPTIONAL_FLOAT(obj, TextLevelOfDetail);
+    NODE_STYLE_READ_OPTIONAL_FLOAT(obj, SimplifiedLevelOfDetail);
+
     NODE_STYLE_READ_COLOR(obj, HoverBoundaryColor);
     NODE_STYLE_READ_COLOR(obj, OperationBoundaryColor);
     NODE_STYLE_READ_COLOR(obj, NormalCaptionRectColor);
@@ -146,6 +157,9 @@ QJsonObject NodeStyle::toJson() const
 
     NODE_STYLE_WRITE_FLOAT(obj, Opacity);
 
+    NODE_STYLE_WRITE_FLOAT(obj, TextLevelOfDetail);
+    NODE_STYLE_WRITE_FLOAT(obj, SimplifiedLevelOfDetail);
+
     NODE_STYLE_WRITE_COLOR(obj, HoverBoundaryColor);
     NODE_STYLE_WRITE_COLOR(obj, OperationBoundaryColor);
     NODE_STYLE_WRITE_COLOR(obj, NormalCaptionRectColor);
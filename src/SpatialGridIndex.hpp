@@ -0,0 +1,184 @@
+#pragma once
+
+#include <QtCore/QPointF>
+#include <QtCore/QRect>
+#include <QtCore/QRectF>
+#include <QtCore/QtGlobal>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace QtNodes {
+
+/// Uniform grid of buckets mapping scene rectangles to keys.
+/**
+ * Every key is stored in all the cells its rectangle overlaps. Moving a key
+ * within the same cells only replaces the stored rectangle, so dragging
+ * large selections by a few pixels at a time costs one hash lookup per
+ * item. Queries visit only the cells covering the query area.
+ *
+ * The index is meant for items much smaller than the scene, like nodes and
+ * connections. A cell size close to the typical item size keeps the buckets
+ * short; a long connection is simply stored in every cell it crosses.
+ */
+template<typename Key>
+class SpatialGridIndex
+{
+public:
+    explicit SpatialGridIndex(qreal cellSize = 256.0)
+        : _cellSize(cellSize)
+    {}
+
+    std::size_t size() const { return _entries.size(); }
+
+    /// Inserts `key` or moves it to `rect` when it is already indexed.
+    void insert(Key const &key, QRectF const &rect)
+    {
+        QRect const cells = cellRange(rect);
+
+        auto it = _entries.find(key);
+
+        if (it != _entries.end()) {
+            Entry &entry = it->second;
+
+            entry.rect = rect;
+
+            if (entry.cells == cells)
+                return;
+
+            forEachCell(entry.cells, [&](quint64 cell) { eraseFromBucket(cell, key); });
+
+            entry.cells = cells;
+        } else {
+            _entries.emplace(key, Entry{rect, cells});
+        }
+
+        forEachCell(cells, [&](quint64 cell) { _buckets[cell].push_back(key); });
+    }
+
+    void remove(Key const &key)
+    {
+        auto it = _entries.find(key);
+
+        if (it == _entries.end())
+            return;
+
+        forEachCell(it->second.cells, [&](quint64 cell) { eraseFromBucket(cell, key); });
+
+        _entries.erase(it);
+    }
+
+    void clear()
+    {
+        _entries.clear();
+        _buckets.clear();
+    }
+
+    /// Calls `f(key, rect)` for every key whose rectangle contains `point`.
+    template<typename F>
+    void forEachAt(QPointF const &point, F f) const
+    {
+        auto bucket = _buckets.find(cellKey(cellCoordinate(point.x()), cellCoordinate(point.y())));
+
+        if (bucket == _buckets.end())
+            return;
+
+        for (Key const &key : bucket->second) {
+            QRectF const &rect = _entries.at(key).rect;
+
+            if (rect.contains(point))
+                f(key, rect);
+        }
+    }
+
+    /// Calls `f(key, rect)` once for every key whose rectangle intersects `area`.
+    template<typename F>
+    void forEachIn(QRectF const &area, F f) const
+    {
+        QRect const range = cellRange(area);
+
+        for (int y = range.top(); y <= range.bottom(); ++y) {
+            for (int x = range.left(); x <= range.right(); ++x) {
+                auto bucket = _buckets.find(cellKey(x, y));
+
+                if (bucket == _buckets.end())
+                    continue;
+
+                for (Key const &key : bucket->second) {
+                    Entry const &entry = _entries.at(key);
+
+                    // A key spanning several cells is only reported from the
+                    // first cell shared with the query range.
+                    if (x != std::max(entry.cells.left(), range.left())
+                        || y != std::max(entry.cells.top(), range.top()))
+                        continue;
+
+                    if (entry.rect.intersects(area))
+                        f(key, entry.rect);
+                }
+            }
+        }
+    }
+
+private:
+    struct Entry
+    {
+        QRectF rect;
+        QRect cells;
+    };
+
+    int cellCoordinate(qreal v) const { return static_cast<int>(std::floor(v / _cellSize)); }
+
+    QRect cellRange(QRectF const &rect) const
+    {
+        return QRect(QPoint(cellCoordinate(rect.left()), cellCoordinate(rect.top())),
+                     QPoint(cellCoordinate(rect.right()), cellCoordinate(rect.bottom())));
+    }
+
+    static quint64 cellKey(int x, int y)
+    {
+        return (static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint32>(y);
+    }
+
+    template<typename F>
+    static void forEachCell(QRect const &cells, F f)
+    {
+        for (int y = cells.top(); y <= cells.bottom(); ++y) {
+            for (int x = cells.left(); x <= cells.right(); ++x) {
+                f(cellKey(x, y));
+            }
+        }
+    }
+
+    void eraseFromBucket(quint64 cell, Key const &key)
+    {
+        auto bucket = _buckets.find(cell);
+
+        if (bucket == _buckets.end())
+            return;
+
+        std::vector<Key> &keys = bucket->second;
+
+        auto it = std::find(keys.begin(), keys.end(), key);
+
+        if (it != keys.end()) {
+            *it = keys.back();
+            keys.pop_back();
+        }
+
+        if (keys.empty())
+            _buckets.erase(bucket);
+    }
+
+private:
+    qreal _cellSize;
+
+    std::unordered_map<Key, Entry> _entries;
+
+    std::unordered_map<quint64, std::vector<Key>> _buckets;
+};
+
+} // namespace QtNodes
@@ -1,15 +1,32 @@
 #include "StyleCollection.hpp"
 
+#include <utility>
+
 using QtNodes::ConnectionStyle;
 using QtNodes::GraphicsViewStyle;
 using QtNodes::NodeStyle;
 using QtNodes::StyleCollection;
 
+StyleCollection::StyleCollection()
+    : _nodeStyle(std::make_shared<NodeStyle const>())
+    , _nodeStyleVersion(0)
+{}
+
 NodeStyle const &StyleCollection::nodeStyle()
+{
+    return *instance()._nodeStyle;
+}
+
+std::shared_ptr<NodeStyle const> StyleCollection::sharedNodeStyle()
 {
     return instance()._nodeStyle;
 }
 
+quint64 StyleCollection::nodeStyleVersion()
+{
+    return instance()._nodeStyleVersion;
+}
+
 ConnectionStyle const &StyleCollection::connectionStyle()
 {
     return instance()._connectionStyle;
@@ -22,7 +39,9 @@ GraphicsViewStyle const &StyleCollection::flowViewStyle()
 
 void StyleCollection::setNodeStyle(NodeStyle nodeStyle)
 {
-    instance()._nodeStyle = nodeStyle;
+    // Painters may still hold the previous instance, it is never modified.
+    instance()._nodeStyle = std::make_shared<NodeStyle const>(std::move(nodeStyle));
+    ++instance()._nodeStyleVersion;
 }
 
 void StyleCollection::setConnectionStyle(ConnectionStyle connectionStyle)
@@ -6,6 +6,7 @@
 #include "Definitions.hpp"
 #include "NodeGraphicsObject.hpp"
 
+#include <QtCore/QDebug>
 #include <QtCore/QJsonArray>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QMimeData>
@@ -13,7 +14,10 @@
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QGraphicsObject>
 
+#include <algorithm>
 #include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace QtNodes {
 
@@ -53,70 +57,162 @@ static QJsonObject serializeSelectedItems(BasicGraphicsScene *scene)
     return serializedScene;
 }
 
-static void insertSerializedItems(QJsonObject const &json, BasicGraphicsScene *scene)
+/// Splits a node saved by `AbstractGraphModel::saveNode()` into plain fields
+/// and a shared payload.
+static GraphDelta::Node recordNode(UndoPayloadStore &store, QJsonObject nodeJson)
 {
-    AbstractGraphModel &graphModel = scene->graphModel();
+    GraphDelta::Node node;
+
+    node.id = nodeJson.take("id").toInt();
 
-    QJsonArray const &nodesJsonArray = json["nodes"].toArray();
+    QJsonObject const posJson = nodeJson.take("position").toObject();
+    node.position = QPointF(posJson["x"].toDouble(), posJson["y"].toDouble());
 
-    for (QJsonValue node : nodesJsonArray) {
-        QJsonObject obj = node.toObject();
+    node.type = UndoPayloadStore::InvalidTypeHandle;
 
-        graphModel.loadNode(obj);
+    QJsonObject internalData = nodeJson["internal-data"].toObject();
 
-        auto id = obj["id"].toInt();
-        scene->nodeGraphicsObject(id)->setZValue(1.0);
-        scene->nodeGraphicsObject(id)->setSelected(true);
+    if (internalData.contains("model-name")) {
+        node.type = store.typeHandle(internalData.take("model-name").toString());
+        nodeJson["internal-data"] = internalData;
     }
 
-    QJsonArray const &connJsonArray = json["connections"].toArray();
+    // Most nodes have nothing to save besides their model name.
+    bool const bare = nodeJson.isEmpty()
+                      || (nodeJson.size() == 1 && nodeJson.contains("internal-data")
+                          && internalData.isEmpty());
+
+    if (!bare)
+        node.payload = store.intern(UndoPayloadStore::encode(nodeJson));
+
+    return node;
+}
+
+/// Payloads already decoded while restoring a delta, by stored entry.
+using DecodedPayloads = std::unordered_map<UndoPayloadStore::Entry const *, QJsonObject>;
 
-    for (QJsonValue connection : connJsonArray) {
-        QJsonObject connJson = connection.toObject();
+/// Rebuilds the JSON expected by `AbstractGraphModel::loadNode()`.
+/// @returns `false` when the saved state of `node` can no longer be read.
+static bool restoreNodeJson(UndoPayloadStore const &store,
+                            GraphDelta::Node const &node,
+                            DecodedPayloads &decoded,
+                            QJsonObject &nodeJson)
+{
+    if (node.payload) {
+        auto it = decoded.find(node.payload.get());
 
-        ConnectionId connId = fromJson(connJson);
+        if (it == decoded.end()) {
+            QByteArray bytes;
+            QJsonObject payloadJson;
 
-        // Restore the connection
-        graphModel.addConnection(connId);
+            if (!store.bytes(node.payload, bytes)
+                || !UndoPayloadStore::decode(bytes, payloadJson))
+                return false;
 
-        scene->connectionGraphicsObject(connId)->setSelected(true);
+            it = decoded.emplace(node.payload.get(), std::move(payloadJson)).first;
+        }
+
+        // Implicitly shared, only the top level is copied by the edits below.
+        nodeJson = it->second;
     }
+
+    if (node.type != UndoPayloadStore::InvalidTypeHandle) {
+        QJsonObject internalData = nodeJson["internal-data"].toObject();
+        internalData["model-name"] = store.typeName(node.type);
+        nodeJson["internal-data"] = internalData;
+    }
+
+    nodeJson["id"] = static_cast<qint64>(node.id);
+
+    QJsonObject posJson;
+    posJson["x"] = node.position.x();
+    posJson["y"] = node.position.y();
+    nodeJson["position"] = posJson;
+
+    return true;
 }
 
-static void deleteSerializedItems(QJsonObject &sceneJson, AbstractGraphModel &graphModel)
+static void insertSerializedItems(GraphDelta const &delta, BasicGraphicsScene *scene)
 {
-    QJsonArray connectionJsonArray = sceneJson["connections"].toArray();
+    AbstractGraphModel &graphModel = scene->graphModel();
+    UndoPayloadStore const &store = *scene->undoPayloadStore();
+
+    // The graphics objects only exist once the batch is committed.
+    auto selectInsertedItems = [&]() {
+        for (GraphDelta::Node const &node : delta.nodes) {
+            if (NodeGraphicsObject *ngo = scene->nodeGraphicsObject(node.id)) {
+                ngo->setZValue(1.0);
+                ngo->setSelected(true);
+            }
+        }
 
-    for (QJsonValueRef connection : connectionJsonArray) {
-        QJsonObject connJson = connection.toObject();
+        for (ConnectionId const &connId : delta.connections) {
+            if (ConnectionGraphicsObject *cgo = scene->connectionGraphicsObject(connId))
+                cgo->setSelected(true);
+        }
+    };
 
-        ConnectionId connId = fromJson(connJson);
+    try {
+        AbstractGraphModel::BatchGuard batch(graphModel);
 
-        graphModel.deleteConnection(connId);
-    }
+        // A node restored from an unreadable payload would come back as a
+        // default one, so it is left out together with its connections.
+        std::unordered_set<NodeId> lostNodes;
+
+        // Equal nodes share one payload, which is read and decoded once.
+        DecodedPayloads decoded;
 
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
+        for (GraphDelta::Node const &node : delta.nodes) {
+            QJsonObject nodeJson;
+
+            if (!restoreNodeJson(store, node, decoded, nodeJson)) {
+                qWarning() << "Undo: the saved state of node" << node.id
+                           << "cannot be read, the node is not restored";
+                lostNodes.insert(node.id);
+                continue;
+            }
 
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject nodeJson = node.toObject();
-        graphModel.deleteNode(nodeJson["id"].toInt());
+            graphModel.loadNode(nodeJson);
+        }
+
+        for (ConnectionId const &connId : delta.connections) {
+            if (lostNodes.count(connId.outNodeId) || lostNodes.count(connId.inNodeId))
+                continue;
+
+            // Restore the connection
+            graphModel.addConnection(connId);
+        }
+    } catch (...) {
+        // Callers clean up a failed insertion through the selection.
+        selectInsertedItems();
+        throw;
     }
+
+    selectInsertedItems();
 }
 
-static QPointF computeAverageNodePosition(QJsonObject const &sceneJson)
+static void deleteSerializedItems(GraphDelta const &delta, AbstractGraphModel &graphModel)
 {
-    QPointF averagePos(0, 0);
+    AbstractGraphModel::BatchGuard batch(graphModel);
 
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
+    for (ConnectionId const &connId : delta.connections) {
+        graphModel.deleteConnection(connId);
+    }
 
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject nodeJson = node.toObject();
+    for (GraphDelta::Node const &node : delta.nodes) {
+        graphModel.deleteNode(node.id);
+    }
+}
 
-        averagePos += QPointF(nodeJson["position"].toObject()["x"].toDouble(),
-                              nodeJson["position"].toObject()["y"].toDouble());
+static QPointF computeAverageNodePosition(GraphDelta const &delta)
+{
+    QPointF averagePos(0, 0);
+
+    for (GraphDelta::Node const &node : delta.nodes) {
+        averagePos += node.position;
     }
 
-    averagePos /= static_cast<double>(nodesJsonArray.size());
+    averagePos /= static_cast<double>(delta.nodes.size());
 
     return averagePos;
 }
@@ -127,7 +223,6 @@ CreateCommand::CreateCommand(BasicGraphicsScene *scene,
                              QString const name,
                              QPointF const &mouseScenePos)
     : _scene(scene)
-    , _sceneJson(QJsonObject())
 {
     _nodeId = _scene->graphModel().addNode(name);
     if (_nodeId != InvalidNodeId) {
@@ -139,19 +234,40 @@ CreateCommand::CreateCommand(BasicGraphicsScene *scene,
 
 void CreateCommand::undo()
 {
-    QJsonArray nodesJsonArray;
-    nodesJsonArray.append(_scene->graphModel().saveNode(_nodeId));
-    _sceneJson["nodes"] = nodesJsonArray;
+    if (isSuspended())
+        return;
+
+    _delta = GraphDelta();
+    _delta.nodes.push_back(
+        recordNode(*_scene->undoPayloadStore(), _scene->graphModel().saveNode(_nodeId)));
 
     _scene->graphModel().deleteNode(_nodeId);
 }
 
 void CreateCommand::redo()
 {
-    if (_sceneJson.empty() || _sceneJson["nodes"].toArray().empty())
+    if (isSuspended() || _delta.nodes.empty())
         return;
 
-    insertSerializedItems(_sceneJson, _scene);
+    insertSerializedItems(_delta, _scene);
+}
+
+CreateCommand::CreateCommand(BasicGraphicsScene *scene, NodeId nodeId, GraphDelta delta)
+    : _scene(scene)
+    , _nodeId(nodeId)
+    , _delta(std::move(delta))
+{
+    //
+}
+
+std::size_t CreateCommand::memoryUsage() const
+{
+    return sizeof(*this) + _delta.memoryUsage();
+}
+
+SceneUndoCommand *CreateCommand::takeState()
+{
+    return new CreateCommand(_scene, _nodeId, std::move(_delta));
 }
 
 //-------------------------------------
@@ -160,75 +276,83 @@ DeleteCommand::DeleteCommand(BasicGraphicsScene *scene)
     : _scene(scene)
 {
     auto &graphModel = _scene->graphModel();
+    UndoPayloadStore &store = *_scene->undoPayloadStore();
+
+    QList<QGraphicsItem *> const selectedItems = _scene->selectedItems();
+
+    // A connection between two deleted nodes is reached from both of them.
+    std::unordered_set<ConnectionId> recorded;
+
+    auto recordConnection = [&](ConnectionId const &cid) {
+        if (recorded.insert(cid).second)
+            _delta.connections.push_back(cid);
+    };
 
-    QJsonArray connJsonArray;
     // Delete the selected connections first, ensuring that they won't be
     // automatically deleted when selected nodes are deleted (deleting a
     // node deletes some connections as well)
-    for (QGraphicsItem *item : _scene->selectedItems()) {
+    for (QGraphicsItem *item : selectedItems) {
         if (auto c = qgraphicsitem_cast<ConnectionGraphicsObject *>(item)) {
-            auto const &cid = c->connectionId();
-
-            connJsonArray.append(toJson(cid));
+            recordConnection(c->connectionId());
         }
     }
 
-    QJsonArray nodesJsonArray;
     // Delete the nodes; this will delete many of the connections.
     // Selected connections were already deleted prior to this loop,
-    for (QGraphicsItem *item : _scene->selectedItems()) {
+    for (QGraphicsItem *item : selectedItems) {
         if (auto n = qgraphicsitem_cast<NodeGraphicsObject *>(item)) {
             // saving connections attached to the selected nodes
-            for (auto const &cid : graphModel.allConnectionIds(n->nodeId())) {
-                connJsonArray.append(toJson(cid));
-            }
+            graphModel.forEachNodeConnection(n->nodeId(), recordConnection);
 
-            nodesJsonArray.append(graphModel.saveNode(n->nodeId()));
+            _delta.nodes.push_back(recordNode(store, graphModel.saveNode(n->nodeId())));
         }
     }
 
     // If nothing is deleted, cancel this operation
-    if (connJsonArray.isEmpty() && nodesJsonArray.isEmpty())
+    if (_delta.empty())
         setObsolete(true);
-
-    _sceneJson["nodes"] = nodesJsonArray;
-    _sceneJson["connections"] = connJsonArray;
 }
 
 void DeleteCommand::undo()
 {
-    insertSerializedItems(_sceneJson, _scene);
+    if (isSuspended())
+        return;
+
+    insertSerializedItems(_delta, _scene);
 }
 
 void DeleteCommand::redo()
 {
-    deleteSerializedItems(_sceneJson, _scene->graphModel());
-}
+    if (isSuspended())
+        return;
 
-//-------------------------------------
+    deleteSerializedItems(_delta, _scene->graphModel());
+}
 
-void offsetNodeGroup(QJsonObject &sceneJson, QPointF const &diff)
+DeleteCommand::DeleteCommand(BasicGraphicsScene *scene, GraphDelta delta)
+    : _scene(scene)
+    , _delta(std::move(delta))
 {
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
-
-    QJsonArray newNodesJsonArray;
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject obj = node.toObject();
+    //
+}
 
-        QPointF oldPos(obj["position"].toObject()["x"].toDouble(),
-                       obj["position"].toObject()["y"].toDouble());
+std::size_t DeleteCommand::memoryUsage() const
+{
+    return sizeof(*this) + _delta.memoryUsage();
+}
 
-        oldPos += diff;
+SceneUndoCommand *DeleteCommand::takeState()
+{
+    return new DeleteCommand(_scene, std::move(_delta));
+}
 
-        QJsonObject posJson;
-        posJson["x"] = oldPos.x();
-        posJson["y"] = oldPos.y();
-        obj["position"] = posJson;
+//-------------------------------------
 
-        newNodesJsonArray.append(obj);
+static void offsetNodeGroup(GraphDelta &delta, QPointF const &diff)
+{
+    for (GraphDelta::Node &node : delta.nodes) {
+        node.position += diff;
     }
-
-    sceneJson["nodes"] = newNodesJsonArray;
 }
 
 //-------------------------------------
@@ -264,32 +388,50 @@ PasteCommand::PasteCommand(BasicGraphicsScene *scene, QPointF const &mouseSceneP
     : _scene(scene)
     , _mouseScenePos(mouseScenePos)
 {
-    _newSceneJson = takeSceneJsonFromClipboard();
+    QJsonObject const sceneJson = takeSceneJsonFromClipboard();
+
+    QJsonArray const nodesJsonArray = sceneJson["nodes"].toArray();
 
-    if (_newSceneJson.empty() || _newSceneJson["nodes"].toArray().empty()) {
+    if (nodesJsonArray.isEmpty()) {
         setObsolete(true);
         return;
     }
 
-    _newSceneJson = makeNewNodeIdsInScene(_newSceneJson);
+    UndoPayloadStore &store = *_scene->undoPayloadStore();
 
-    QPointF averagePos = computeAverageNodePosition(_newSceneJson);
+    for (QJsonValue const node : nodesJsonArray) {
+        _delta.nodes.push_back(recordNode(store, node.toObject()));
+    }
+
+    for (QJsonValue const connection : sceneJson["connections"].toArray()) {
+        _delta.connections.push_back(fromJson(connection.toObject()));
+    }
+
+    makeNewNodeIdsInScene();
+
+    QPointF averagePos = computeAverageNodePosition(_delta);
 
-    offsetNodeGroup(_newSceneJson, _mouseScenePos - averagePos);
+    offsetNodeGroup(_delta, _mouseScenePos - averagePos);
 }
 
 void PasteCommand::undo()
 {
-    deleteSerializedItems(_newSceneJson, _scene->graphModel());
+    if (isSuspended())
+        return;
+
+    deleteSerializedItems(_delta, _scene->graphModel());
 }
 
 void PasteCommand::redo()
 {
+    if (isSuspended())
+        return;
+
     _scene->clearSelection();
 
     // Ignore if pasted in content does not generate nodes.
     try {
-        insertSerializedItems(_newSceneJson, _scene);
+        insertSerializedItems(_delta, _scene);
     } catch (...) {
         // If the paste does not work, delete all selected nodes and connections
         // `deleteNode(...)` implicitly removed connections
@@ -306,6 +448,26 @@ void PasteCommand::redo()
     }
 }
 
+PasteCommand::PasteCommand(BasicGraphicsScene *scene,
+                           QPointF const &mouseScenePos,
+                           GraphDelta delta)
+    : _scene(scene)
+    , _mouseScenePos(mouseScenePos)
+    , _delta(std::move(delta))
+{
+    //
+}
+
+std::size_t PasteCommand::memoryUsage() const
+{
+    return sizeof(*this) + _delta.memoryUsage();
+}
+
+SceneUndoCommand *PasteCommand::takeState()
+{
+    return new PasteCommand(_scene, _mouseScenePos, std::move(_delta));
+}
+
 QJsonObject PasteCommand::takeSceneJsonFromClipboard()
 {
     QClipboard const *clipboard = QApplication::clipboard();
@@ -321,52 +483,26 @@ QJsonObject PasteCommand::takeSceneJsonFromClipboard()
     return json.object();
 }
 
-QJsonObject PasteCommand::makeNewNodeIdsInScene(QJsonObject const &sceneJson)
+void PasteCommand::makeNewNodeIdsInScene()
 {
     AbstractGraphModel &graphModel = _scene->graphModel();
 
     std::unordered_map<NodeId, NodeId> mapNodeIds;
 
-    QJsonArray nodesJsonArray = sceneJson["nodes"].toArray();
-
-    QJsonArray newNodesJsonArray;
-    for (QJsonValueRef node : nodesJsonArray) {
-        QJsonObject nodeJson = node.toObject();
-
-        NodeId oldNodeId = nodeJson["id"].toInt();
+    for (GraphDelta::Node &node : _delta.nodes) {
+        NodeId const newNodeId = graphModel.newNodeId();
 
-        NodeId newNodeId = graphModel.newNodeId();
+        mapNodeIds[node.id] = newNodeId;
 
-        mapNodeIds[oldNodeId] = newNodeId;
-
-        // Replace NodeId in json
-        nodeJson["id"] = static_cast<qint64>(newNodeId);
-
-        newNodesJsonArray.append(nodeJson);
+        node.id = newNodeId;
     }
 
-    QJsonArray connectionJsonArray = sceneJson["connections"].toArray();
-
-    QJsonArray newConnJsonArray;
-    for (QJsonValueRef connection : connectionJsonArray) {
-        QJsonObject connJson = connection.toObject();
-
-        ConnectionId connId = fromJson(connJson);
-
-        ConnectionId newConnId{mapNodeIds[connId.outNodeId],
-                               connId.outPortIndex,
-                               mapNodeIds[connId.inNodeId],
-                               connId.inPortIndex};
-
-        newConnJsonArray.append(toJson(newConnId));
+    for (ConnectionId &connId : _delta.connections) {
+        connId = ConnectionId{mapNodeIds[connId.outNodeId],
+                              connId.outPortIndex,
+                              mapNodeIds[connId.inNodeId],
+                              connId.inPortIndex};
     }
-
-    QJsonObject newSceneJson;
-
-    newSceneJson["nodes"] = newNodesJsonArray;
-    newSceneJson["connections"] = newConnJsonArray;
-
-    return newSceneJson;
 }
 
 //-------------------------------------
@@ -380,14 +516,25 @@ DisconnectCommand::DisconnectCommand(BasicGraphicsScene *scene, ConnectionId con
 
 void DisconnectCommand::undo()
 {
+    if (isSuspended())
+        return;
+
     _scene->graphModel().addConnection(_connId);
 }
 
 void DisconnectCommand::redo()
 {
+    if (isSuspended())
+        return;
+
     _scene->graphModel().deleteConnection(_connId);
 }
 
+SceneUndoCommand *DisconnectCommand::takeState()
+{
+    return new DisconnectCommand(_scene, _connId);
+}
+
 //------
 
 ConnectCommand::ConnectCommand(BasicGraphicsScene *scene, ConnectionId const connId)
@@ -399,48 +546,74 @@ ConnectCommand::ConnectCommand(BasicGraphicsScene *scene, ConnectionId const con
 
 void ConnectCommand::undo()
 {
+    if (isSuspended())
+        return;
+
     _scene->graphModel().deleteConnection(_connId);
 }
 
 void ConnectCommand::redo()
 {
+    if (isSuspended())
+        return;
+
     _scene->graphModel().addConnection(_connId);
 }
 
+SceneUndoCommand *ConnectCommand::takeState()
+{
+    return new ConnectCommand(_scene, _connId);
+}
+
 //------
 
 MoveNodeCommand::MoveNodeCommand(BasicGraphicsScene *scene, QPointF const &diff)
     : _scene(scene)
     , _diff(diff)
 {
-    _selectedNodes.clear();
     for (QGraphicsItem *item : _scene->selectedItems()) {
         if (auto n = qgraphicsitem_cast<NodeGraphicsObject *>(item)) {
-            _selectedNodes.insert(n->nodeId());
+            _nodeIds.push_back(n->nodeId());
         }
     }
+
+    std::sort(_nodeIds.begin(), _nodeIds.end());
 }
 
-void MoveNodeCommand::undo()
+MoveNodeCommand::MoveNodeCommand(BasicGraphicsScene *scene,
+                                 std::vector<NodeId> nodeIds,
+                                 QPointF const &diff)
+    : _scene(scene)
+    , _nodeIds(std::move(nodeIds))
+    , _diff(diff)
 {
-    for (auto nodeId : _selectedNodes) {
-        auto oldPos = _scene->graphModel().nodeData(nodeId, NodeRole::Position).value<QPointF>();
+    std::sort(_nodeIds.begin(), _nodeIds.end());
+}
 
-        oldPos -= _diff;
+void MoveNodeCommand::undo()
+{
+    if (isSuspended())
+        return;
 
-        _scene->graphModel().setNodeData(nodeId, NodeRole::Position, oldPos);
-    }
+    _scene->graphModel().moveNodes(_nodeIds, -_diff);
 }
 
 void MoveNodeCommand::redo()
 {
-    for (auto nodeId : _selectedNodes) {
-        auto oldPos = _scene->graphModel().nodeData(nodeId, NodeRole::Position).value<QPointF>();
+    if (isSuspended())
+        return;
 
-        oldPos += _diff;
+    _scene->graphModel().moveNodes(_nodeIds, _diff);
+}
 
-        _scene->graphModel().setNodeData(nodeId, NodeRole::Position, oldPos);
-    }
+std::size_t MoveNodeCommand::memoryUsage() const
+{
+    return sizeof(*this) + _nodeIds.capacity() * sizeof(NodeId);
+}
+
+SceneUndoCommand *MoveNodeCommand::takeState()
+{
+    return new MoveNodeCommand(_scene, std::move(_nodeIds), _diff);
 }
 
 int MoveNodeCommand::id() const
@@ -452,7 +625,10 @@ bool MoveNodeCommand::mergeWith(QUndoCommand const *c)
 {
     auto mc = static_cast<MoveNodeCommand const *>(c);
 
-    if (_selectedNodes == mc->_selectedNodes) {
+    if (isSuspended() || mc->isSuspended())
+        return false;
+
+    if (_nodeIds == mc->_nodeIds) {
         _diff += mc->_diff;
         return true;
     }
@@ -1,18 +1,90 @@
 #pragma once
 
 #include "Definitions.hpp"
+#include "UndoPayloadStore.hpp"
 
 #include <QUndoCommand>
 #include <QtCore/QJsonObject>
 #include <QtCore/QPointF>
 
+#include <cstddef>
 #include <unordered_set>
+#include <vector>
 
 namespace QtNodes {
 
 class BasicGraphicsScene;
 
-class CreateCommand : public QUndoCommand
+/// Nodes and connections removed from or inserted into a scene by a command.
+/**
+ * Ids and positions are kept as plain values. The model name becomes a handle
+ * and the rest of `AbstractGraphModel::saveNode()` a binary payload, both held
+ * by the scene's UndoPayloadStore. Undo and redo therefore neither keep nor
+ * re-parse a JSON document of the whole selection.
+ */
+struct GraphDelta
+{
+    struct Node
+    {
+        NodeId id;
+        QPointF position;
+        int type;
+        /// Null for nodes with nothing to save besides their model name.
+        UndoPayloadStore::Payload payload;
+    };
+
+    std::vector<Node> nodes;
+
+    std::vector<ConnectionId> connections;
+
+    bool empty() const { return nodes.empty() && connections.empty(); }
+
+    /**
+   * Bytes of the node and connection arrays. The payloads are accounted by
+   * the UndoPayloadStore, which owns them.
+   */
+    std::size_t memoryUsage() const
+    {
+        return nodes.capacity() * sizeof(Node) + connections.capacity() * sizeof(ConnectionId);
+    }
+};
+
+/// Command accounted by the memory budget of the scene's undo history.
+/**
+ * QUndoStack cannot drop its oldest commands once it holds some. To trim its
+ * history, the scene moves the recorded state of the commands it keeps into
+ * new ones, see `takeState()`, and pushes them again to the cleared stack
+ * while they are suspended.
+ *
+ * @see BasicGraphicsScene::setUndoMemoryBudget
+ */
+class SceneUndoCommand : public QUndoCommand
+{
+public:
+    /**
+   * Bytes of the command object and of the arrays it owns. The payloads of
+   * the UndoPayloadStore are excluded, as is the heap bookkeeping of Qt and of
+   * the allocator. The value must only change when the command is pushed,
+   * merged, undone or redone, the scene keeps a running total of it.
+   */
+    virtual std::size_t memoryUsage() const = 0;
+
+    /// A new command holding the recorded state of this one, left empty.
+    virtual SceneUndoCommand *takeState() = 0;
+
+    /**
+   * A suspended command neither changes the graph when it is undone or
+   * redone, nor merges with other commands.
+   */
+    void setSuspended(bool suspended) { _suspended = suspended; }
+
+    bool isSuspended() const { return _suspended; }
+
+private:
+    bool _suspended = false;
+};
+
+class CreateCommand : public SceneUndoCommand
 {
 public:
     CreateCommand(BasicGraphicsScene *scene, QString const name, QPointF const &mouseScenePos);
@@ -20,17 +92,24 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t memoryUsage() const override;
+
+    SceneUndoCommand *takeState() override;
+
+private:
+    CreateCommand(BasicGraphicsScene *scene, NodeId nodeId, GraphDelta delta);
+
 private:
     BasicGraphicsScene *_scene;
     NodeId _nodeId;
-    QJsonObject _sceneJson;
+    GraphDelta _delta;
 };
 
 /**
- * Selected scene objects are serialized and then removed from the scene.
- * The deleted elements could be restored in `undo`.
+ * Selected scene objects are recorded in a GraphDelta and then removed from
+ * the scene. The deleted elements could be restored in `undo`.
  */
-class DeleteCommand : public QUndoCommand
+class DeleteCommand : public SceneUndoCommand
 {
 public:
     DeleteCommand(BasicGraphicsScene *scene);
@@ -38,9 +117,16 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t memoryUsage() const override;
+
+    SceneUndoCommand *takeState() override;
+
+private:
+    DeleteCommand(BasicGraphicsScene *scene, GraphDelta delta);
+
 private:
     BasicGraphicsScene *_scene;
-    QJsonObject _sceneJson;
+    GraphDelta _delta;
 };
 
 class CopyCommand : public QUndoCommand
@@ -49,7 +135,7 @@ public:
     CopyCommand(BasicGraphicsScene *scene);
 };
 
-class PasteCommand : public QUndoCommand
+class PasteCommand : public SceneUndoCommand
 {
 public:
     PasteCommand(BasicGraphicsScene *scene, QPointF const &mouseScenePos);
@@ -57,17 +143,23 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t memoryUsage() const override;
+
+    SceneUndoCommand *takeState() override;
+
 private:
+    PasteCommand(BasicGraphicsScene *scene, QPointF const &mouseScenePos, GraphDelta delta);
+
     QJsonObject takeSceneJsonFromClipboard();
-    QJsonObject makeNewNodeIdsInScene(QJsonObject const &sceneJson);
+    void makeNewNodeIdsInScene();
 
 private:
     BasicGraphicsScene *_scene;
-    QPointF const &_mouseScenePos;
-    QJsonObject _newSceneJson;
+    QPointF _mouseScenePos;
+    GraphDelta _delta;
 };
 
-class DisconnectCommand : public QUndoCommand
+class DisconnectCommand : public SceneUndoCommand
 {
 public:
     DisconnectCommand(BasicGraphicsScene *scene, ConnectionId const);
@@ -75,13 +167,17 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t memoryUsage() const override { return sizeof(*this); }
+
+    SceneUndoCommand *takeState() override;
+
 private:
     BasicGraphicsScene *_scene;
 
     ConnectionId _connId;
 };
 
-class ConnectCommand : public QUndoCommand
+class ConnectCommand : public SceneUndoCommand
 {
 public:
     ConnectCommand(BasicGraphicsScene *scene, ConnectionId const);
@@ -89,20 +185,32 @@ public:
     void undo() override;
     void redo() override;
 
+    std::size_t memoryUsage() const override { return sizeof(*this); }
+
+    SceneUndoCommand *takeState() override;
+
 private:
     BasicGraphicsScene *_scene;
 
     ConnectionId _connId;
 };
 
-class MoveNodeCommand : public QUndoCommand
+class MoveNodeCommand : public SceneUndoCommand
 {
 public:
+    /// Moves the nodes currently selected in `scene`.
     MoveNodeCommand(BasicGraphicsScene *scene, QPointF const &diff);
 
+    /// Moves `nodeIds` through a single `AbstractGraphModel::moveNodes()` call.
+    MoveNodeCommand(BasicGraphicsScene *scene, std::vector<NodeId> nodeIds, QPointF const &diff);
+
     void undo() override;
     void redo() override;
 
+    std::size_t memoryUsage() const override;
+
+    SceneUndoCommand *takeState() override;
+
     /**
    * A command ID is used in command compression. It must be an integer unique to
    * this command's class, or -1 if the command doesn't support compression.
@@ -116,7 +224,8 @@ public:
 
 private:
     BasicGraphicsScene *_scene;
-    std::unordered_set<NodeId> _selectedNodes;
+    /// Sorted, so that the node sets of two commands compare cheaply.
+    std::vector<NodeId> _nodeIds;
     QPointF _diff;
 };
 
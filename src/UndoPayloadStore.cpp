@@ -0,0 +1,253 @@
+#include "UndoPayloadStore.hpp"
+
+#include <QtCore/QDebug>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QTemporaryFile>
+
+#include <algorithm>
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
+#include <QtCore/QCborMap>
+#include <QtCore/QCborValue>
+#endif
+
+namespace QtNodes {
+
+UndoPayloadStore::UndoPayloadStore() = default;
+
+UndoPayloadStore::~UndoPayloadStore()
+{
+    resetSpillFile();
+}
+
+UndoPayloadStore::Payload UndoPayloadStore::intern(QByteArray const &bytes)
+{
+    std::size_t const hash = qHash(bytes);
+
+    for (auto it = _payloads.find(hash); it != _payloads.end() && it.key() == hash; ++it) {
+        Payload payload = it.value().lock();
+
+        if (!payload || payload->size != bytes.size())
+            continue;
+
+        QByteArray stored;
+        if (this->bytes(payload, stored) && stored == bytes)
+            return payload;
+    }
+
+    std::weak_ptr<UndoPayloadStore> store = shared_from_this();
+
+    std::shared_ptr<Entry> entry(new Entry{hash, bytes.size(), bytes}, [store](Entry *e) {
+        // Commands may outlive the scene owning the store.
+        if (auto s = store.lock())
+            s->release(e);
+
+        delete e;
+    });
+
+    _payloads.insert(hash, entry);
+    _residentBytes += static_cast<std::size_t>(bytes.size());
+
+    if (_spillEnabled) {
+        // Drops the released payloads from time to time.
+        if (_residentOrder.size() > 2 * static_cast<std::size_t>(_payloads.size()) + 64) {
+            _residentOrder.erase(std::remove_if(_residentOrder.begin(),
+                                                _residentOrder.end(),
+                                                [](std::weak_ptr<Entry> const &e) {
+                                                    return e.expired();
+                                                }),
+                                 _residentOrder.end());
+        }
+
+        _residentOrder.push_back(entry);
+    }
+
+    return entry;
+}
+
+void UndoPayloadStore::release(Entry const *entry)
+{
+    for (auto it = _payloads.find(entry->hash); it != _payloads.end() && it.key() == entry->hash;
+         ++it) {
+        if (it.value().expired()) {
+            _payloads.erase(it);
+            break;
+        }
+    }
+
+    if (entry->offset < 0) {
+        _residentBytes -= static_cast<std::size_t>(entry->size);
+        return;
+    }
+
+    _spilledBytes -= static_cast<std::size_t>(entry->size);
+
+    // The space of released payloads is reclaimed once the file is unused.
+    if (_spilledBytes == 0)
+        resetSpillFile();
+}
+
+bool UndoPayloadStore::bytes(Payload const &payload, QByteArray &result) const
+{
+    if (payload->offset < 0) {
+        result = payload->bytes;
+        return true;
+    }
+
+    uchar const *map = mappedSpillFile(payload->offset + payload->size);
+
+    if (!map) {
+        qWarning() << "UndoPayloadStore: cannot read back a spilled payload from"
+                   << (_spillFile ? _spillFile->fileName() : QString());
+        result.clear();
+        return false;
+    }
+
+    result = QByteArray(reinterpret_cast<char const *>(map + payload->offset), payload->size);
+    return true;
+}
+
+int UndoPayloadStore::typeHandle(QString const &typeName)
+{
+    auto it = _typeHandles.constFind(typeName);
+
+    if (it != _typeHandles.constEnd())
+        return it.value();
+
+    int const handle = static_cast<int>(_typeNames.size());
+
+    _typeNames.push_back(typeName);
+    _typeHandles.insert(typeName, handle);
+
+    return handle;
+}
+
+QString UndoPayloadStore::typeName(int handle) const
+{
+    if (handle < 0 || static_cast<std::size_t>(handle) >= _typeNames.size())
+        return QString();
+
+    return _typeNames[static_cast<std::size_t>(handle)];
+}
+
+void UndoPayloadStore::setSpillEnabled(bool enabled)
+{
+    if (_spillEnabled == enabled)
+        return;
+
+    _spillEnabled = enabled;
+    _residentOrder.clear();
+
+    if (!enabled)
+        return;
+
+    // Creation order is lost for the existing payloads, the hash order is
+    // good enough for them.
+    for (auto it = _payloads.begin(); it != _payloads.end(); ++it) {
+        _residentOrder.push_back(it.value());
+    }
+}
+
+void UndoPayloadStore::spill(std::size_t residentBytes)
+{
+    if (!_spillEnabled || _residentBytes <= residentBytes)
+        return;
+
+    if (!_spillFile) {
+        _spillFile = std::make_unique<QTemporaryFile>();
+
+        if (!_spillFile->open()) {
+            _spillFile.reset();
+            return;
+        }
+    }
+
+    _spillFile->seek(_spillFile->size());
+
+    while (_residentBytes > residentBytes && !_residentOrder.empty()) {
+        std::shared_ptr<Entry> entry = _residentOrder.front().lock();
+        _residentOrder.pop_front();
+
+        // Released or already spilled.
+        if (!entry || entry->offset >= 0)
+            continue;
+
+        qint64 const offset = _spillFile->pos();
+
+        if (_spillFile->write(entry->bytes) != entry->size)
+            break;
+
+        entry->offset = offset;
+        entry->bytes = QByteArray();
+
+        _residentBytes -= static_cast<std::size_t>(entry->size);
+        _spilledBytes += static_cast<std::size_t>(entry->size);
+    }
+
+    _spillFile->flush();
+}
+
+uchar const *UndoPayloadStore::mappedSpillFile(qint64 end) const
+{
+    if (!_spillFile)
+        return nullptr;
+
+    if (_spillMap && _spillMapSize >= end)
+        return _spillMap;
+
+    // The file has grown since it was mapped.
+    if (_spillMap)
+        _spillFile->unmap(_spillMap);
+
+    _spillMapSize = _spillFile->size();
+    _spillMap = _spillFile->map(0, _spillMapSize);
+
+    return (_spillMapSize >= end) ? _spillMap : nullptr;
+}
+
+void UndoPayloadStore::resetSpillFile()
+{
+    if (!_spillFile)
+        return;
+
+    if (_spillMap)
+        _spillFile->unmap(_spillMap);
+
+    _spillMap = nullptr;
+    _spillMapSize = 0;
+
+    _spillFile->resize(0);
+}
+
+QByteArray UndoPayloadStore::encode(QJsonObject const &json)
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
+    return QCborValue::fromJsonValue(json).toCbor();
+#else
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+#endif
+}
+
+bool UndoPayloadStore::decode(QByteArray const &bytes, QJsonObject &json)
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 12, 0))
+    QCborParserError error;
+    QCborValue const value = QCborValue::fromCbor(bytes, &error);
+
+    if (error.error != QCborError::NoError || !value.isMap())
+        return false;
+
+    json = value.toMap().toJsonObject();
+#else
+    QJsonParseError error;
+    QJsonDocument const document = QJsonDocument::fromJson(bytes, &error);
+
+    if (error.error != QJsonParseError::NoError || !document.isObject())
+        return false;
+
+    json = document.object();
+#endif
+    return true;
+}
+
+} // namespace QtNodes
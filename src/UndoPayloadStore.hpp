@@ -0,0 +1,129 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+#include <QtCore/QString>
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class QTemporaryFile;
+
+namespace QtNodes {
+
+/// Shared storage for the node payloads kept by the undo commands of a scene.
+/**
+ * Equal payloads are stored once and shared by all the commands referring to
+ * them, e.g. thousands of deleted nodes with default settings cost a single
+ * blob. A payload is released together with the last command holding it.
+ *
+ * With spilling enabled, `spill()` moves the oldest payloads to a temporary
+ * file. They are read back through a memory mapping of the file when a
+ * command is undone or redone.
+ *
+ * Model names are interned separately as small integer handles, so they do
+ * not make otherwise equal payloads differ.
+ *
+ * The store belongs to the GUI thread, like the undo stack itself.
+ */
+class UndoPayloadStore : public std::enable_shared_from_this<UndoPayloadStore>
+{
+public:
+    struct Entry
+    {
+        std::size_t hash;
+        qint64 size;
+        /// Empty once the payload is spilled.
+        QByteArray bytes;
+        /// Position in the spill file, `-1` while the payload is in memory.
+        qint64 offset = -1;
+    };
+
+    using Payload = std::shared_ptr<Entry const>;
+
+    static constexpr int InvalidTypeHandle = -1;
+
+    UndoPayloadStore();
+
+    ~UndoPayloadStore();
+
+    /// Returns the stored instance of `bytes`, shared with all equal payloads.
+    Payload intern(QByteArray const &bytes);
+
+    /**
+   * Reads the content of `payload` into `result`, from the spill file when
+   * needed. @returns `false`, with a warning, when a spilled payload cannot
+   * be read back.
+   */
+    bool bytes(Payload const &payload, QByteArray &result) const;
+
+    int typeHandle(QString const &typeName);
+
+    /// The name interned as `handle`, an empty string for unknown handles.
+    QString typeName(int handle) const;
+
+    void setSpillEnabled(bool enabled);
+
+    bool spillEnabled() const { return _spillEnabled; }
+
+    /**
+   * Moves the oldest payloads to the spill file until at most `residentBytes`
+   * stay in memory. Does nothing while spilling is disabled or when the
+   * temporary file cannot be written.
+   */
+    void spill(std::size_t residentBytes);
+
+    /// Number of distinct payloads currently referenced.
+    std::size_t payloadCount() const { return _payloads.size(); }
+
+    /// Total size of the distinct payloads currently referenced.
+    std::size_t payloadBytes() const { return _residentBytes + _spilledBytes; }
+
+    /// Part of `payloadBytes()` kept in memory.
+    std::size_t residentBytes() const { return _residentBytes; }
+
+    /// Part of `payloadBytes()` kept in the spill file.
+    std::size_t spilledBytes() const { return _spilledBytes; }
+
+    /// Compact binary form of `json`: CBOR, or compact JSON with Qt older than 5.12.
+    static QByteArray encode(QJsonObject const &json);
+
+    /// @returns `false` when `bytes` is not the output of `encode()`.
+    static bool decode(QByteArray const &bytes, QJsonObject &json);
+
+private:
+    void release(Entry const *entry);
+
+    /// Maps the spill file up to at least `end`, @returns `nullptr` on failure.
+    uchar const *mappedSpillFile(qint64 end) const;
+
+    void resetSpillFile();
+
+private:
+    /// Keyed by `qHash()` of the content.
+    QMultiHash<std::size_t, std::weak_ptr<Entry>> _payloads;
+
+    /// Payloads in creation order, the oldest ones are spilled first.
+    std::deque<std::weak_ptr<Entry>> _residentOrder;
+
+    std::size_t _residentBytes = 0;
+
+    std::size_t _spilledBytes = 0;
+
+    bool _spillEnabled = false;
+
+    std::unique_ptr<QTemporaryFile> _spillFile;
+
+    mutable uchar *_spillMap = nullptr;
+
+    mutable qint64 _spillMapSize = 0;
+
+    QHash<QString, int> _typeHandles;
+
+    std::vector<QString> _typeNames;
+};
+
+} // namespace QtNodes
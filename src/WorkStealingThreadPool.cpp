@@ -0,0 +1,130 @@
+#include "WorkStealingThreadPool.hpp"
+
+#include <algorithm>
+
+namespace QtNodes {
+
+namespace {
+
+struct WorkerContext
+{
+    WorkStealingThreadPool const *pool = nullptr;
+    std::size_t index = 0;
+};
+
+thread_local WorkerContext currentWorker;
+
+} // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(std::size_t workerCount)
+{
+    if (workerCount == 0)
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+    _workers.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        _workers.push_back(std::make_unique<Worker>());
+    }
+
+    _threads.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; ++i) {
+        _threads.emplace_back([this, i]() { run(i); });
+    }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stop = true;
+    }
+
+    _wakeUp.notify_all();
+
+    for (std::thread &thread : _threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingThreadPool::submit(Task task)
+{
+    std::size_t index = 0;
+
+    if (currentWorker.pool == this)
+        index = currentWorker.index;
+    else
+        index = _nextWorker.fetch_add(1, std::memory_order_relaxed) % _workers.size();
+
+    {
+        Worker &worker = *_workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        ++_pending;
+    }
+
+    _wakeUp.notify_one();
+}
+
+void WorkStealingThreadPool::run(std::size_t index)
+{
+    currentWorker.pool = this;
+    currentWorker.index = index;
+
+    while (true) {
+        Task task;
+
+        if (popLocal(index, task) || steal(index, task)) {
+            --_pending;
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wakeUp.wait(lock, [this]() { return _stop || _pending > 0; });
+
+        if (_stop && _pending <= 0)
+            break;
+    }
+
+    currentWorker = WorkerContext{};
+}
+
+bool WorkStealingThreadPool::popLocal(std::size_t index, Task &task)
+{
+    Worker &worker = *_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+
+    if (worker.tasks.empty())
+        return false;
+
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+
+    return true;
+}
+
+bool WorkStealingThreadPool::steal(std::size_t thief, Task &task)
+{
+    std::size_t const count = _workers.size();
+
+    for (std::size_t i = 1; i < count; ++i) {
+        Worker &victim = *_workers[(thief + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (victim.tasks.empty())
+            continue;
+
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+
+        return true;
+    }
+
+    return false;
+}
+
+} // namespace QtNodes
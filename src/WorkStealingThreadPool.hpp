@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace QtNodes {
+
+/// Fixed-size thread pool with one task deque per worker.
+/**
+ * A worker pops the most recently submitted task from the back of its own
+ * deque and, once it runs dry, steals the oldest task from the front of the
+ * other workers' deques. Tasks submitted from a worker thread go to that
+ * worker's deque, all the others are distributed round-robin.
+ *
+ * The destructor runs the remaining tasks and joins the workers.
+ */
+class WorkStealingThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    /// `workerCount == 0` selects `std::thread::hardware_concurrency()`.
+    explicit WorkStealingThreadPool(std::size_t workerCount = 0);
+
+    ~WorkStealingThreadPool();
+
+    WorkStealingThreadPool(WorkStealingThreadPool const &) = delete;
+    WorkStealingThreadPool &operator=(WorkStealingThreadPool const &) = delete;
+
+    std::size_t workerCount() const { return _threads.size(); }
+
+    /// Can be called from any thread, including the workers themselves.
+    void submit(Task task);
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(std::size_t index);
+
+    bool popLocal(std::size_t index, Task &task);
+
+    bool steal(std::size_t thief, Task &task);
+
+private:
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    std::vector<std::thread> _threads;
+
+    std::mutex _sleepMutex;
+
+    std::condition_variable _wakeUp;
+
+    /// Submitted tasks not yet picked by a worker. May briefly drop below zero.
+    std::atomic<long> _pending{0};
+
+    std::atomic<std::size_t> _nextWorker{0};
+
+    bool _stop = false;
+};
+
+} // namespace QtNodes
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <QtNodes/NodeData>
+#include <QtNodes/NodeDelegateModel>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonValue>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+/// NodeDelegateModel with the members the tests rarely care about.
+/**
+ * One port on each side of type "plain", no data and no embedded widget.
+ * Test models derive from it and override what they exercise.
+ */
+class StubDelegateModel : public QtNodes::NodeDelegateModel
+{
+public:
+    QString caption() const override { return name(); }
+
+    QString descriptions() const override { return QString(); }
+
+    QString icon() override { return QString(); }
+
+    unsigned int nPorts(QtNodes::PortType) const override { return 1; }
+
+    QtNodes::NodeDataType dataType(QtNodes::PortType, QtNodes::PortIndex) const override
+    {
+        return QtNodes::NodeDataType{"plain", "Plain"};
+    }
+
+    void setInData(std::shared_ptr<QtNodes::NodeData>, QtNodes::PortIndex, bool) override {}
+
+    std::shared_ptr<QtNodes::NodeData> outData(QtNodes::PortIndex) override { return nullptr; }
+
+    QWidget *embeddedWidget() override { return nullptr; }
+};
+
+/// Registered as "Plain", nothing to save and nothing to compute.
+class PlainModel : public StubDelegateModel
+{
+public:
+    QString name() const override { return "Plain"; }
+};
+
+/// Integer payload for the data flow tests.
+class IntData : public QtNodes::NodeData
+{
+public:
+    explicit IntData(int value = 0)
+        : _value(value)
+    {}
+
+    static QtNodes::NodeDataType staticType() { return QtNodes::NodeDataType{"int", "Integer"}; }
+
+    QtNodes::NodeDataType type() const override { return staticType(); }
+
+    int value() const { return _value; }
+
+private:
+    int _value;
+};
+
+/// `save()` iterates hash containers, sort the arrays to compare two graphs.
+inline QJsonObject normalizedGraph(QJsonObject json)
+{
+    auto sorted = [](QJsonArray const &array) {
+        std::vector<QByteArray> items;
+        for (QJsonValue const &value : array) {
+            items.push_back(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact));
+        }
+
+        std::sort(items.begin(), items.end());
+
+        QJsonArray result;
+        for (QByteArray const &item : items) {
+            result.append(QJsonDocument::fromJson(item).object());
+        }
+        return result;
+    };
+
+    json["nodes"] = sorted(json["nodes"].toArray());
+    json["connections"] = sorted(json["connections"].toArray());
+
+    return json;
+}
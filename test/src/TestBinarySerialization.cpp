@@ -0,0 +1,175 @@
+#include "ApplicationSetup.hpp"
+#include "TestModels.hpp"
+
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using QtNodes::DataFlowGraphModel;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModel;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+
+namespace {
+
+/// Stores a user-editable value, so its payload is not empty.
+class ValueModel : public StubDelegateModel
+{
+public:
+    QString name() const override { return "Value"; }
+
+    NodeDataType dataType(PortType, PortIndex) const override
+    {
+        return NodeDataType{"value", "Value"};
+    }
+
+    QJsonObject save() const override
+    {
+        QJsonObject modelJson = NodeDelegateModel::save();
+        modelJson["number"] = _number;
+        modelJson["label"] = _label;
+        return modelJson;
+    }
+
+    void load(QJsonObject const &p) override
+    {
+        _number = p["number"].toDouble();
+        _label = p["label"].toString();
+    }
+
+private:
+    double _number = 0.0;
+    QString _label;
+};
+
+/// Has nothing to save besides its model name.
+class PassModel : public ValueModel
+{
+public:
+    QString name() const override { return "Pass"; }
+
+    QJsonObject save() const override { return NodeDelegateModel::save(); }
+
+    void load(QJsonObject const &) override {}
+};
+
+std::shared_ptr<NodeDelegateModelRegistry> registerModels()
+{
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<ValueModel>("Test");
+    registry->registerModel<PassModel>("Test");
+    return registry;
+}
+
+QString const flowScene(R"(
+    {
+        "nodes": [
+            {
+                "id": 0,
+                "internal-data": { "model-name": "Value", "number": 3.5, "label": "left" },
+                "position": { "x": -338, "y": -160 }
+            },
+            {
+                "id": 1,
+                "internal-data": { "model-name": "Pass" },
+                "position": { "x": -31.5, "y": -264 }
+            },
+            {
+                "id": 7,
+                "internal-data": { "model-name": "Value", "number": -1, "label": "ünïcode" },
+                "position": { "x": 201, "y": -129 }
+            }
+        ],
+        "connections": [
+            { "outNodeId": 0, "outPortIndex": 0, "intNodeId": 1, "inPortIndex": 0 },
+            { "outNodeId": 1, "outPortIndex": 0, "intNodeId": 7, "inPortIndex": 0 }
+        ]
+    }
+)");
+
+/// A stream with the given header, nodes 0 and 1 of model `name` and a
+/// connection from node 0 to `inNodeId`.
+QByteArray binaryGraph(quint16 version, quint8 encoding, QString const &name, quint32 inNodeId)
+{
+    QByteArray result;
+
+    QDataStream out(&result, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_11);
+
+    out << quint32(0x514E4746) << version << encoding;
+    out << quint32(1) << name;
+
+    out << quint32(2);
+    for (quint32 id = 0; id < 2; ++id) {
+        out << id << quint32(0) << 0.0 << 0.0 << QByteArray();
+    }
+
+    out << quint32(1) << quint32(0) << quint32(0) << inNodeId << quint32(0);
+
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("Binary format round-trips the JSON flow format", "[serialization]")
+{
+    auto setup = applicationSetup();
+
+    auto registry = registerModels();
+
+    DataFlowGraphModel original(registry);
+    original.load(QJsonDocument::fromJson(flowScene.toUtf8()).object());
+
+    QByteArray const binary = original.saveBinary();
+
+    CHECK(DataFlowGraphModel::isBinaryFormat(binary));
+    CHECK_FALSE(DataFlowGraphModel::isBinaryFormat(flowScene.toUtf8()));
+
+    DataFlowGraphModel restored(registry);
+    REQUIRE(restored.loadBinary(binary));
+
+    CHECK(normalizedGraph(restored.save()) == normalizedGraph(original.save()));
+
+    SECTION("Corrupted data leaves the model untouched")
+    {
+        DataFlowGraphModel target(registry);
+
+        CHECK_FALSE(target.loadBinary(binary.left(binary.size() / 2)));
+        CHECK(target.allNodeIds().empty());
+    }
+
+    SECTION("Invalid headers and tables are rejected up front")
+    {
+        DataFlowGraphModel target(registry);
+
+        REQUIRE(target.loadBinary(binaryGraph(1, 0, "Value", 1)));
+
+        DataFlowGraphModel empty(registry);
+
+        CHECK_FALSE(empty.loadBinary(binaryGraph(0, 0, "Value", 1)));
+        CHECK_FALSE(empty.loadBinary(binaryGraph(2, 0, "Value", 1)));
+        CHECK_FALSE(empty.loadBinary(binaryGraph(1, 7, "Value", 1)));
+        CHECK_FALSE(empty.loadBinary(binaryGraph(1, 0, "Value", 5)));
+        CHECK_THROWS_AS(empty.loadBinary(binaryGraph(1, 0, "Unknown", 1)), std::logic_error);
+
+        CHECK(empty.allNodeIds().empty());
+
+        // Nodes 0 and 1 are already in use.
+        CHECK_FALSE(target.loadBinary(binaryGraph(1, 0, "Value", 1)));
+        CHECK(target.allNodeIds().size() == 2);
+    }
+}
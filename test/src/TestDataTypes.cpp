@@ -0,0 +1,370 @@
+#include "ApplicationSetup.hpp"
+#include "TestModels.hpp"
+
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeData>
+#include <QtNodes/NodeDelegateModelRegistry>
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QString>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::InvalidNodeDataTypeHandle;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDataTypeHandle;
+using QtNodes::NodeDataTypeRegistry;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeId;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+using QtNodes::SharedNodeData;
+using QtNodes::TypeConverter;
+
+namespace {
+
+NodeDataType const IntType = IntData::staticType();
+NodeDataType const DoubleType{"converter-double", "Double"};
+NodeDataType const TextType{"converter-text", "Text"};
+
+class DoubleData : public NodeData
+{
+public:
+    explicit DoubleData(double value)
+        : _value(value)
+    {}
+
+    NodeDataType type() const override { return DoubleType; }
+
+    double value() const { return _value; }
+
+private:
+    double _value;
+};
+
+class TextData : public NodeData
+{
+public:
+    explicit TextData(QString text)
+        : _text(std::move(text))
+    {}
+
+    NodeDataType type() const override { return TextType; }
+
+    QString text() const { return _text; }
+
+private:
+    QString _text;
+};
+
+SharedNodeData intToDouble(SharedNodeData data)
+{
+    return std::make_shared<DoubleData>(std::static_pointer_cast<IntData>(data)->value());
+}
+
+SharedNodeData doubleToText(SharedNodeData data)
+{
+    double const value = std::static_pointer_cast<DoubleData>(data)->value();
+    return std::make_shared<TextData>(QString::number(value, 'f', 1));
+}
+
+class IntSourceModel : public StubDelegateModel
+{
+public:
+    QString name() const override { return "IntSource"; }
+
+    unsigned int nPorts(PortType portType) const override
+    {
+        return (portType == PortType::Out) ? 1 : 0;
+    }
+
+    NodeDataType dataType(PortType, PortIndex) const override { return IntType; }
+
+    std::shared_ptr<NodeData> outData(PortIndex) override { return _data; }
+
+    void trigger(int value)
+    {
+        _data = std::make_shared<IntData>(value);
+        Q_EMIT dataUpdated(0, true);
+    }
+
+private:
+    std::shared_ptr<IntData> _data;
+};
+
+class TextSinkModel : public StubDelegateModel
+{
+public:
+    QString name() const override { return "TextSink"; }
+
+    unsigned int nPorts(PortType portType) const override
+    {
+        return (portType == PortType::In) ? 1 : 0;
+    }
+
+    NodeDataType dataType(PortType, PortIndex) const override { return TextType; }
+
+    void setInData(std::shared_ptr<NodeData> data, PortIndex, bool) override
+    {
+        received = std::dynamic_pointer_cast<TextData>(data);
+    }
+
+    std::shared_ptr<TextData> received;
+};
+
+} // namespace
+
+TEST_CASE("Data type ids are interned", "[datatypes]")
+{
+    NodeDataType const a = NodeDataType::interned("interned-a", "A");
+    NodeDataType const b = NodeDataType::interned("interned-b", "B");
+    NodeDataType const anotherA = NodeDataType::interned("interned-a", "Another A");
+
+    CHECK(a.handle() != InvalidNodeDataTypeHandle);
+    CHECK(a.handle() == anotherA.handle());
+    CHECK(a.handle() != b.handle());
+
+    CHECK(a.sameType(anotherA));
+    CHECK_FALSE(a.sameType(b));
+
+    CHECK(NodeDataTypeRegistry::typeId(b.handle()) == "interned-b");
+    CHECK(NodeDataTypeRegistry::typeId(-5).isEmpty());
+
+    SECTION("Copies keep the handle")
+    {
+        NodeDataType const copy = a;
+
+        CHECK(copy.handle() == a.handle());
+    }
+
+    SECTION("Types built without interning compare by id")
+    {
+        NodeDataType const plain{"interned-a", "A"};
+
+        CHECK(plain.handle() == InvalidNodeDataTypeHandle);
+        CHECK(plain.sameType(a));
+        CHECK_FALSE(plain.sameType(b));
+    }
+
+    SECTION("Assigning the id drops the handle")
+    {
+        NodeDataType changed = a;
+        changed.id = "interned-b";
+
+        CHECK(changed.handle() == InvalidNodeDataTypeHandle);
+        CHECK(changed.sameType(b));
+        CHECK_FALSE(changed.sameType(a));
+
+        changed.id.append("-suffix");
+
+        CHECK(changed.handle() == InvalidNodeDataTypeHandle);
+        CHECK_FALSE(changed.sameType(b));
+    }
+
+    SECTION("Modifying the id in place drops the handle")
+    {
+        NodeDataType changed = NodeDataType::interned("interned-c", "C");
+        changed.id[0] = QChar('x');
+
+        CHECK(changed.handle() == InvalidNodeDataTypeHandle);
+        CHECK(changed.id == "xnterned-c");
+    }
+}
+
+TEST_CASE("Data type ids are interned once across threads", "[datatypes]")
+{
+    std::vector<std::thread> threads;
+    std::vector<NodeDataTypeHandle> handles(8, InvalidNodeDataTypeHandle);
+
+    for (std::size_t i = 0; i < handles.size(); ++i) {
+        threads.emplace_back([&handles, i]() {
+            handles[i] = NodeDataTypeRegistry::intern(QStringLiteral("threaded"));
+        });
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (NodeDataTypeHandle const handle : handles) {
+        CHECK(handle == handles.front());
+    }
+}
+
+TEST_CASE("Comparing data types", "[.benchmark]")
+{
+    QString const idA = "benchmark-type-with-a-long-identifier-a";
+    QString const idB = "benchmark-type-with-a-long-identifier-b";
+
+    NodeDataType const a = NodeDataType::interned(idA, "A");
+    NodeDataType const b = NodeDataType::interned(idB, "B");
+
+    BENCHMARK("QString id compare, 1000 times")
+    {
+        int same = 0;
+        for (int i = 0; i < 1000; ++i) {
+            same += (a.id == b.id);
+        }
+        return same;
+    };
+
+    BENCHMARK("interned handle compare, 1000 times")
+    {
+        int same = 0;
+        for (int i = 0; i < 1000; ++i) {
+            same += a.sameType(b);
+        }
+        return same;
+    };
+
+    BENCHMARK("types built per call, 1000 times")
+    {
+        int same = 0;
+        for (int i = 0; i < 1000; ++i) {
+            same += NodeDataType(idA, "A").sameType(NodeDataType(idB, "B"));
+        }
+        return same;
+    };
+}
+
+TEST_CASE("Type converters are chained and cached", "[datatypes]")
+{
+    NodeDelegateModelRegistry registry;
+
+    CHECK_FALSE(registry.getTypeConverter(IntType, TextType));
+
+    int directCalls = 0;
+
+    registry.registerTypeConverter(IntType, DoubleType, [&](SharedNodeData data) {
+        ++directCalls;
+        return intToDouble(std::move(data));
+    });
+    registry.registerTypeConverter(DoubleType, TextType, doubleToText);
+
+    TypeConverter const direct = registry.getTypeConverter(IntType, DoubleType);
+    REQUIRE(direct);
+
+    auto doubleData = std::dynamic_pointer_cast<DoubleData>(direct(std::make_shared<IntData>(3)));
+    REQUIRE(doubleData);
+    CHECK(doubleData->value() == 3.0);
+    CHECK(directCalls == 1);
+
+    TypeConverter const chained = registry.getTypeConverter(IntType, TextType);
+    REQUIRE(chained);
+
+    auto textData = std::dynamic_pointer_cast<TextData>(chained(std::make_shared<IntData>(7)));
+    REQUIRE(textData);
+    CHECK(textData->text() == "7.0");
+    CHECK(directCalls == 2);
+
+    // Converters are directed.
+    CHECK_FALSE(registry.getTypeConverter(TextType, IntType));
+
+    SECTION("Types built field by field are resolved by id")
+    {
+        NodeDataType plain;
+        plain.id = IntType.id;
+
+        CHECK(registry.getTypeConverter(plain, TextType));
+    }
+
+    SECTION("Registering a converter refreshes the cached chains")
+    {
+        registry.registerTypeConverter(IntType, TextType, [](SharedNodeData) {
+            return std::make_shared<TextData>("direct");
+        });
+
+        auto converted = std::dynamic_pointer_cast<TextData>(
+            registry.getTypeConverter(IntType, TextType)(std::make_shared<IntData>(7)));
+
+        REQUIRE(converted);
+        CHECK(converted->text() == "direct");
+
+        CHECK_FALSE(registry.getTypeConverter(TextType, IntType));
+
+        registry.registerTypeConverter(TextType, IntType, [](SharedNodeData) {
+            return std::make_shared<IntData>(0);
+        });
+
+        CHECK(registry.getTypeConverter(TextType, IntType));
+    }
+}
+
+TEST_CASE("Data flow applies type converters inline", "[datatypes]")
+{
+    auto setup = applicationSetup();
+
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<IntSourceModel>("Test");
+    registry->registerModel<TextSinkModel>("Test");
+
+    DataFlowGraphModel model(registry);
+
+    NodeId const source = model.addNode("IntSource");
+    NodeId const sink = model.addNode("TextSink");
+
+    ConnectionId const connectionId{source, 0, sink, 0};
+
+    CHECK_FALSE(model.connectionPossible(connectionId));
+
+    registry->registerTypeConverter(IntType, DoubleType, intToDouble);
+    registry->registerTypeConverter(DoubleType, TextType, doubleToText);
+
+    REQUIRE(model.connectionPossible(connectionId));
+    model.addConnection(connectionId);
+
+    auto *sourceModel = model.delegateModel<IntSourceModel>(source);
+    auto *sinkModel = model.delegateModel<TextSinkModel>(sink);
+
+    sourceModel->trigger(42);
+
+    REQUIRE(sinkModel->received);
+    CHECK(sinkModel->received->text() == "42.0");
+
+    SECTION("Topological passes convert too")
+    {
+        model.setExecutionMode(DataFlowGraphModel::ExecutionMode::Topological);
+
+        sourceModel->trigger(5);
+        QCoreApplication::processEvents();
+
+        REQUIRE(sinkModel->received);
+        CHECK(sinkModel->received->text() == "5.0");
+    }
+}
+
+TEST_CASE("Resolving type converters", "[.benchmark]")
+{
+    NodeDelegateModelRegistry registry;
+
+    std::vector<NodeDataType> types;
+    for (int i = 0; i < 16; ++i) {
+        types.emplace_back(QString("benchmark-chain-%1").arg(i), QString::number(i));
+    }
+
+    for (std::size_t i = 0; i + 1 < types.size(); ++i) {
+        registry.registerTypeConverter(types[i], types[i + 1], [](SharedNodeData data) {
+            return data;
+        });
+    }
+
+    BENCHMARK("15-hop chain, cached lookup")
+    {
+        return static_cast<bool>(registry.getTypeConverter(types.front(), types.back()));
+    };
+
+    BENCHMARK("15-hop chain, resolved after every registration")
+    {
+        registry.registerTypeConverter(types[0], types[1], [](SharedNodeData data) {
+            return data;
+        });
+        return static_cast<bool>(registry.getTypeConverter(types.front(), types.back()));
+    };
+}
@@ -0,0 +1,336 @@
+#include "ApplicationSetup.hpp"
+#include "TestModels.hpp"
+
+#include <QtNodes/BasicGraphicsScene>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeData>
+#include <QtNodes/NodeDelegateModelRegistry>
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QJsonObject>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+using QtNodes::AbstractGraphModel;
+using QtNodes::BasicGraphicsScene;
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::GraphChangeSet;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeId;
+using QtNodes::NodeRole;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+
+namespace {
+
+NodeDataType const IntType = IntData::staticType();
+
+class SourceModel : public StubDelegateModel
+{
+public:
+    QString name() const override { return "Source"; }
+
+    unsigned int nPorts(PortType portType) const override
+    {
+        return (portType == PortType::Out) ? 1 : 0;
+    }
+
+    NodeDataType dataType(PortType, PortIndex) const override { return IntType; }
+
+    std::shared_ptr<NodeData> outData(PortIndex) override { return _data; }
+
+private:
+    std::shared_ptr<IntData> _data = std::make_shared<IntData>(7);
+};
+
+class SinkModel : public StubDelegateModel
+{
+public:
+    QString name() const override { return "Sink"; }
+
+    unsigned int nPorts(PortType portType) const override
+    {
+        return (portType == PortType::In) ? 1 : 0;
+    }
+
+    NodeDataType dataType(PortType, PortIndex) const override { return IntType; }
+
+    void setInData(std::shared_ptr<NodeData> data, PortIndex, bool) override
+    {
+        ++deliveries;
+
+        if (auto input = std::dynamic_pointer_cast<IntData>(data))
+            received = input->value();
+    }
+
+    int deliveries = 0;
+
+    int received = 0;
+};
+
+/// Forwards its input without emitting, so only the model moves data through it.
+class RelayModel : public StubDelegateModel
+{
+public:
+    explicit RelayModel(std::shared_ptr<int> sequence)
+        : _sequence(std::move(sequence))
+    {}
+
+    QString name() const override { return "Relay"; }
+
+    NodeDataType dataType(PortType, PortIndex) const override { return IntType; }
+
+    void setInData(std::shared_ptr<NodeData> data, PortIndex, bool) override
+    {
+        ++deliveries;
+        order = ++*_sequence;
+        _data = std::move(data);
+    }
+
+    std::shared_ptr<NodeData> outData(PortIndex) override { return _data; }
+
+    int deliveries = 0;
+
+    /// Position of the last delivery among all the relays of the registry.
+    int order = 0;
+
+private:
+    std::shared_ptr<int> _sequence;
+    std::shared_ptr<NodeData> _data;
+};
+
+std::shared_ptr<NodeDelegateModelRegistry> registerModels()
+{
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<SourceModel>("Test");
+    registry->registerModel<SinkModel>("Test");
+
+    auto sequence = std::make_shared<int>(0);
+    registry->registerModel<RelayModel>(
+        [sequence]() { return std::make_unique<RelayModel>(sequence); }, "Test");
+    return registry;
+}
+
+/// Adds `count` source/sink pairs, each pair connected.
+std::vector<ConnectionId> addConnectedPairs(DataFlowGraphModel &model, int count)
+{
+    std::vector<ConnectionId> connectionIds;
+
+    for (int i = 0; i < count; ++i) {
+        NodeId const source = model.addNode("Source");
+        NodeId const sink = model.addNode("Sink");
+
+        model.setNodeData(source, NodeRole::Position, QPointF(0.0, i * 100.0));
+        model.setNodeData(sink, NodeRole::Position, QPointF(300.0, i * 100.0));
+
+        ConnectionId const connectionId{source, 0, sink, 0};
+        model.addConnection(connectionId);
+
+        connectionIds.push_back(connectionId);
+    }
+
+    return connectionIds;
+}
+
+} // namespace
+
+TEST_CASE("Batched changes reach the scene once", "[batch]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    BasicGraphicsScene scene(model);
+
+    int modifications = 0;
+    QObject::connect(&scene, &BasicGraphicsScene::modified, [&]() { ++modifications; });
+
+    std::vector<GraphChangeSet> commits;
+    QObject::connect(&model,
+                     &AbstractGraphModel::batchCommitted,
+                     [&](GraphChangeSet const &changes) { commits.push_back(changes); });
+
+    std::vector<ConnectionId> connectionIds;
+
+    {
+        AbstractGraphModel::BatchGuard batch(model);
+
+        connectionIds = addConnectedPairs(model, 10);
+
+        CHECK(model.inBatch());
+        CHECK(scene.nodeGraphicsObject(connectionIds[0].outNodeId) == nullptr);
+
+        // Data only flows once the batch is over.
+        CHECK(model.delegateModel<SinkModel>(connectionIds[0].inNodeId)->deliveries == 0);
+    }
+
+    CHECK_FALSE(model.inBatch());
+    CHECK(modifications == 1);
+
+    REQUIRE(commits.size() == 1);
+    CHECK(commits[0].createdNodes.size() == 20);
+    CHECK(commits[0].createdConnections.size() == 10);
+    CHECK(commits[0].movedNodes.empty());
+
+    for (ConnectionId const &connectionId : connectionIds) {
+        CHECK(scene.nodeGraphicsObject(connectionId.outNodeId) != nullptr);
+        CHECK(scene.connectionGraphicsObject(connectionId) != nullptr);
+
+        auto sink = model.delegateModel<SinkModel>(connectionId.inNodeId);
+        CHECK(sink->deliveries == 1);
+        CHECK(sink->received == 7);
+    }
+
+    SECTION("Items living only within a batch are not reported")
+    {
+        commits.clear();
+
+        {
+            AbstractGraphModel::BatchGuard batch(model);
+
+            NodeId const nodeId = model.addNode("Source");
+            model.deleteNode(nodeId);
+        }
+
+        CHECK(commits.empty());
+    }
+
+    SECTION("Deletions are coalesced")
+    {
+        commits.clear();
+        modifications = 0;
+
+        scene.clearScene();
+
+        CHECK(model.allNodeIds().empty());
+        CHECK(modifications == 1);
+
+        REQUIRE(commits.size() == 1);
+        CHECK(commits[0].deletedNodes.size() == 20);
+        CHECK(commits[0].deletedConnections.size() == 10);
+        CHECK(commits[0].createdNodes.empty());
+
+        CHECK(scene.nodeGraphicsObject(connectionIds[0].outNodeId) == nullptr);
+        CHECK(scene.connectionGraphicsObject(connectionIds[0]) == nullptr);
+    }
+
+    SECTION("Nested batches commit with the outermost one")
+    {
+        commits.clear();
+
+        {
+            AbstractGraphModel::BatchGuard outer(model);
+
+            {
+                AbstractGraphModel::BatchGuard inner(model);
+                model.addNode("Source");
+            }
+
+            CHECK(commits.empty());
+
+            model.addNode("Sink");
+        }
+
+        REQUIRE(commits.size() == 1);
+        CHECK(commits[0].createdNodes.size() == 2);
+    }
+}
+
+TEST_CASE("Loading a graph resets the scene once", "[batch]")
+{
+    auto setup = applicationSetup();
+
+    // source -> first -> second -> sink, created downstream first so that the
+    // saved node order is not a topological one.
+    QJsonObject saved;
+    NodeId source = QtNodes::InvalidNodeId;
+    NodeId first = QtNodes::InvalidNodeId;
+    NodeId second = QtNodes::InvalidNodeId;
+    NodeId sink = QtNodes::InvalidNodeId;
+
+    {
+        DataFlowGraphModel original(registerModels());
+
+        sink = original.addNode("Sink");
+        second = original.addNode("Relay");
+        first = original.addNode("Relay");
+        source = original.addNode("Source");
+
+        original.addConnection(ConnectionId{second, 0, sink, 0});
+        original.addConnection(ConnectionId{first, 0, second, 0});
+        original.addConnection(ConnectionId{source, 0, first, 0});
+
+        saved = original.save();
+    }
+
+    DataFlowGraphModel model(registerModels());
+    BasicGraphicsScene scene(model);
+
+    int resets = 0;
+    int itemSignals = 0;
+    int deliveriesBeforeReset = -1;
+
+    QObject::connect(&model, &AbstractGraphModel::modelReset, [&]() {
+        ++resets;
+        deliveriesBeforeReset = model.delegateModel<SinkModel>(sink)->deliveries;
+    });
+
+    auto countItemSignal = [&]() { ++itemSignals; };
+
+    QObject::connect(&model, &AbstractGraphModel::nodeCreated, countItemSignal);
+    QObject::connect(&model, &AbstractGraphModel::connectionCreated, countItemSignal);
+    QObject::connect(&model, &AbstractGraphModel::nodePositionUpdated, countItemSignal);
+
+    model.load(saved);
+
+    CHECK(resets == 1);
+    CHECK(itemSignals == 0);
+
+    // No data flows until the graph is complete.
+    CHECK(deliveriesBeforeReset == 0);
+
+    for (NodeId const nodeId : {source, first, second, sink}) {
+        CHECK(scene.nodeGraphicsObject(nodeId) != nullptr);
+    }
+
+    CHECK(scene.connectionGraphicsObject(ConnectionId{first, 0, second, 0}) != nullptr);
+
+    auto firstRelay = model.delegateModel<RelayModel>(first);
+    auto secondRelay = model.delegateModel<RelayModel>(second);
+    auto sinkModel = model.delegateModel<SinkModel>(sink);
+
+    // Each input is set once, upstream nodes first.
+    CHECK(firstRelay->deliveries == 1);
+    CHECK(secondRelay->deliveries == 1);
+    CHECK(sinkModel->deliveries == 1);
+    CHECK(firstRelay->order < secondRelay->order);
+    CHECK(sinkModel->received == 7);
+}
+
+TEST_CASE("Generating large graphs", "[.benchmark]")
+{
+    auto setup = applicationSetup();
+
+    BENCHMARK("2.5k connected pairs, per-item signals")
+    {
+        DataFlowGraphModel model(registerModels());
+        BasicGraphicsScene scene(model);
+
+        return addConnectedPairs(model, 2500).size();
+    };
+
+    BENCHMARK("2.5k connected pairs, one batch")
+    {
+        DataFlowGraphModel model(registerModels());
+        BasicGraphicsScene scene(model);
+
+        AbstractGraphModel::BatchGuard batch(model);
+
+        return addConnectedPairs(model, 2500).size();
+    };
+}
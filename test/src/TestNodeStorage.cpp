@@ -0,0 +1,375 @@
+#include "ApplicationSetup.hpp"
+#include "TestModels.hpp"
+
+#include <QtNodes/ConnectionIdUtils>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+
+#include "NodeSlotArray.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QPointF>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeFlag;
+using QtNodes::NodeId;
+using QtNodes::NodeRole;
+using QtNodes::NodeSlotArray;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+
+namespace {
+
+class ResizableModel : public PlainModel
+{
+public:
+    QString name() const override { return "Resizable"; }
+
+    bool resizable() const override { return isResizable; }
+
+    bool isResizable = true;
+};
+
+/// Three output ports and a variable number of input ports.
+class DynamicPortsModel : public StubDelegateModel
+{
+public:
+    QString name() const override { return "DynamicPorts"; }
+
+    unsigned int nPorts(PortType portType) const override
+    {
+        return (portType == PortType::In) ? _inPorts : 3;
+    }
+
+    void insertInPort(PortIndex index)
+    {
+        Q_EMIT portsAboutToBeInserted(PortType::In, index, index);
+        ++_inPorts;
+        Q_EMIT portsInserted();
+    }
+
+    void removeInPort(PortIndex index)
+    {
+        Q_EMIT portsAboutToBeDeleted(PortType::In, index, index);
+        --_inPorts;
+        Q_EMIT portsDeleted();
+    }
+
+private:
+    unsigned int _inPorts = 3;
+};
+
+std::shared_ptr<NodeDelegateModelRegistry> registerModels()
+{
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<PlainModel>("Test");
+    registry->registerModel<ResizableModel>("Test");
+    registry->registerModel<DynamicPortsModel>("Test");
+    return registry;
+}
+
+std::vector<NodeId> addNodes(DataFlowGraphModel &model, int count)
+{
+    std::vector<NodeId> nodeIds;
+
+    for (int i = 0; i < count; ++i) {
+        NodeId const nodeId = model.addNode("Plain");
+        model.setNodeData(nodeId, NodeRole::Position, QPointF(i, -i));
+        nodeIds.push_back(nodeId);
+    }
+
+    return nodeIds;
+}
+
+/// Compares the per-node and per-port queries with the saved connection list.
+void checkConnectionIndex(DataFlowGraphModel const &model)
+{
+    std::unordered_set<ConnectionId> all;
+    for (QJsonValue const connection : model.save()["connections"].toArray()) {
+        all.insert(QtNodes::fromJson(connection.toObject()));
+    }
+
+    std::size_t portEntries = 0;
+
+    for (NodeId const nodeId : model.allNodeIds()) {
+        for (ConnectionId const &connectionId : model.allConnectionIds(nodeId)) {
+            CHECK(all.count(connectionId) == 1);
+            CHECK((connectionId.outNodeId == nodeId || connectionId.inNodeId == nodeId));
+        }
+
+        for (PortType const portType : {PortType::In, PortType::Out}) {
+            auto const countRole = (portType == PortType::In) ? NodeRole::InPortCount
+                                                              : NodeRole::OutPortCount;
+            unsigned int const portCount = model.nodeData(nodeId, countRole).toUInt();
+
+            // Ports past the end must not keep stale entries either.
+            for (PortIndex portIndex = 0; portIndex < portCount + 2; ++portIndex) {
+                for (ConnectionId const &connectionId :
+                     model.connections(nodeId, portType, portIndex)) {
+                    CHECK(all.count(connectionId) == 1);
+                    CHECK(QtNodes::getNodeId(portType, connectionId) == nodeId);
+                    CHECK(QtNodes::getPortIndex(portType, connectionId) == portIndex);
+                    ++portEntries;
+                }
+            }
+        }
+    }
+
+    // Every connection is found from both of its ends.
+    for (ConnectionId const &connectionId : all) {
+        CHECK(model.allConnectionIds(connectionId.outNodeId).count(connectionId) == 1);
+        CHECK(model.allConnectionIds(connectionId.inNodeId).count(connectionId) == 1);
+        CHECK(model.connectionExists(connectionId));
+    }
+
+    CHECK(portEntries == 2 * all.size());
+}
+
+} // namespace
+
+TEST_CASE("Node slot array", "[storage]")
+{
+    NodeSlotArray<int> slots;
+
+    for (NodeId id = 0; id < 10; ++id) {
+        slots.insert(id, static_cast<int>(id) * 10);
+    }
+
+    CHECK(slots.size() == 10);
+    REQUIRE(slots.find(7) != nullptr);
+    CHECK(*slots.find(7) == 70);
+    CHECK(slots.find(10) == nullptr);
+
+    SECTION("Erasing moves the last value into the freed slot")
+    {
+        CHECK(slots.erase(3));
+        CHECK_FALSE(slots.erase(3));
+
+        CHECK(slots.size() == 9);
+        CHECK(slots.find(3) == nullptr);
+        REQUIRE(slots.find(9) != nullptr);
+        CHECK(*slots.find(9) == 90);
+
+        std::set<NodeId> ids(slots.ids().begin(), slots.ids().end());
+        CHECK(ids == std::set<NodeId>{0, 1, 2, 4, 5, 6, 7, 8, 9});
+    }
+
+    SECTION("Inserting an existing id replaces its value")
+    {
+        slots.insert(4, -1);
+
+        CHECK(slots.size() == 10);
+        CHECK(*slots.find(4) == -1);
+    }
+
+    SECTION("Ids far beyond the node count")
+    {
+        NodeId const farId = 4000000000u;
+
+        slots.insert(farId, 1);
+        slots.insert(5000, 2);
+
+        CHECK(*slots.find(farId) == 1);
+        CHECK(*slots.find(5000) == 2);
+
+        slots.erase(0);
+
+        CHECK(*slots.find(farId) == 1);
+        CHECK(*slots.find(5000) == 2);
+
+        slots.erase(farId);
+
+        CHECK(slots.find(farId) == nullptr);
+        CHECK(slots.size() == 10);
+    }
+}
+
+TEST_CASE("DataFlowGraphModel node storage", "[storage]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> const nodeIds = addNodes(model, 5);
+
+    NodeId const resizable = model.addNode("Resizable");
+
+    CHECK(model.nodeData(resizable, NodeRole::Type).toString() == "Resizable");
+    CHECK(model.nodeData(nodeIds[0], NodeRole::Type).toString() == "Plain");
+    CHECK(model.nodeFlags(resizable).testFlag(NodeFlag::Resizable));
+    CHECK_FALSE(model.nodeFlags(nodeIds[0]).testFlag(NodeFlag::Resizable));
+
+    // Flags follow the delegate after the node is inserted.
+    model.delegateModel<ResizableModel>(resizable)->isResizable = false;
+
+    CHECK_FALSE(model.nodeFlags(resizable).testFlag(NodeFlag::Resizable));
+
+    model.deleteNode(nodeIds[1]);
+
+    CHECK_FALSE(model.nodeExists(nodeIds[1]));
+    CHECK(model.allNodeIds().size() == 5);
+    CHECK(model.nodeData(nodeIds[4], NodeRole::Position).value<QPointF>() == QPointF(4, -4));
+
+    // Unknown ids are neither reported nor stored.
+    CHECK_FALSE(model.nodeData(nodeIds[1], NodeRole::Position).isValid());
+    CHECK_FALSE(model.setNodeData(nodeIds[1], NodeRole::Position, QPointF(1, 1)));
+    CHECK_FALSE(model.nodeExists(nodeIds[1]));
+}
+
+TEST_CASE("Connection index follows the connectivity", "[storage]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+
+    NodeId const a = model.addNode("DynamicPorts");
+    NodeId const b = model.addNode("DynamicPorts");
+    NodeId const c = model.addNode("DynamicPorts");
+
+    model.addConnection(ConnectionId{a, 0, b, 0});
+    model.addConnection(ConnectionId{a, 1, b, 2});
+    model.addConnection(ConnectionId{b, 0, c, 1});
+    model.addConnection(ConnectionId{a, 2, c, 2});
+
+    checkConnectionIndex(model);
+    CHECK(model.allConnectionIds(b).size() == 3);
+    CHECK(model.connectionCount(a, PortType::Out, 1) == 1);
+
+    SECTION("Deleting a connection")
+    {
+        REQUIRE(model.deleteConnection(ConnectionId{a, 0, b, 0}));
+
+        checkConnectionIndex(model);
+        CHECK(model.connections(b, PortType::In, 0).empty());
+        CHECK(model.connections(a, PortType::Out, 0).empty());
+        CHECK(model.allConnectionIds(b).size() == 2);
+    }
+
+    SECTION("Deleting a node")
+    {
+        REQUIRE(model.deleteNode(b));
+
+        checkConnectionIndex(model);
+        CHECK(model.allConnectionIds(b).empty());
+        CHECK(model.allConnectionIds(a)
+              == std::unordered_set<ConnectionId>{ConnectionId{a, 2, c, 2}});
+        CHECK(model.connections(c, PortType::In, 1).empty());
+    }
+
+    SECTION("Inserting a port shifts the connections after it")
+    {
+        model.delegateModel<DynamicPortsModel>(b)->insertInPort(0);
+
+        checkConnectionIndex(model);
+        CHECK(model.connections(b, PortType::In, 0).empty());
+        CHECK(model.connectionExists(ConnectionId{a, 0, b, 1}));
+        CHECK(model.connectionExists(ConnectionId{a, 1, b, 3}));
+        CHECK_FALSE(model.connectionExists(ConnectionId{a, 1, b, 2}));
+    }
+
+    SECTION("Deleting a port drops its connections and shifts the others")
+    {
+        model.delegateModel<DynamicPortsModel>(b)->removeInPort(0);
+
+        checkConnectionIndex(model);
+        CHECK_FALSE(model.connectionExists(ConnectionId{a, 0, b, 0}));
+        CHECK(model.connectionExists(ConnectionId{a, 1, b, 1}));
+        CHECK(model.connections(b, PortType::In, 2).empty());
+        CHECK(model.allConnectionIds(a).size() == 2);
+    }
+}
+
+TEST_CASE("Node lookups and iteration", "[.benchmark]")
+{
+    auto setup = applicationSetup();
+
+    int const count = 10000;
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> nodeIds = addNodes(model, count);
+
+    std::shuffle(nodeIds.begin(), nodeIds.end(), std::mt19937(42));
+
+    BENCHMARK("nodeData(Position), 10k nodes")
+    {
+        QPointF sum;
+        for (NodeId const nodeId : nodeIds) {
+            sum += model.nodeData<QPointF>(nodeId, NodeRole::Position);
+        }
+        return sum;
+    };
+
+    BENCHMARK("nodeFlags, 10k nodes")
+    {
+        int resizable = 0;
+        for (NodeId const nodeId : nodeIds) {
+            resizable += model.nodeFlags(nodeId).testFlag(NodeFlag::Resizable);
+        }
+        return resizable;
+    };
+
+    BENCHMARK("forEachNode, 10k nodes")
+    {
+        NodeId sum = 0;
+        model.forEachNode([&sum](NodeId const nodeId) { sum += nodeId; });
+        return sum;
+    };
+
+    NodeSlotArray<QPointF> slots;
+    std::unordered_map<NodeId, QPointF> map;
+
+    for (NodeId const nodeId : nodeIds) {
+        slots.insert(nodeId, QPointF(nodeId, nodeId));
+        map[nodeId] = QPointF(nodeId, nodeId);
+    }
+
+    BENCHMARK("NodeSlotArray::find, 10k ids")
+    {
+        QPointF sum;
+        for (NodeId const nodeId : nodeIds) {
+            sum += *slots.find(nodeId);
+        }
+        return sum;
+    };
+
+    BENCHMARK("std::unordered_map::find, 10k ids")
+    {
+        QPointF sum;
+        for (NodeId const nodeId : nodeIds) {
+            sum += map.find(nodeId)->second;
+        }
+        return sum;
+    };
+
+    BENCHMARK("NodeSlotArray iteration, 10k values")
+    {
+        QPointF sum;
+        for (QPointF const &pos : slots.values()) {
+            sum += pos;
+        }
+        return sum;
+    };
+
+    BENCHMARK("std::unordered_map iteration, 10k values")
+    {
+        QPointF sum;
+        for (auto const &p : map) {
+            sum += p.second;
+        }
+        return sum;
+    };
+}
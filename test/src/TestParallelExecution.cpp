@@ -0,0 +1,606 @@
+#include "ApplicationSetup.hpp"
+#include "TestModels.hpp"
+
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using QtNodes::CancellationToken;
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeId;
+using QtNodes::PortIndex;
+using QtNodes::PortRole;
+using QtNodes::PortType;
+
+namespace {
+
+class ValueData : public NodeData
+{
+public:
+    explicit ValueData(double value = 0.0)
+        : _value(value)
+    {}
+
+    NodeDataType type() const override { return NodeDataType{"value", "Value"}; }
+
+    double value() const { return _value; }
+
+private:
+    double _value;
+};
+
+/// Every value has the same hash, only `sameContent()` tells them apart.
+class CollidingData : public ValueData
+{
+public:
+    using ValueData::ValueData;
+
+    std::size_t contentHash() const override { return 1; }
+
+    bool sameContent(NodeData const &other) const override
+    {
+        auto data = dynamic_cast<CollidingData const *>(&other);
+        return data && data->value() == value();
+    }
+};
+
+class BenchModel : public StubDelegateModel
+{
+public:
+    NodeDataType dataType(PortType, PortIndex) const override { return ValueData().type(); }
+};
+
+class SourceModel : public BenchModel
+{
+public:
+    QString caption() const override { return "Source"; }
+
+    QString name() const override { return "Source"; }
+
+    unsigned int nPorts(PortType portType) const override
+    {
+        return (portType == PortType::Out) ? 1 : 0;
+    }
+
+    void setInData(std::shared_ptr<NodeData>, PortIndex, bool) override {}
+
+    std::shared_ptr<NodeData> outData(PortIndex) override { return _data; }
+
+    void trigger(double value)
+    {
+        _data = std::make_shared<ValueData>(value);
+        Q_EMIT dataUpdated(0, true);
+    }
+
+    void triggerColliding(double value)
+    {
+        _data = std::make_shared<CollidingData>(value);
+        Q_EMIT dataUpdated(0, true);
+    }
+
+private:
+    std::shared_ptr<ValueData> _data;
+};
+
+/// Burns a fixed amount of CPU on every evaluation.
+class HeavyModel : public BenchModel
+{
+public:
+    QString caption() const override { return "Heavy"; }
+
+    QString name() const override { return "Heavy"; }
+
+    bool computeIsThreadSafe() const override { return true; }
+
+    unsigned int nPorts(PortType) const override { return 1; }
+
+    void setInData(std::shared_ptr<NodeData> data, PortIndex, bool bContinueExec) override
+    {
+        auto input = std::dynamic_pointer_cast<ValueData>(data);
+
+        if (!bContinueExec || !input)
+            return;
+
+        double acc = input->value();
+        for (int i = 0; i < 200000; ++i) {
+            acc = std::sin(acc) + 1.0;
+        }
+
+        _result = std::make_shared<ValueData>(acc);
+
+        Q_EMIT dataUpdated(0, true);
+    }
+
+    std::shared_ptr<NodeData> outData(PortIndex) override { return _result; }
+
+private:
+    std::shared_ptr<ValueData> _result;
+};
+
+/// Collects all the branches, stays on the model thread.
+class SinkModel : public BenchModel
+{
+public:
+    explicit SinkModel(unsigned int width = 1)
+        : _width(width)
+    {}
+
+    QString caption() const override { return "Sink"; }
+
+    QString name() const override { return "Sink"; }
+
+    unsigned int nPorts(PortType portType) const override
+    {
+        return (portType == PortType::In) ? _width : 0;
+    }
+
+    void setInData(std::shared_ptr<NodeData>, PortIndex, bool bContinueExec) override
+    {
+        if (bContinueExec)
+            ++evaluations;
+    }
+
+    std::shared_ptr<NodeData> outData(PortIndex) override { return nullptr; }
+
+    int evaluations = 0;
+
+private:
+    unsigned int _width;
+};
+
+/// Forwards its input and runs `onEvaluate` first.
+class RelayModel : public BenchModel
+{
+public:
+    QString caption() const override { return "Relay"; }
+
+    QString name() const override { return "Relay"; }
+
+    unsigned int nPorts(PortType) const override { return 1; }
+
+    void setInData(std::shared_ptr<NodeData> data, PortIndex, bool bContinueExec) override
+    {
+        _data = data;
+
+        if (!bContinueExec)
+            return;
+
+        if (onEvaluate)
+            onEvaluate();
+
+        Q_EMIT dataUpdated(0, true);
+    }
+
+    std::shared_ptr<NodeData> outData(PortIndex) override { return _data; }
+
+    std::function<void()> onEvaluate;
+
+private:
+    std::shared_ptr<NodeData> _data;
+};
+
+/// Publishes its input after a delay unless cancelled in the meantime.
+class SlowAsyncModel : public BenchModel
+{
+public:
+    QString caption() const override { return "SlowAsync"; }
+
+    QString name() const override { return "SlowAsync"; }
+
+    unsigned int nPorts(PortType portType) const override
+    {
+        return (portType == PortType::In) ? 1 : 0;
+    }
+
+    void setInData(std::shared_ptr<NodeData> data, PortIndex, bool) override
+    {
+        _input = std::dynamic_pointer_cast<ValueData>(data);
+    }
+
+    std::shared_ptr<NodeData> outData(PortIndex) override { return nullptr; }
+
+    bool supportsAsyncCompute() const override { return true; }
+
+    ComputeJob computeAsync() override
+    {
+        if (!_input)
+            return ComputeJob();
+
+        double const value = _input->value();
+
+        return [this, value](CancellationToken const &token) -> ComputeResult {
+            for (int i = 0; i < 100 && !token.isCancelled(); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+
+            if (token.isCancelled())
+                return ComputeResult();
+
+            // Only touched on the model thread.
+            return [this, value]() {
+                published = value;
+                ++publishCount;
+            };
+        };
+    }
+
+    double published = 0.0;
+    int publishCount = 0;
+
+private:
+    std::shared_ptr<ValueData> _input;
+};
+
+/// source -> `width` independent heavy branches -> sink
+struct WideGraph
+{
+    explicit WideGraph(unsigned int width)
+        : model(makeRegistry(width))
+    {
+        NodeId const sourceId = model.addNode("Source");
+        NodeId const sinkId = model.addNode("Sink");
+
+        for (unsigned int i = 0; i < width; ++i) {
+            NodeId const heavyId = model.addNode("Heavy");
+
+            model.addConnection(ConnectionId{sourceId, 0, heavyId, 0});
+            model.addConnection(ConnectionId{heavyId, 0, sinkId, i});
+        }
+
+        source = model.delegateModel<SourceModel>(sourceId);
+        sink = model.delegateModel<SinkModel>(sinkId);
+    }
+
+    static std::shared_ptr<NodeDelegateModelRegistry> makeRegistry(unsigned int width)
+    {
+        auto registry = std::make_shared<NodeDelegateModelRegistry>();
+        registry->registerModel<SourceModel>("Bench");
+        registry->registerModel<HeavyModel>("Bench");
+        registry->registerModel<SinkModel>([width]() { return std::make_unique<SinkModel>(width); },
+                                           "Bench");
+        return registry;
+    }
+
+    /// Triggers the source and spins the event loop until the sink is reached.
+    void run()
+    {
+        int const expected = sink->evaluations + 1;
+
+        source->trigger(1.0);
+
+        while (sink->evaluations < expected) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    }
+
+    DataFlowGraphModel model;
+    SourceModel *source = nullptr;
+    SinkModel *sink = nullptr;
+};
+
+} // namespace
+
+TEST_CASE("Topological execution evaluates a diamond once", "[execution]")
+{
+    auto setup = applicationSetup();
+
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<SourceModel>("Test");
+    registry->registerModel<RelayModel>("Test");
+    registry->registerModel<SinkModel>([]() { return std::make_unique<SinkModel>(2); }, "Test");
+
+    DataFlowGraphModel model(registry);
+
+    CHECK(model.executionMode() == DataFlowGraphModel::ExecutionMode::Push);
+
+    // source -> left -> sink:0, source -> right -> sink:1
+    NodeId const sourceId = model.addNode("Source");
+    NodeId const leftId = model.addNode("Relay");
+    NodeId const rightId = model.addNode("Relay");
+    NodeId const sinkId = model.addNode("Sink");
+
+    model.addConnection(ConnectionId{sourceId, 0, leftId, 0});
+    model.addConnection(ConnectionId{sourceId, 0, rightId, 0});
+    model.addConnection(ConnectionId{leftId, 0, sinkId, 0});
+    model.addConnection(ConnectionId{rightId, 0, sinkId, 1});
+
+    auto sink = model.delegateModel<SinkModel>(sinkId);
+
+    int relaysDone = 0;
+    model.delegateModel<RelayModel>(leftId)->onEvaluate = [&]() { ++relaysDone; };
+    model.delegateModel<RelayModel>(rightId)->onEvaluate = [&]() { ++relaysDone; };
+
+    // Number of evaluated relays at each input the sink receives.
+    std::vector<int> relaysDoneAtSink;
+
+    QObject::connect(&model,
+                     &DataFlowGraphModel::inPortDataWasSet,
+                     [&](NodeId const nodeId, PortType, PortIndex) {
+                         if (nodeId == sinkId)
+                             relaysDoneAtSink.push_back(relaysDone);
+                     });
+
+    // Both modes deliver through the event loop.
+    auto runUntil = [&](int evaluations) {
+        QElapsedTimer timer;
+        timer.start();
+
+        while (sink->evaluations < evaluations && timer.elapsed() < 5000) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+        }
+
+        // Lets any redundant evaluation still queued show up.
+        QCoreApplication::processEvents();
+    };
+
+    SECTION("Push evaluates the sink once per updated input")
+    {
+        model.delegateModel<SourceModel>(sourceId)->trigger(1.0);
+        runUntil(2);
+
+        CHECK(relaysDone == 2);
+        CHECK(sink->evaluations == 2);
+    }
+
+    SECTION("Topological evaluates the sink once, after both inputs")
+    {
+        model.setExecutionMode(DataFlowGraphModel::ExecutionMode::Topological);
+
+        model.delegateModel<SourceModel>(sourceId)->trigger(1.0);
+        runUntil(1);
+
+        CHECK(relaysDone == 2);
+        CHECK(sink->evaluations == 1);
+
+        REQUIRE(relaysDoneAtSink.size() == 2);
+        CHECK(relaysDoneAtSink[0] == 2);
+        CHECK(relaysDoneAtSink[1] == 2);
+    }
+}
+
+TEST_CASE("Scheduled execution evaluates every node once", "[execution]")
+{
+    auto setup = applicationSetup();
+
+    auto mode = GENERATE(DataFlowGraphModel::ExecutionMode::Topological,
+                         DataFlowGraphModel::ExecutionMode::Parallel);
+
+    WideGraph graph(8);
+    graph.model.setExecutionMode(mode);
+    graph.model.setWorkerCount(4);
+
+    graph.run();
+    graph.run();
+
+    CHECK(graph.sink->evaluations == 2);
+}
+
+TEST_CASE("Deleting a node during a pass releases its downstream", "[execution]")
+{
+    auto setup = applicationSetup();
+
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<SourceModel>("Test");
+    registry->registerModel<RelayModel>("Test");
+    registry->registerModel<SinkModel>([]() { return std::make_unique<SinkModel>(2); }, "Test");
+
+    DataFlowGraphModel model(registry);
+    model.setExecutionMode(DataFlowGraphModel::ExecutionMode::Topological);
+
+    // source -> first -> second -> sink:0, source -> doomed -> sink:1
+    NodeId const sourceId = model.addNode("Source");
+    NodeId const firstId = model.addNode("Relay");
+    NodeId const secondId = model.addNode("Relay");
+    NodeId const doomedId = model.addNode("Relay");
+    NodeId const sinkId = model.addNode("Sink");
+
+    model.addConnection(ConnectionId{sourceId, 0, firstId, 0});
+    model.addConnection(ConnectionId{firstId, 0, secondId, 0});
+    model.addConnection(ConnectionId{secondId, 0, sinkId, 0});
+    model.addConnection(ConnectionId{sourceId, 0, doomedId, 0});
+    model.addConnection(ConnectionId{doomedId, 0, sinkId, 1});
+
+    auto sink = model.delegateModel<SinkModel>(sinkId);
+
+    bool secondDone = false;
+    bool sinkAfterSecond = false;
+
+    model.delegateModel<RelayModel>(firstId)->onEvaluate = [&]() {
+        if (model.nodeExists(doomedId))
+            model.deleteNode(doomedId);
+    };
+
+    model.delegateModel<RelayModel>(secondId)->onEvaluate = [&]() { secondDone = true; };
+
+    QObject::connect(&model,
+                     &DataFlowGraphModel::inPortDataWasSet,
+                     [&](NodeId const nodeId, PortType, PortIndex) {
+                         if (nodeId == sinkId)
+                             sinkAfterSecond = secondDone;
+                     });
+
+    model.delegateModel<SourceModel>(sourceId)->trigger(1.0);
+
+    while (sink->evaluations == 0) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+
+    CHECK_FALSE(model.nodeExists(doomedId));
+    CHECK(sink->evaluations == 1);
+    CHECK(sinkAfterSecond);
+}
+
+TEST_CASE("Superseded asynchronous results are discarded", "[execution]")
+{
+    auto setup = applicationSetup();
+
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<SourceModel>("Test");
+    registry->registerModel<SlowAsyncModel>("Test");
+
+    DataFlowGraphModel model(registry);
+
+    NodeId const sourceId = model.addNode("Source");
+    NodeId const slowId = model.addNode("SlowAsync");
+    model.addConnection(ConnectionId{sourceId, 0, slowId, 0});
+
+    auto source = model.delegateModel<SourceModel>(sourceId);
+    auto slow = model.delegateModel<SlowAsyncModel>(slowId);
+
+    // The second value reaches the node while the first run is in flight.
+    source->trigger(1.0);
+    source->trigger(2.0);
+
+    while (slow->publishCount == 0) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+
+    CHECK(slow->published == 2.0);
+    CHECK(slow->publishCount == 1);
+}
+
+TEST_CASE("Memoization confirms equal content hashes", "[execution]")
+{
+    auto setup = applicationSetup();
+
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<SourceModel>("Test");
+    registry->registerModel<SinkModel>("Test");
+
+    DataFlowGraphModel model(registry);
+    model.setMemoizationEnabled(true);
+
+    NodeId const sourceId = model.addNode("Source");
+    NodeId const sinkId = model.addNode("Sink");
+    model.addConnection(ConnectionId{sourceId, 0, sinkId, 0});
+
+    auto source = model.delegateModel<SourceModel>(sourceId);
+    auto sink = model.delegateModel<SinkModel>(sinkId);
+
+    source->triggerColliding(1.0);
+    QCoreApplication::processEvents();
+
+    CHECK(sink->evaluations == 1);
+
+    // Same content in a new instance.
+    source->triggerColliding(1.0);
+    QCoreApplication::processEvents();
+
+    CHECK(sink->evaluations == 1);
+
+    // Same hash, different content.
+    source->triggerColliding(2.0);
+    QCoreApplication::processEvents();
+
+    CHECK(sink->evaluations == 2);
+}
+
+TEST_CASE("Destroying the model cancels asynchronous runs", "[execution]")
+{
+    auto setup = applicationSetup();
+
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<SourceModel>("Test");
+    registry->registerModel<SlowAsyncModel>("Test");
+
+    auto model = std::make_unique<DataFlowGraphModel>(registry);
+
+    NodeId const sourceId = model->addNode("Source");
+    NodeId const slowId = model->addNode("SlowAsync");
+    model->addConnection(ConnectionId{sourceId, 0, slowId, 0});
+
+    model->delegateModel<SourceModel>(sourceId)->trigger(1.0);
+
+    // Delivers the input, which starts the run.
+    QCoreApplication::processEvents();
+
+    auto const start = std::chrono::steady_clock::now();
+
+    model.reset();
+
+    // An uncancelled run takes at least 200 ms.
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100));
+}
+
+TEST_CASE("Parallel execution scales on wide graphs", "[.benchmark]")
+{
+    auto setup = applicationSetup();
+
+    unsigned int const width = 64;
+
+    WideGraph graph(width);
+
+    graph.model.setExecutionMode(DataFlowGraphModel::ExecutionMode::Topological);
+
+    BENCHMARK("topological, 64 branches")
+    {
+        graph.run();
+    };
+
+    graph.model.setExecutionMode(DataFlowGraphModel::ExecutionMode::Parallel);
+
+    std::vector<std::size_t> workerCounts{1, 2, 4};
+    if (std::thread::hardware_concurrency() > 4)
+        workerCounts.push_back(std::thread::hardware_concurrency());
+
+    for (std::size_t const workers : workerCounts) {
+        graph.model.setWorkerCount(workers);
+
+        BENCHMARK("parallel, 64 branches, " + std::to_string(workers) + " workers")
+        {
+            graph.run();
+        };
+    }
+}
+
+TEST_CASE("Push propagation to many consumers", "[.benchmark]")
+{
+    auto setup = applicationSetup();
+
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<SourceModel>("Bench");
+    registry->registerModel<SinkModel>("Bench");
+
+    DataFlowGraphModel model(registry);
+
+    NodeId const sourceId = model.addNode("Source");
+
+    for (int i = 0; i < 1000; ++i) {
+        model.addConnection(ConnectionId{sourceId, 0, model.addNode("Sink"), 0});
+    }
+
+    auto source = model.delegateModel<SourceModel>(sourceId);
+
+    BENCHMARK("direct delivery, 1000 consumers")
+    {
+        source->trigger(1.0);
+    };
+
+    BENCHMARK("role-based delivery, 1000 consumers")
+    {
+        for (ConnectionId const &cn : model.connections(sourceId, PortType::Out, 0)) {
+            model.setPortData(cn.inNodeId,
+                              PortType::In,
+                              cn.inPortIndex,
+                              model.portData(sourceId, PortType::Out, 0, PortRole::Data),
+                              PortRole::Data);
+        }
+    };
+}
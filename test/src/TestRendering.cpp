@@ -0,0 +1,681 @@
+#include "ApplicationSetup.hpp"
+#include "TestModels.hpp"
+
+#include <QtNodes/BasicGraphicsScene>
+#include <QtNodes/ConnectionStyle>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/IconCache>
+#include <QtNodes/NodeDelegateModelRegistry>
+#include <QtNodes/NodeStyle>
+#include <QtNodes/StyleCollection>
+
+#include "AbstractNodeGeometry.hpp"
+#include "AbstractNodePainter.hpp"
+#include "ConnectionGraphicsObject.hpp"
+#include "ConnectionPainter.hpp"
+#include "DefaultFlowControlNodePainter.hpp"
+#include "NodeGraphicsObject.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QImage>
+#include <QtGui/QPainter>
+#include <QtGui/QPixmapCache>
+
+#include <memory>
+#include <vector>
+
+using QtNodes::AbstractGraphModel;
+using QtNodes::AbstractNodeGeometry;
+using QtNodes::BasicGraphicsScene;
+using QtNodes::ConnectionGraphicsObject;
+using QtNodes::ConnectionId;
+using QtNodes::ConnectionPainter;
+using QtNodes::ConnectionStyle;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::IconCache;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeGraphicsObject;
+using QtNodes::NodeId;
+using QtNodes::NodeRenderInfo;
+using QtNodes::NodeRole;
+using QtNodes::NodeStyle;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+using QtNodes::SharedNodeData;
+using QtNodes::StyleCollection;
+
+namespace {
+
+class RenderModel : public StubDelegateModel
+{
+public:
+    QString name() const override { return "Render"; }
+
+    QString descriptions() const override { return "Benchmark node"; }
+
+    unsigned int nPorts(PortType portType) const override
+    {
+        return (portType == PortType::Out) ? _outPorts : 3;
+    }
+
+    NodeDataType dataType(PortType, PortIndex) const override
+    {
+        return NodeDataType{"value", "Value"};
+    }
+
+    void addOutPort()
+    {
+        Q_EMIT portsAboutToBeInserted(PortType::Out, _outPorts, _outPorts);
+        ++_outPorts;
+        Q_EMIT portsInserted();
+    }
+
+private:
+    unsigned int _outPorts = 3;
+};
+
+struct RenderScene
+{
+    explicit RenderScene(int count)
+        : model(makeRegistry())
+    {
+        for (int i = 0; i < count; ++i) {
+            NodeId const nodeId = model.addNode("Render");
+            model.setNodeData(nodeId, NodeRole::Position, QPointF((i % 50) * 250, (i / 50) * 200));
+            nodeIds.push_back(nodeId);
+        }
+
+        scene = std::make_unique<BasicGraphicsScene>(model);
+    }
+
+    static std::shared_ptr<NodeDelegateModelRegistry> makeRegistry()
+    {
+        auto registry = std::make_shared<NodeDelegateModelRegistry>();
+        registry->registerModel<RenderModel>("Test");
+        return registry;
+    }
+
+    /// Runs the node painter for every node, bypassing the item cache.
+    void paintAll(QPainter &painter)
+    {
+        for (NodeId const nodeId : nodeIds) {
+            scene->nodePainter().paint(&painter, *scene->nodeGraphicsObject(nodeId));
+        }
+    }
+
+    DataFlowGraphModel model;
+    std::unique_ptr<BasicGraphicsScene> scene;
+    std::vector<NodeId> nodeIds;
+};
+
+/// Color of the node body, painted at `scale` into an otherwise transparent image.
+template<typename Paint>
+QColor paintedBodyColor(NodeGraphicsObject &ngo, qreal scale, Paint paint)
+{
+    QImage image(512, 512, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.scale(scale, scale);
+
+    QSize const size = ngo.graphModel().nodeRenderInfo(ngo.nodeId()).size;
+    QPoint const center = painter.worldTransform()
+                              .map(QPointF(size.width() / 2.0, size.height() / 2.0))
+                              .toPoint();
+
+    paint(painter);
+    painter.end();
+
+    return image.pixelColor(center);
+}
+
+/// True if anything, or `color` when it is valid, was drawn within a pixel of `point`.
+bool paintedNear(QImage const &image, QPoint point, QColor const &color = QColor())
+{
+    for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+            QColor const pixel = image.pixelColor(point + QPoint(dx, dy));
+
+            if (color.isValid() ? pixel == color : pixel.alpha() != 0)
+                return true;
+        }
+    }
+    return false;
+}
+
+/// Integer output, floating point input, so its connections need a converter.
+class ConvertingModel : public StubDelegateModel
+{
+public:
+    static NodeDataType doubleType() { return NodeDataType{"double", "Double"}; }
+
+    QString name() const override { return "Converting"; }
+
+    NodeDataType dataType(PortType portType, PortIndex) const override
+    {
+        return (portType == PortType::Out) ? IntData::staticType() : doubleType();
+    }
+};
+
+/// Writes an empty square SVG icon of the given size.
+void writeIcon(QString const &path, int size)
+{
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::WriteOnly));
+
+    file.write(QString(R"(<svg xmlns="http://www.w3.org/2000/svg" width="%1" height="%1"/>)")
+                   .arg(size)
+                   .toUtf8());
+}
+
+} // namespace
+
+TEST_CASE("Node style handles are shared and versioned", "[rendering]")
+{
+    auto setup = applicationSetup();
+
+    RenderScene render(2);
+
+    auto first = render.model.nodeStyle(render.nodeIds[0]);
+    auto second = render.model.nodeStyle(render.nodeIds[1]);
+
+    CHECK(first == second);
+
+    auto const version = StyleCollection::nodeStyleVersion();
+
+    NodeStyle style = *first;
+    style.PenWidth = 4.0;
+    StyleCollection::setNodeStyle(style);
+
+    CHECK(StyleCollection::nodeStyleVersion() == version + 1);
+    CHECK(render.model.nodeStyle(render.nodeIds[0])->PenWidth == 4.0);
+
+    // Handles taken before the change are left untouched.
+    CHECK(first->PenWidth != 4.0);
+
+    StyleCollection::setNodeStyle(*first);
+}
+
+TEST_CASE("Render info matches the individual roles", "[rendering]")
+{
+    auto setup = applicationSetup();
+
+    RenderScene render(1);
+
+    NodeId const nodeId = render.nodeIds[0];
+
+    NodeRenderInfo const info = render.model.nodeRenderInfo(nodeId);
+    NodeRenderInfo const fromRoles = render.model.AbstractGraphModel::nodeRenderInfo(nodeId);
+
+    CHECK(info.caption == fromRoles.caption);
+    CHECK(info.captionVisible == fromRoles.captionVisible);
+    CHECK(info.description == fromRoles.description);
+    CHECK(info.size == fromRoles.size);
+    CHECK(info.paintType == fromRoles.paintType);
+
+    REQUIRE(info.inPorts.size() == 3);
+    REQUIRE(fromRoles.inPorts.size() == 3);
+    REQUIRE(info.outPorts.size() == fromRoles.outPorts.size());
+
+    for (std::size_t i = 0; i < info.inPorts.size(); ++i) {
+        CHECK(info.inPorts[i].dataType.id == fromRoles.inPorts[i].dataType.id);
+        CHECK(info.inPorts[i].label() == fromRoles.inPorts[i].label());
+    }
+}
+
+TEST_CASE("Node geometry follows port changes", "[rendering]")
+{
+    auto setup = applicationSetup();
+
+    RenderScene render(1);
+
+    NodeId const nodeId = render.nodeIds[0];
+
+    AbstractNodeGeometry &geometry = render.scene->nodeGeometry();
+
+    QSize const size = geometry.size(nodeId);
+    QPointF const lastPort = geometry.portPosition(nodeId, PortType::Out, 2);
+
+    CHECK(geometry.checkPortHit(nodeId, PortType::Out, lastPort) == 2);
+
+    render.model.delegateModel<RenderModel>(nodeId)->addOutPort();
+
+    QPointF const newPort = geometry.portPosition(nodeId, PortType::Out, 3);
+
+    CHECK(newPort.y() > lastPort.y());
+    CHECK(geometry.checkPortHit(nodeId, PortType::Out, newPort) == 3);
+    CHECK(geometry.size(nodeId).height() > size.height());
+}
+
+TEST_CASE("Connection geometry follows its end points", "[rendering]")
+{
+    auto setup = applicationSetup();
+
+    RenderScene render(2);
+
+    ConnectionId const connectionId{render.nodeIds[0], 0, render.nodeIds[1], 0};
+    render.model.addConnection(connectionId);
+
+    ConnectionGraphicsObject *cgo = render.scene->connectionGraphicsObject(connectionId);
+    REQUIRE(cgo != nullptr);
+
+    QPainterPath const before = cgo->path();
+
+    CHECK(cgo->path().currentPosition() == cgo->endPoint(PortType::In));
+    CHECK(cgo->boundingRect().contains(cgo->endPoint(PortType::Out)));
+
+    render.model.setNodeData(render.nodeIds[1], NodeRole::Position, QPointF(2000, 2000));
+
+    CHECK(cgo->path() != before);
+    CHECK(cgo->path().currentPosition() == cgo->endPoint(PortType::In));
+    CHECK(cgo->boundingRect().contains(cgo->endPoint(PortType::In)));
+    CHECK(cgo->shape().contains(cgo->path().pointAtPercent(0.5)));
+}
+
+TEST_CASE("Data type colors", "[rendering]")
+{
+    auto setup = applicationSetup();
+
+    ConnectionStyle style(R"(
+        { "ConnectionStyle": { "DataTypeColors": { "pinned": "#102030" } } }
+    )");
+
+    CHECK(style.normalColor("pinned") == QColor("#102030"));
+    CHECK(style.normalColor("derived") == style.normalColor("derived"));
+
+    int const index = style.dataTypeColorIndex("derived");
+
+    CHECK(style.dataTypeColorIndex("derived") == index);
+    CHECK(style.dataTypeColor(index) == style.normalColor("derived"));
+
+    style.setDataTypeColor("derived", Qt::red);
+
+    CHECK(style.dataTypeColor(index) == QColor(Qt::red));
+    CHECK(style.dataTypeColors().size() == 2);
+
+    ConnectionStyle restored(QString::fromUtf8(QJsonDocument(style.toJson()).toJson()));
+
+    CHECK(restored.normalColor("derived") == QColor(Qt::red));
+
+    SECTION("An invalid color unpins the type")
+    {
+        QColor const derived = ConnectionStyle().normalColor("derived");
+
+        style.setDataTypeColor("derived", QColor());
+
+        CHECK(style.dataTypeColor(index) == derived);
+        CHECK(style.normalColor("derived") == derived);
+        CHECK_FALSE(style.dataTypeColors().contains("derived"));
+        CHECK(style.dataTypeColors().size() == 1);
+    }
+
+    SECTION("Loading a style replaces the pinned colors")
+    {
+        style.loadJsonText(R"(
+            { "ConnectionStyle": { "DataTypeColors": { "other": "#405060" } } }
+        )");
+
+        CHECK(style.dataTypeColors().size() == 1);
+        CHECK(style.normalColor("other") == QColor("#405060"));
+        CHECK(style.normalColor("pinned") != QColor("#102030"));
+        CHECK(style.normalColor("derived") == ConnectionStyle().normalColor("derived"));
+    }
+}
+
+TEST_CASE("Level of detail thresholds", "[rendering]")
+{
+    auto setup = applicationSetup();
+
+    RenderScene render(2);
+
+    NodeGraphicsObject *ngo = render.scene->nodeGraphicsObject(render.nodeIds[0]);
+    REQUIRE(ngo != nullptr);
+
+    NodeStyle const original = StyleCollection::nodeStyle();
+
+    // Below TextLevelOfDetail, so only the body is drawn in full.
+    qreal const scale = 0.4;
+
+    auto withSimplifiedLevel = [&](float level) {
+        NodeStyle style = original;
+        style.GradientColor0 = Qt::blue;
+        style.GradientColor1 = Qt::blue;
+        style.GradientColor2 = Qt::red;
+        style.GradientColor3 = Qt::blue;
+        style.SimplifiedLevelOfDetail = level;
+        StyleCollection::setNodeStyle(style);
+    };
+
+    SECTION("Nodes")
+    {
+        auto paintNode = [&](QPainter &painter) {
+            render.scene->nodePainter().paint(&painter, *ngo);
+        };
+
+        withSimplifiedLevel(0.5f);
+        CHECK(paintedBodyColor(*ngo, scale, paintNode) == QColor(Qt::red));
+
+        withSimplifiedLevel(0.3f);
+        CHECK(paintedBodyColor(*ngo, scale, paintNode) != QColor(Qt::red));
+    }
+
+    SECTION("Flow control nodes take their fill from the node style")
+    {
+        auto paintNode = [&](QPainter &painter) {
+            render.scene->flowControlNodePainter().paint(&painter, *ngo);
+        };
+
+        withSimplifiedLevel(0.5f);
+        CHECK(paintedBodyColor(*ngo, scale, paintNode) == QColor(Qt::red));
+
+        withSimplifiedLevel(0.3f);
+        QColor const body = paintedBodyColor(*ngo, scale, paintNode);
+        CHECK(body != QColor(Qt::red));
+        CHECK(body.red() > 0);
+        CHECK(body.blue() > 0);
+    }
+
+    SECTION("Connections")
+    {
+        ConnectionStyle const originalConnections = StyleCollection::connectionStyle();
+
+        CHECK(ConnectionStyle("{}").simplifiedLevelOfDetail() == Approx(0.3));
+        CHECK(ConnectionStyle(R"({ "ConnectionStyle": { "SimplifiedLevelOfDetail": 0.6 } })")
+                  .simplifiedLevelOfDetail()
+              == Approx(0.6));
+
+        // Far enough apart vertically for the curve to leave the straight line.
+        render.model.setNodeData(render.nodeIds[1], NodeRole::Position, QPointF(600, 600));
+
+        ConnectionId const connectionId{render.nodeIds[0], 0, render.nodeIds[1], 0};
+        render.model.addConnection(connectionId);
+
+        ConnectionGraphicsObject *cgo = render.scene->connectionGraphicsObject(connectionId);
+        REQUIRE(cgo != nullptr);
+
+        QPointF const out = cgo->endPoint(PortType::Out);
+        QPointF const in = cgo->endPoint(PortType::In);
+        QPointF const onStraightLine = out + (in - out) * 0.25;
+
+        auto paintConnection = [&](char const *level) {
+            ConnectionStyle::setConnectionStyle(
+                QString(R"({ "ConnectionStyle": { "SimplifiedLevelOfDetail": %1 } })").arg(level));
+
+            QImage image(512, 512, QImage::Format_ARGB32_Premultiplied);
+            image.fill(Qt::transparent);
+
+            QPainter painter(&image);
+            painter.scale(scale, scale);
+            painter.translate(-cgo->boundingRect().topLeft());
+
+            QPoint const sample = painter.worldTransform().map(onStraightLine).toPoint();
+
+            ConnectionPainter::paint(&painter, *cgo);
+            painter.end();
+
+            return paintedNear(image, sample);
+        };
+
+        CHECK(paintConnection("0.5"));
+        CHECK_FALSE(paintConnection("0.3"));
+
+        StyleCollection::setConnectionStyle(originalConnections);
+    }
+
+    StyleCollection::setNodeStyle(original);
+}
+
+TEST_CASE("Connections with a converter are drawn in two halves", "[rendering]")
+{
+    auto setup = applicationSetup();
+
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<ConvertingModel>("Test");
+    registry->registerTypeConverter(IntData::staticType(),
+                                    ConvertingModel::doubleType(),
+                                    [](SharedNodeData data) { return data; });
+
+    DataFlowGraphModel model(registry);
+
+    NodeId const source = model.addNode("Converting");
+    NodeId const target = model.addNode("Converting");
+    model.setNodeData(target, NodeRole::Position, QPointF(600, 600));
+
+    ConnectionId const connectionId{source, 0, target, 0};
+    REQUIRE(model.connectionPossible(connectionId));
+
+    BasicGraphicsScene scene(model);
+    model.addConnection(connectionId);
+
+    ConnectionGraphicsObject *cgo = scene.connectionGraphicsObject(connectionId);
+    REQUIRE(cgo != nullptr);
+
+    ConnectionStyle const original = StyleCollection::connectionStyle();
+
+    ConnectionStyle::setConnectionStyle(R"(
+        { "ConnectionStyle": {
+            "UseDataDefinedColors": true,
+            "DataTypeColors": { "int": "#ff0000", "double": "#0000ff" }
+        } }
+    )");
+
+    // The repository ships no converter icon, so the test provides the cached one.
+    QPixmap icon(22, 22);
+    icon.fill(Qt::green);
+    QPixmapCache::insert(QStringLiteral("QtNodes/convert"), icon);
+
+    QPointF const out = cgo->endPoint(PortType::Out);
+    QPointF const in = cgo->endPoint(PortType::In);
+    auto const c1c2 = cgo->pointsC1C2();
+
+    auto pointAt = [&](qreal t) {
+        qreal const u = 1.0 - t;
+        return u * u * u * out + 3 * u * u * t * c1c2.first + 3 * u * t * t * c1c2.second
+               + t * t * t * in;
+    };
+
+    QImage image(512, 512, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.scale(0.5, 0.5);
+    painter.translate(-cgo->boundingRect().topLeft());
+
+    QTransform const transform = painter.worldTransform();
+
+    ConnectionPainter::paint(&painter, *cgo);
+    painter.end();
+
+    CHECK(paintedNear(image, transform.map(pointAt(0.2)).toPoint(), Qt::red));
+    CHECK(paintedNear(image, transform.map(pointAt(0.8)).toPoint(), Qt::blue));
+    CHECK(paintedNear(image, transform.map(pointAt(0.5)).toPoint(), Qt::green));
+
+    QPixmap cached;
+    REQUIRE(QPixmapCache::find(QStringLiteral("QtNodes/convert"), &cached));
+    CHECK(cached.cacheKey() == icon.cacheKey());
+
+    QPixmapCache::remove(QStringLiteral("QtNodes/convert"));
+    StyleCollection::setConnectionStyle(original);
+}
+
+TEST_CASE("Invalidating an icon spares unrelated icons", "[rendering]")
+{
+    auto setup = applicationSetup();
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+
+    QString const icon = dir.filePath("a.svg");
+    QString const variant = dir.filePath("a_hover.svg");
+    QString const other = dir.filePath("ab.svg");
+
+    for (QString const &path : {icon, variant, other}) {
+        writeIcon(path, 10);
+        CHECK(IconCache::pixmap(path).width() == 20);
+    }
+
+    for (QString const &path : {icon, variant, other}) {
+        writeIcon(path, 16);
+    }
+
+    IconCache::invalidate(icon);
+
+    CHECK(IconCache::pixmap(icon).width() == 32);
+    CHECK(IconCache::pixmap(variant).width() == 32);
+    CHECK(IconCache::pixmap(other).width() == 20);
+
+    IconCache::clear();
+}
+
+TEST_CASE("Painting many nodes", "[.benchmark]")
+{
+    auto setup = applicationSetup();
+
+    RenderScene render(1000);
+
+    QImage image(1024, 1024, QImage::Format_ARGB32_Premultiplied);
+
+    BENCHMARK("style through the Json role, 1000 nodes")
+    {
+        float width = 0.0f;
+        for (NodeId const nodeId : render.nodeIds) {
+            QJsonDocument json = QJsonDocument::fromVariant(
+                render.model.nodeData(nodeId, NodeRole::Style));
+            width += NodeStyle(json.object()).PenWidth;
+        }
+        return width;
+    };
+
+    BENCHMARK("style handle, 1000 nodes")
+    {
+        float width = 0.0f;
+        for (NodeId const nodeId : render.nodeIds) {
+            width += render.model.nodeStyle(nodeId)->PenWidth;
+        }
+        return width;
+    };
+
+    BENCHMARK("node data through the roles, 1000 nodes")
+    {
+        std::size_t ports = 0;
+        for (NodeId const nodeId : render.nodeIds) {
+            ports += render.model.AbstractGraphModel::nodeRenderInfo(nodeId).inPorts.size();
+        }
+        return ports;
+    };
+
+    BENCHMARK("node data through nodeRenderInfo, 1000 nodes")
+    {
+        std::size_t ports = 0;
+        for (NodeId const nodeId : render.nodeIds) {
+            ports += render.model.nodeRenderInfo(nodeId).inPorts.size();
+        }
+        return ports;
+    };
+
+    BENCHMARK("ConnectionStyle::normalColor, 1000 lookups")
+    {
+        auto const &connectionStyle = StyleCollection::connectionStyle();
+        int hue = 0;
+        for (int i = 0; i < 1000; ++i) {
+            hue += connectionStyle.normalColor(QStringLiteral("value")).hue();
+        }
+        return hue;
+    };
+
+    BENCHMARK("DefaultNodePainter::paint, 1000 nodes")
+    {
+        QPainter painter(&image);
+        render.paintAll(painter);
+    };
+}
+
+TEST_CASE("Port geometry of many nodes", "[.benchmark]")
+{
+    auto setup = applicationSetup();
+
+    RenderScene render(1000);
+
+    for (std::size_t i = 1; i < render.nodeIds.size(); ++i) {
+        render.model.addConnection(ConnectionId{render.nodeIds[i - 1], 0, render.nodeIds[i], 0});
+    }
+
+    AbstractNodeGeometry &geometry = render.scene->nodeGeometry();
+
+    auto hitAllPorts = [&]() {
+        int hits = 0;
+        for (NodeId const nodeId : render.nodeIds) {
+            for (PortType portType : {PortType::In, PortType::Out}) {
+                QPointF const p = geometry.portPosition(nodeId, portType, 1);
+                hits += (geometry.checkPortHit(nodeId, portType, p) == 1);
+            }
+        }
+        return hits;
+    };
+
+    BENCHMARK("checkPortHit, 1000 nodes, layouts recomputed")
+    {
+        geometry.invalidateAll();
+        return hitAllPorts();
+    };
+
+    BENCHMARK("checkPortHit, 1000 nodes, cached layouts")
+    {
+        return hitAllPorts();
+    };
+
+    BENCHMARK("moveConnections, 1000 nodes, layouts recomputed")
+    {
+        geometry.invalidateAll();
+        for (NodeId const nodeId : render.nodeIds) {
+            render.scene->nodeGraphicsObject(nodeId)->moveConnections();
+        }
+    };
+
+    BENCHMARK("moveConnections, 1000 nodes, cached layouts")
+    {
+        for (NodeId const nodeId : render.nodeIds) {
+            render.scene->nodeGraphicsObject(nodeId)->moveConnections();
+        }
+    };
+}
+
+TEST_CASE("Hit-testing many connections", "[.benchmark]")
+{
+    auto setup = applicationSetup();
+
+    RenderScene render(1000);
+
+    std::vector<ConnectionGraphicsObject *> connections;
+
+    for (std::size_t i = 1; i < render.nodeIds.size(); ++i) {
+        ConnectionId const connectionId{render.nodeIds[i - 1], 0, render.nodeIds[i], 0};
+        render.model.addConnection(connectionId);
+        connections.push_back(render.scene->connectionGraphicsObject(connectionId));
+    }
+
+    BENCHMARK("ConnectionGraphicsObject::shape, 999 connections")
+    {
+        int hits = 0;
+        for (ConnectionGraphicsObject *cgo : connections) {
+            hits += cgo->shape().contains(cgo->path().pointAtPercent(0.5));
+        }
+        return hits;
+    };
+
+    BENCHMARK("ConnectionGraphicsObject::boundingRect, 999 connections")
+    {
+        qreal area = 0.0;
+        for (ConnectionGraphicsObject *cgo : connections) {
+            QRectF const rect = cgo->boundingRect();
+            area += rect.width() * rect.height();
+        }
+        return area;
+    };
+}
@@ -0,0 +1,293 @@
+#include "ApplicationSetup.hpp"
+#include "TestModels.hpp"
+
+#include "ConnectionGraphicsObject.hpp"
+#include "NodeGraphicsObject.hpp"
+#include "SpatialGridIndex.hpp"
+#include "locateNode.hpp"
+
+#include <QtNodes/BasicGraphicsScene>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+
+#include <catch2/catch.hpp>
+
+#include <QtGui/QPainterPath>
+#include <QtGui/QTransform>
+#include <QtTest/QSignalSpy>
+
+#include <cmath>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+using QtNodes::BasicGraphicsScene;
+using QtNodes::ConnectionGraphicsObject;
+using QtNodes::ConnectionId;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeGraphicsObject;
+using QtNodes::NodeId;
+using QtNodes::NodeRole;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+using QtNodes::SpatialGridIndex;
+using QtNodes::locateNodeAt;
+
+namespace {
+
+std::shared_ptr<NodeDelegateModelRegistry> registerModels()
+{
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<PlainModel>("Test");
+    return registry;
+}
+
+qreal const Spacing = 400.0;
+
+/// Places `count` nodes on a square grid, `Spacing` units apart.
+std::vector<NodeId> addGridOfNodes(DataFlowGraphModel &model, int count)
+{
+    std::vector<NodeId> nodeIds;
+
+    int const columns = static_cast<int>(std::ceil(std::sqrt(count)));
+
+    for (int i = 0; i < count; ++i) {
+        NodeId const nodeId = model.addNode("Plain");
+
+        QPointF const pos((i % columns) * Spacing, (i / columns) * Spacing);
+        model.setNodeData(nodeId, NodeRole::Position, pos);
+
+        nodeIds.push_back(nodeId);
+    }
+
+    return nodeIds;
+}
+
+} // namespace
+
+TEST_CASE("Spatial grid index", "[spatial]")
+{
+    SpatialGridIndex<int> index(100.0);
+
+    index.insert(1, QRectF(10, 10, 50, 50));
+    index.insert(2, QRectF(90, 90, 150, 20)); // spans several cells
+    index.insert(3, QRectF(-120, -30, 40, 40));
+
+    auto keysAt = [&](QPointF const &point) {
+        std::set<int> keys;
+        index.forEachAt(point, [&](int key, QRectF const &) { keys.insert(key); });
+        return keys;
+    };
+
+    auto keysIn = [&](QRectF const &area) {
+        std::multiset<int> keys;
+        index.forEachIn(area, [&](int key, QRectF const &) { keys.insert(key); });
+        return keys;
+    };
+
+    CHECK(keysAt(QPointF(20, 20)) == std::set<int>{1});
+    CHECK(keysAt(QPointF(200, 100)) == std::set<int>{2});
+    CHECK(keysAt(QPointF(-100, -10)) == std::set<int>{3});
+    CHECK(keysAt(QPointF(500, 500)).empty());
+
+    // Every key is reported once even when it spans several cells.
+    CHECK(keysIn(QRectF(-200, -200, 600, 600)) == std::multiset<int>{1, 2, 3});
+
+    SECTION("Moving and removing keys")
+    {
+        index.insert(1, QRectF(1000, 1000, 10, 10));
+
+        CHECK(keysAt(QPointF(20, 20)).empty());
+        CHECK(keysAt(QPointF(1005, 1005)) == std::set<int>{1});
+
+        index.remove(2);
+
+        CHECK(keysAt(QPointF(200, 100)).empty());
+        CHECK(index.size() == 2);
+    }
+}
+
+TEST_CASE("Nodes are located through the spatial index", "[spatial]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> const nodeIds = addGridOfNodes(model, 16);
+
+    BasicGraphicsScene scene(model);
+
+    NodeGraphicsObject *ngo = scene.nodeGraphicsObject(nodeIds[5]);
+    REQUIRE(ngo != nullptr);
+
+    QPointF const center = ngo->sceneBoundingRect().center();
+
+    CHECK(scene.nodeAt(center) == ngo);
+    CHECK(scene.nodeAt(center + QPointF(Spacing / 2, Spacing / 2)) == nullptr);
+
+    SECTION("Position updates move the index entry")
+    {
+        QPointF const offset(-5000, -5000);
+        QPointF const pos = model.nodeData(nodeIds[5], NodeRole::Position).value<QPointF>();
+
+        model.setNodeData(nodeIds[5], NodeRole::Position, pos + offset);
+
+        CHECK(scene.nodeAt(center) == nullptr);
+        CHECK(scene.nodeAt(center + offset) == ngo);
+    }
+
+    SECTION("Deleted nodes are dropped")
+    {
+        model.deleteNode(nodeIds[5]);
+
+        CHECK(scene.nodeAt(center) == nullptr);
+    }
+}
+
+TEST_CASE("Connections are located through the spatial index", "[spatial]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> const nodeIds = addGridOfNodes(model, 16);
+
+    ConnectionId const connectionId{nodeIds[0], 0, nodeIds[1], 0};
+    model.addConnection(connectionId);
+
+    BasicGraphicsScene scene(model);
+
+    ConnectionGraphicsObject *cgo = scene.connectionGraphicsObject(connectionId);
+    REQUIRE(cgo != nullptr);
+
+    auto midPoint = [&] { return cgo->mapToScene(cgo->path().pointAtPercent(0.5)); };
+
+    QPointF const middle = midPoint();
+
+    CHECK(scene.connectionAt(middle) == cgo);
+    CHECK(scene.connectionAt(middle + QPointF(0, Spacing / 2)) == nullptr);
+    CHECK(scene.connectionsIn(QRectF(middle - QPointF(1, 1), QSizeF(2, 2)))
+          == std::vector<ConnectionGraphicsObject *>{cgo});
+
+    SECTION("Moving a node moves the attached connection")
+    {
+        QPointF const offset(0, 5000);
+        QPointF const pos = model.nodeData(nodeIds[1], NodeRole::Position).value<QPointF>();
+
+        model.setNodeData(nodeIds[1], NodeRole::Position, pos + offset);
+
+        CHECK(scene.connectionAt(middle) != cgo);
+        CHECK(scene.connectionAt(midPoint()) == cgo);
+    }
+
+    SECTION("Deleted connections are dropped")
+    {
+        model.deleteConnection(connectionId);
+
+        CHECK(scene.connectionAt(middle) == nullptr);
+    }
+}
+
+TEST_CASE("Rubber band selection goes through the spatial index", "[spatial]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> const nodeIds = addGridOfNodes(model, 16);
+
+    ConnectionId const connectionId{nodeIds[0], 0, nodeIds[1], 0};
+    model.addConnection(connectionId);
+
+    BasicGraphicsScene scene(model);
+
+    NodeGraphicsObject *first = scene.nodeGraphicsObject(nodeIds[0]);
+    NodeGraphicsObject *second = scene.nodeGraphicsObject(nodeIds[1]);
+    NodeGraphicsObject *distant = scene.nodeGraphicsObject(nodeIds[15]);
+    ConnectionGraphicsObject *cgo = scene.connectionGraphicsObject(connectionId);
+
+    auto areaAround = [](QRectF const &rect) {
+        QPainterPath area;
+        area.addRect(rect);
+        return area;
+    };
+
+    QSignalSpy selectionSpy(&scene, &BasicGraphicsScene::selectionChanged);
+
+    scene.selectItemsIn(
+        areaAround(first->sceneBoundingRect().united(second->sceneBoundingRect())));
+
+    CHECK(first->isSelected());
+    CHECK(second->isSelected());
+    CHECK(cgo->isSelected());
+    CHECK_FALSE(distant->isSelected());
+    CHECK(selectionSpy.count() == 1);
+
+    SECTION("A new band replaces the selection")
+    {
+        scene.selectItemsIn(areaAround(distant->sceneBoundingRect()));
+
+        CHECK_FALSE(first->isSelected());
+        CHECK_FALSE(cgo->isSelected());
+        CHECK(distant->isSelected());
+        CHECK(selectionSpy.count() == 2);
+    }
+
+    SECTION("Adding to the selection keeps the selected items")
+    {
+        scene.selectItemsIn(areaAround(distant->sceneBoundingRect()), Qt::AddToSelection);
+
+        CHECK(first->isSelected());
+        CHECK(cgo->isSelected());
+        CHECK(distant->isSelected());
+    }
+
+    SECTION("An unchanged selection emits nothing")
+    {
+        scene.selectItemsIn(
+            areaAround(first->sceneBoundingRect().united(second->sceneBoundingRect())));
+
+        CHECK(selectionSpy.count() == 1);
+    }
+}
+
+TEST_CASE("Locating nodes in large scenes", "[.benchmark]")
+{
+    auto setup = applicationSetup();
+
+    int const count = 10000;
+
+    DataFlowGraphModel model(registerModels());
+    addGridOfNodes(model, count);
+
+    BasicGraphicsScene scene(model);
+
+    qreal const extent = std::sqrt(count) * Spacing;
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<qreal> coordinate(0.0, extent);
+
+    std::vector<QPointF> points;
+    for (int i = 0; i < 256; ++i) {
+        points.emplace_back(coordinate(generator), coordinate(generator));
+    }
+
+    BENCHMARK("locateNodeAt, 10k nodes, 256 lookups")
+    {
+        int found = 0;
+        for (QPointF const &point : points) {
+            found += (locateNodeAt(point, scene, QTransform()) != nullptr);
+        }
+        return found;
+    };
+
+    BENCHMARK("QGraphicsScene::items, 10k nodes, 256 lookups")
+    {
+        int found = 0;
+        for (QPointF const &point : points) {
+            found += scene.items(point, Qt::IntersectsItemShape, Qt::DescendingOrder).size();
+        }
+        return found;
+    };
+}
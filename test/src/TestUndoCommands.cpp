@@ -0,0 +1,436 @@
+#include "ApplicationSetup.hpp"
+#include "TestModels.hpp"
+
+#include <QtNodes/BasicGraphicsScene>
+#include <QtNodes/DataFlowGraphModel>
+#include <QtNodes/NodeDelegateModelRegistry>
+
+#include "NodeGraphicsObject.hpp"
+#include "UndoCommands.hpp"
+#include "UndoPayloadStore.hpp"
+
+#include <catch2/catch.hpp>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtWidgets/QUndoStack>
+
+#include <cstddef>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using QtNodes::BasicGraphicsScene;
+using QtNodes::ConnectionId;
+using QtNodes::CopyCommand;
+using QtNodes::DataFlowGraphModel;
+using QtNodes::DeleteCommand;
+using QtNodes::MoveNodeCommand;
+using QtNodes::NodeData;
+using QtNodes::NodeDataType;
+using QtNodes::NodeDelegateModel;
+using QtNodes::NodeDelegateModelRegistry;
+using QtNodes::NodeId;
+using QtNodes::NodeRole;
+using QtNodes::PasteCommand;
+using QtNodes::PortIndex;
+using QtNodes::PortType;
+using QtNodes::SceneUndoCommand;
+
+namespace {
+
+/// Saves a number only when it differs from the default one.
+class NumberModel : public StubDelegateModel
+{
+public:
+    QString name() const override { return "Number"; }
+
+    NodeDataType dataType(PortType, PortIndex) const override
+    {
+        return NodeDataType{"number", "Number"};
+    }
+
+    QJsonObject save() const override
+    {
+        QJsonObject modelJson = NodeDelegateModel::save();
+        if (number != 0)
+            modelJson["number"] = number;
+        return modelJson;
+    }
+
+    void load(QJsonObject const &p) override { number = p["number"].toInt(); }
+
+    int number = 0;
+};
+
+std::shared_ptr<NodeDelegateModelRegistry> registerModels()
+{
+    auto registry = std::make_shared<NodeDelegateModelRegistry>();
+    registry->registerModel<NumberModel>("Test");
+    return registry;
+}
+
+/// A chain of `count` nodes, every fourth one with a non-default number.
+std::vector<NodeId> addChainOfNodes(DataFlowGraphModel &model, int count)
+{
+    std::vector<NodeId> nodeIds;
+
+    for (int i = 0; i < count; ++i) {
+        NodeId const nodeId = model.addNode("Number");
+
+        model.setNodeData(nodeId, NodeRole::Position, QPointF(i * 200.0, 0.0));
+
+        if (i % 4 == 0)
+            model.delegateModel<NumberModel>(nodeId)->number = i % 3 + 1;
+
+        if (!nodeIds.empty())
+            model.addConnection(ConnectionId{nodeIds.back(), 0, nodeId, 0});
+
+        nodeIds.push_back(nodeId);
+    }
+
+    return nodeIds;
+}
+
+void selectNodes(BasicGraphicsScene &scene, std::vector<NodeId> const &nodeIds)
+{
+    for (NodeId const nodeId : nodeIds) {
+        scene.nodeGraphicsObject(nodeId)->setSelected(true);
+    }
+}
+
+} // namespace
+
+TEST_CASE("Deleting nodes can be undone", "[undo]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> const nodeIds = addChainOfNodes(model, 12);
+
+    BasicGraphicsScene scene(model);
+
+    QJsonObject const before = normalizedGraph(model.save());
+
+    // The middle of the chain, connected to the rest on both sides.
+    selectNodes(scene, std::vector<NodeId>(nodeIds.begin() + 2, nodeIds.begin() + 10));
+
+    scene.undoStack().push(new DeleteCommand(&scene));
+
+    CHECK(model.allNodeIds().size() == 4);
+    CHECK(model.allConnectionIds(nodeIds[1]).empty());
+
+    // Nodes with default settings share no payload, the others share one
+    // payload per distinct number.
+    CHECK(scene.undoPayloadStore()->payloadCount() == 2);
+
+    scene.undoStack().undo();
+
+    CHECK(normalizedGraph(model.save()) == before);
+
+    scene.undoStack().redo();
+
+    CHECK(model.allNodeIds().size() == 4);
+
+    SECTION("Payloads are released with the commands")
+    {
+        scene.undoStack().clear();
+
+        CHECK(scene.undoPayloadStore()->payloadCount() == 0);
+        CHECK(scene.undoPayloadStore()->payloadBytes() == 0);
+    }
+}
+
+TEST_CASE("Unreadable undo payloads are reported", "[undo]")
+{
+    using QtNodes::UndoPayloadStore;
+
+    auto setup = applicationSetup();
+
+    auto store = std::make_shared<UndoPayloadStore>();
+
+    QJsonObject json;
+    json["number"] = 3;
+
+    QJsonObject decoded;
+    CHECK(UndoPayloadStore::decode(UndoPayloadStore::encode(json), decoded));
+    CHECK(decoded == json);
+
+    SECTION("A payload missing from the spill file")
+    {
+        // Claims to be spilled although the store never created a spill file.
+        UndoPayloadStore::Payload const lost = std::make_shared<UndoPayloadStore::Entry const>(
+            UndoPayloadStore::Entry{0, 16, QByteArray(), 0});
+
+        QByteArray bytes("stale");
+        CHECK_FALSE(store->bytes(lost, bytes));
+        CHECK(bytes.isEmpty());
+    }
+
+    SECTION("Corrupt payload bytes")
+    {
+        CHECK_FALSE(UndoPayloadStore::decode(QByteArray("\xff\x00garbage", 9), decoded));
+        CHECK_FALSE(UndoPayloadStore::decode(QByteArray(), decoded));
+    }
+}
+
+TEST_CASE("Undo history memory budget", "[undo]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> const nodeIds = addChainOfNodes(model, 12);
+
+    BasicGraphicsScene scene(model);
+
+    QJsonObject const before = normalizedGraph(model.save());
+
+    auto const &store = scene.undoPayloadStore();
+
+    SECTION("Payloads are spilled before commands are dropped")
+    {
+        selectNodes(scene, nodeIds);
+        scene.undoStack().push(new DeleteCommand(&scene));
+
+        REQUIRE(store->residentBytes() > 0);
+
+        std::size_t const commandBytes = scene.undoMemoryUsage() - store->residentBytes();
+
+        scene.setUndoSpillEnabled(true);
+        scene.setUndoMemoryBudget(commandBytes);
+
+        CHECK(store->residentBytes() == 0);
+        CHECK(store->spilledBytes() > 0);
+        CHECK(scene.undoMemoryUsage() <= commandBytes);
+
+        scene.undoStack().undo();
+
+        CHECK(normalizedGraph(model.save()) == before);
+    }
+
+    auto deleteNodes = [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            scene.clearSelection();
+            selectNodes(scene, {nodeIds[i * 4]});
+            scene.undoStack().push(new DeleteCommand(&scene));
+        }
+    };
+
+    SECTION("The usage is kept up to date without walking the stack")
+    {
+        auto walkedUsage = [&]() {
+            std::size_t bytes = store->residentBytes();
+            for (int i = 0; i < scene.undoStack().count(); ++i) {
+                auto command = dynamic_cast<SceneUndoCommand const *>(
+                    scene.undoStack().command(i));
+                REQUIRE(command != nullptr);
+                bytes += command->memoryUsage();
+            }
+            return bytes;
+        };
+
+        deleteNodes(2);
+        CHECK(scene.undoMemoryUsage() == walkedUsage());
+
+        std::vector<NodeId> const moved{nodeIds[1], nodeIds[2]};
+
+        scene.undoStack().push(new MoveNodeCommand(&scene, moved, QPointF(1.0, 0.0)));
+        scene.undoStack().push(new MoveNodeCommand(&scene, moved, QPointF(1.0, 0.0)));
+        REQUIRE(scene.undoStack().count() == 3);
+        CHECK(scene.undoMemoryUsage() == walkedUsage());
+
+        scene.undoStack().undo();
+        scene.undoStack().undo();
+        CHECK(scene.undoMemoryUsage() == walkedUsage());
+
+        // Pushing drops the redo side.
+        scene.undoStack().push(new MoveNodeCommand(&scene, moved, QPointF(0.0, 1.0)));
+        REQUIRE(scene.undoStack().count() == 2);
+        CHECK(scene.undoMemoryUsage() == walkedUsage());
+
+        scene.undoStack().clear();
+        CHECK(scene.undoMemoryUsage() == store->residentBytes());
+    }
+
+    SECTION("The oldest commands are removed from the stack")
+    {
+        deleteNodes(3);
+
+        scene.undoStack().setClean();
+        scene.setUndoMemoryBudget(1);
+
+        REQUIRE(scene.undoStack().count() == 1);
+        CHECK(scene.undoStack().index() == 1);
+        CHECK(scene.undoStack().isClean());
+
+        // The payloads of the removed commands are released.
+        CHECK(store->payloadCount() == 1);
+
+        scene.undoStack().undo();
+
+        CHECK(model.nodeExists(nodeIds[8]));
+        CHECK_FALSE(model.nodeExists(nodeIds[4]));
+        CHECK_FALSE(scene.undoStack().canUndo());
+    }
+
+    SECTION("Undone commands stay on the redo side")
+    {
+        deleteNodes(3);
+
+        scene.undoStack().undo();
+        scene.setUndoMemoryBudget(1);
+
+        REQUIRE(scene.undoStack().count() == 2);
+        CHECK(scene.undoStack().index() == 1);
+        CHECK(model.nodeExists(nodeIds[8]));
+
+        scene.undoStack().redo();
+
+        CHECK_FALSE(model.nodeExists(nodeIds[8]));
+
+        scene.undoStack().undo();
+        scene.undoStack().undo();
+
+        CHECK(model.nodeExists(nodeIds[4]));
+        CHECK_FALSE(model.nodeExists(nodeIds[0]));
+    }
+}
+
+TEST_CASE("Pasting copied nodes can be undone", "[undo]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> const nodeIds = addChainOfNodes(model, 4);
+
+    BasicGraphicsScene scene(model);
+
+    selectNodes(scene, {nodeIds[0], nodeIds[1]});
+    CopyCommand copy(&scene);
+
+    auto pastedPositions = [&]() {
+        std::vector<QPointF> positions;
+        for (NodeId const nodeId : model.allNodeIds()) {
+            if (std::find(nodeIds.begin(), nodeIds.end(), nodeId) == nodeIds.end())
+                positions.push_back(model.nodeData(nodeId, NodeRole::Position).value<QPointF>());
+        }
+        std::sort(positions.begin(), positions.end(), [](QPointF const &a, QPointF const &b) {
+            return a.x() < b.x();
+        });
+        return positions;
+    };
+
+    std::vector<QPointF> const expected{QPointF(900.0, 500.0), QPointF(1100.0, 500.0)};
+
+    scene.undoStack().push(new MoveNodeCommand(&scene, {nodeIds[3]}, QPointF(0.0, 10.0)));
+
+    // The position is a temporary, the command keeps its own copy.
+    scene.undoStack().push(new PasteCommand(&scene, QPointF(1000.0, 500.0)));
+
+    CHECK(pastedPositions() == expected);
+
+    scene.undoStack().push(new MoveNodeCommand(&scene, {nodeIds[2]}, QPointF(0.0, 10.0)));
+    scene.undoStack().undo();
+
+    // Trimming the history moves the paste into a new command.
+    scene.setUndoMemoryBudget(1);
+
+    REQUIRE(scene.undoStack().count() == 2);
+    REQUIRE(scene.undoStack().index() == 1);
+
+    scene.undoStack().undo();
+
+    CHECK(pastedPositions().empty());
+
+    scene.undoStack().redo();
+
+    CHECK(pastedPositions() == expected);
+}
+
+TEST_CASE("Dragging nodes commits a single move", "[undo]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> const nodeIds = addChainOfNodes(model, 8);
+
+    BasicGraphicsScene scene(model);
+
+    int notifications = 0;
+    QObject::connect(&model,
+                     &DataFlowGraphModel::nodePositionsUpdated,
+                     [&](std::vector<NodeId> const &) { ++notifications; });
+
+    auto modelPos = [&](NodeId nodeId) {
+        return model.nodeData(nodeId, NodeRole::Position).value<QPointF>();
+    };
+
+    selectNodes(scene, {nodeIds[1], nodeIds[2], nodeIds[3]});
+
+    for (int i = 0; i < 10; ++i) {
+        scene.dragSelectedNodes(QPointF(5.0, -2.0));
+    }
+
+    // Only the items follow the drag.
+    CHECK(scene.nodeGraphicsObject(nodeIds[2])->pos() == QPointF(450.0, -20.0));
+    CHECK(modelPos(nodeIds[2]) == QPointF(400.0, 0.0));
+    CHECK(scene.undoStack().count() == 0);
+
+    scene.finishNodeDrag();
+
+    CHECK(scene.undoStack().count() == 1);
+    CHECK(notifications == 1);
+    CHECK(modelPos(nodeIds[2]) == QPointF(450.0, -20.0));
+    CHECK(modelPos(nodeIds[4]) == QPointF(800.0, 0.0));
+
+    scene.undoStack().undo();
+
+    CHECK(notifications == 2);
+    CHECK(modelPos(nodeIds[2]) == QPointF(400.0, 0.0));
+    CHECK(scene.nodeGraphicsObject(nodeIds[2])->pos() == QPointF(400.0, 0.0));
+}
+
+TEST_CASE("Dragging large selections", "[.benchmark]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> const nodeIds = addChainOfNodes(model, 2000);
+
+    BasicGraphicsScene scene(model);
+    selectNodes(scene, nodeIds);
+
+    BENCHMARK("drag 2k selected nodes, 50 moves")
+    {
+        for (int i = 0; i < 50; ++i) {
+            scene.dragSelectedNodes(QPointF(1.0, 1.0));
+        }
+
+        scene.finishNodeDrag();
+
+        return scene.undoStack().count();
+    };
+}
+
+TEST_CASE("Undoing large deletions", "[.benchmark]")
+{
+    auto setup = applicationSetup();
+
+    DataFlowGraphModel model(registerModels());
+    std::vector<NodeId> const nodeIds = addChainOfNodes(model, 5000);
+
+    BasicGraphicsScene scene(model);
+
+    BENCHMARK("delete and undo 5k nodes")
+    {
+        scene.undoStack().clear();
+        selectNodes(scene, nodeIds);
+
+        scene.undoStack().push(new DeleteCommand(&scene));
+        scene.undoStack().undo();
+
+        return model.allNodeIds().size();
+    };
+}